@@ -4,9 +4,11 @@
 #include "node3d.hpp"
 #include "array.hpp"
 #include "dictionary.hpp"
+#include "method_handle.hpp"
 #include "string.hpp"
 #include "syscalls_fwd.hpp"
 #include "timer.hpp"
+#include "variant_bytes.hpp"
 
 template <typename T>
 using remove_cvref = std::remove_cv_t<std::remove_reference_t<T>>;
@@ -3,6 +3,7 @@
 #include "syscalls.h"
 
 MAKE_SYSCALL(ECALL_ARRAY_OPS, void, sys_array_ops, Array_Op, unsigned, int, Variant *);
+MAKE_SYSCALL(ECALL_ARRAY_OPS, void, sys_array_ops_range, Array_Op, unsigned, int, const void *, size_t, size_t);
 MAKE_SYSCALL(ECALL_ARRAY_AT, void, sys_array_at, unsigned, int, Variant *);
 MAKE_SYSCALL(ECALL_ARRAY_SIZE, int, sys_array_size, unsigned);
 
@@ -72,3 +73,13 @@ std::vector<Variant> Array::to_vector() const {
 	sys_array_ops(Array_Op::FETCH_TO_VECTOR, m_idx, 0, (Variant *)&result);
 	return result;
 }
+
+std::vector<Variant> Array::fetch(int offset, size_t count, size_t stride) const {
+	std::vector<Variant> result;
+	sys_array_ops_range(Array_Op::FETCH_RANGE, m_idx, offset, &result, count, stride);
+	return result;
+}
+
+void Array::store(int offset, std::span<const Variant> values) {
+	sys_array_ops_range(Array_Op::STORE_RANGE, m_idx, offset, values.data(), values.size(), 1);
+}
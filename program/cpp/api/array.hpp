@@ -30,6 +30,10 @@ struct Array {
 	Variant at(int idx) const { return (*this)[idx]; }
 
 	std::vector<Variant> to_vector() const;
+	/// @brief Fetch up to count elements from offset, every stride elements, in one system call.
+	std::vector<Variant> fetch(int offset, size_t count, size_t stride = 1) const;
+	/// @brief Overwrite the elements from offset, in one system call. The range must be within the array.
+	void store(int offset, std::span<const Variant> values);
 
 	// Array size
 	int size() const;
@@ -0,0 +1,20 @@
+#pragma once
+#include <string_view>
+
+/**
+ * @brief A method or property name that is interned once, and then passed by its handle.
+ * String literals are already looked up by their address after the first use, so this is
+ * for names that are built at run-time, or that are passed from many places:
+ *   static const InternedName health("health");
+ *   obj.set(health, 100);
+ */
+struct InternedName {
+	/// @brief Intern a name. The same name always gets the same handle.
+	explicit InternedName(std::string_view name);
+
+	/// @brief Get the handle of the name.
+	unsigned handle() const noexcept { return m_handle; }
+
+private:
+	unsigned m_handle;
+};
@@ -0,0 +1,31 @@
+#include "method_handle.hpp"
+
+#include "syscalls.h"
+
+MAKE_SYSCALL(ECALL_METHOD_HANDLE, unsigned, sys_method_handle, int, const char *, size_t, const char *, size_t);
+MAKE_SYSCALL(ECALL_VMETHOD_CALL, void, sys_vmethod_call, unsigned, const Variant *, const Variant *, unsigned, Variant *);
+MAKE_SYSCALL(ECALL_OBJ_METHOD_CALL, void, sys_obj_method_call, unsigned, uint64_t, const Variant *, unsigned, Variant *);
+
+MethodHandle::MethodHandle(std::string_view class_name, std::string_view method) :
+		m_handle{ sys_method_handle(Variant::OBJECT, class_name.data(), class_name.size(), method.data(), method.size()) } {
+}
+
+MethodHandle::MethodHandle(Variant::Type type, std::string_view method) :
+		m_handle{ sys_method_handle(type, nullptr, 0, method.data(), method.size()) } {
+}
+
+Variant MethodHandle::callv(const Object &obj, const Variant *argv, unsigned argc) const {
+	Variant result;
+	sys_obj_method_call(m_handle, obj.address(), argv, argc, &result);
+	return result;
+}
+
+void MethodHandle::voidcallv(const Object &obj, const Variant *argv, unsigned argc) const {
+	sys_obj_method_call(m_handle, obj.address(), argv, argc, nullptr);
+}
+
+Variant MethodHandle::callv(const Variant &self, const Variant *argv, unsigned argc) const {
+	Variant result;
+	sys_vmethod_call(m_handle, &self, argv, argc, &result);
+	return result;
+}
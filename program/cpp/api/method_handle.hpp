@@ -0,0 +1,66 @@
+#pragma once
+#include "object.hpp"
+
+/**
+ * @brief A method that is resolved once by name, and then called many times by its handle.
+ * Methods that are called often, like the position, rotation and scale of nodes, and the
+ * math of vectors, are then called directly by the host, as long as the arguments have the
+ * exact types of the method. Other methods are called by name, like Object::call().
+ * Handles are best kept in static variables:
+ *   static MethodHandle set_position("Node2D", "set_position");
+ *   set_position.voidcall(node, Vector2(1, 2));
+ */
+struct MethodHandle {
+	/// @brief Resolve a method of a class, or of one of its base classes.
+	/// @param class_name The name of the class, e.g. "Node2D".
+	/// @param method The name of the method, e.g. "set_position".
+	MethodHandle(std::string_view class_name, std::string_view method);
+
+	/// @brief Resolve a method of a builtin type.
+	/// @param type The type that has the method, e.g. Variant::VECTOR2.
+	/// @param method The name of the method, e.g. "dot".
+	MethodHandle(Variant::Type type, std::string_view method);
+
+	/// @brief Call the method on an object.
+	Variant callv(const Object &obj, const Variant *argv, unsigned argc) const;
+	/// @brief Call the method on an object, without returning a value.
+	void voidcallv(const Object &obj, const Variant *argv, unsigned argc) const;
+	/// @brief Call the method on a Variant of the builtin type.
+	Variant callv(const Variant &self, const Variant *argv, unsigned argc) const;
+
+	template <typename... Args>
+	Variant call(const Object &obj, Args... args) const;
+	template <typename... Args>
+	void voidcall(const Object &obj, Args... args) const;
+	template <typename... Args>
+	Variant call(const Variant &self, Args... args) const;
+
+	template <typename... Args>
+	Variant operator () (const Object &obj, Args... args) const { return call(obj, args...); }
+	template <typename... Args>
+	Variant operator () (const Variant &self, Args... args) const { return call(self, args...); }
+
+	/// @brief Get the handle of the method. The same method always has the same handle.
+	unsigned handle() const noexcept { return m_handle; }
+
+private:
+	unsigned m_handle;
+};
+
+template <typename... Args>
+inline Variant MethodHandle::call(const Object &obj, Args... args) const {
+	Variant argv[] = {args...};
+	return callv(obj, argv, sizeof...(Args));
+}
+
+template <typename... Args>
+inline void MethodHandle::voidcall(const Object &obj, Args... args) const {
+	Variant argv[] = {args...};
+	voidcallv(obj, argv, sizeof...(Args));
+}
+
+template <typename... Args>
+inline Variant MethodHandle::call(const Variant &self, Args... args) const {
+	Variant argv[] = {args...};
+	return callv(self, argv, sizeof...(Args));
+}
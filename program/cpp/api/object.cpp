@@ -5,7 +5,9 @@
 
 MAKE_SYSCALL(ECALL_GET_OBJ, uint64_t, sys_get_obj, const char *, size_t);
 MAKE_SYSCALL(ECALL_OBJ, void, sys_obj, Object_Op, uint64_t, Variant *);
+MAKE_SYSCALL(ECALL_OBJ, void, sys_obj_named, Object_Op, uint64_t, Variant *, const char *, size_t);
 MAKE_SYSCALL(ECALL_OBJ_CALLP, void, sys_obj_callp, uint64_t, const char *, size_t, bool, Variant *, const Variant *, unsigned);
+MAKE_SYSCALL(ECALL_INTERN_NAME, unsigned, sys_intern_name, const char *, size_t);
 
 static_assert(sizeof(std::vector<std::string>) == 24, "std::vector<std::string> is not 24 bytes");
 static_assert(sizeof(std::string) == 32, "std::string is not 32 bytes");
@@ -20,18 +22,39 @@ std::vector<std::string> Object::get_method_list() const {
 	return methods;
 }
 
-Variant Object::get(const std::string &name) const {
-	Variant vars[2];
-	vars[0] = name;
-	sys_obj(Object_Op::GET, address(), vars);
-	return std::move(vars[1]);
+// Names are passed by address, so that string literals are looked up only once by the host
+Variant Object::get(std::string_view name) const {
+	Variant var;
+	sys_obj_named(Object_Op::GET_NAMED, address(), &var, name.data(), name.size());
+	return var;
 }
 
-void Object::set(const std::string &name, const Variant &value) {
-	Variant vars[2];
-	vars[0] = name;
-	vars[1] = value;
-	sys_obj(Object_Op::SET, address(), vars);
+Variant Object::get(const InternedName &name) const {
+	Variant var;
+	sys_obj_named(Object_Op::GET_NAMED, address(), &var, (const char *)uintptr_t(name.handle()), INTERNED_NAME_LENGTH);
+	return var;
+}
+
+void Object::set(std::string_view name, const Variant &value) {
+	sys_obj_named(Object_Op::SET_NAMED, address(), const_cast<Variant *>(&value), name.data(), name.size());
+}
+
+void Object::set(const InternedName &name, const Variant &value) {
+	sys_obj_named(Object_Op::SET_NAMED, address(), const_cast<Variant *>(&value), (const char *)uintptr_t(name.handle()), INTERNED_NAME_LENGTH);
+}
+
+Variant Object::callv(const InternedName &method, bool deferred, const Variant *argv, unsigned argc) {
+	Variant var;
+	sys_obj_callp(address(), (const char *)uintptr_t(method.handle()), INTERNED_NAME_LENGTH, deferred, &var, argv, argc);
+	return var;
+}
+
+void Object::voidcallv(const InternedName &method, bool deferred, const Variant *argv, unsigned argc) {
+	sys_obj_callp(address(), (const char *)uintptr_t(method.handle()), INTERNED_NAME_LENGTH, deferred, nullptr, argv, argc);
+}
+
+InternedName::InternedName(std::string_view name) :
+		m_handle{ sys_intern_name(name.data(), name.size()) } {
 }
 
 std::vector<std::string> Object::get_property_list() const {
@@ -61,3 +84,15 @@ std::vector<std::string> Object::get_signal_list() const {
 	sys_obj(Object_Op::GET_SIGNAL_LIST, address(), (Variant *)&signals);
 	return signals;
 }
+
+bool Object::pin() {
+	Variant result;
+	sys_obj(Object_Op::PIN, address(), &result);
+	return result;
+}
+
+bool Object::unpin() {
+	Variant result;
+	sys_obj(Object_Op::UNPIN, address(), &result);
+	return result;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "interned_name.hpp"
 #include "variant.hpp"
 #include "syscalls_fwd.hpp"
 
@@ -7,7 +8,7 @@ struct Object {
 	explicit Object(const std::string &name);
 
 	/// @brief Construct an Object object from an existing in-scope Object object.
-	/// @param addr The address of the Object object.
+	/// @param addr The handle of the Object object.
 	constexpr Object(uint64_t addr) : m_address{addr} {}
 
 	/// Call a method on the node.
@@ -23,11 +24,25 @@ struct Object {
 	/// @param args The arguments to pass to the method.
 	void voidcallv(std::string_view method, bool deferred, const Variant *argv, unsigned argc);
 
+	/// Call a method on the node, by an interned name.
+	/// @param method The interned name of the method.
+	/// @param deferred If true, the method will be called next frame.
+	/// @param args The arguments to pass to the method.
+	/// @return The return value of the method.
+	Variant callv(const InternedName &method, bool deferred, const Variant *argv, unsigned argc);
+
+	/// Call a method on the node by an interned name, without returning a value.
+	void voidcallv(const InternedName &method, bool deferred, const Variant *argv, unsigned argc);
+
 	template <typename... Args>
 	Variant call(std::string_view method, Args... args);
+	template <typename... Args>
+	Variant call(const InternedName &method, Args... args);
 
 	template <typename... Args>
 	void voidcall(std::string_view method, Args... args);
+	template <typename... Args>
+	void voidcall(const InternedName &method, Args... args);
 
 	template <typename... Args>
 	Variant operator () (std::string_view method, Args... args);
@@ -42,12 +57,14 @@ struct Object {
 	// Get a property of the node.
 	// @param name The name of the property.
 	// @return The value of the property.
-	Variant get(const std::string &name) const;
+	Variant get(std::string_view name) const;
+	Variant get(const InternedName &name) const;
 
 	// Set a property of the node.
 	// @param name The name of the property.
 	// @param value The value to set the property to.
-	void set(const std::string &name, const Variant &value);
+	void set(std::string_view name, const Variant &value);
+	void set(const InternedName &name, const Variant &value);
 
 	// Get a list of properties available on the object.
 	// @return A list of property names.
@@ -76,7 +93,16 @@ struct Object {
 	Node2D as_node2d() const;
 	Node3D as_node3d() const;
 
-	// Get the object identifier.
+	// Keep the object accessible across calls, eg. in a global variable.
+	// Objects are otherwise only accessible until the current call ends.
+	// @return True if the object was pinned.
+	bool pin();
+
+	// Release a pinned object at the end of the current call.
+	// @return True if the object was pinned.
+	bool unpin();
+
+	// Get the object identifier. This is an opaque handle, not an address.
 	uint64_t address() const { return m_address; }
 
 	// Check if the node is valid.
@@ -114,6 +140,18 @@ inline void Object::voidcall(std::string_view method, Args... args) {
 	this->voidcallv(method, false, argv, sizeof...(Args));
 }
 
+template <typename... Args>
+inline Variant Object::call(const InternedName &method, Args... args) {
+	Variant argv[] = {args...};
+	return callv(method, false, argv, sizeof...(Args));
+}
+
+template <typename... Args>
+inline void Object::voidcall(const InternedName &method, Args... args) {
+	Variant argv[] = {args...};
+	this->voidcallv(method, false, argv, sizeof...(Args));
+}
+
 template <typename... Args>
 inline Variant Object::operator () (std::string_view method, Args... args) {
 	return call(method, args...);
@@ -1,10 +1,12 @@
 #include "variant.hpp"
 
-#include "syscalls_fwd.hpp"
+#include "syscalls.h"
 
 EXTERN_SYSCALL(void, sys_vcreate, Variant *, int, int, const void *);
 EXTERN_SYSCALL(void, sys_vstore, unsigned, const void *, size_t);
 EXTERN_SYSCALL(void, sys_vfetch, unsigned, void *, int);
+MAKE_SYSCALL(ECALL_VFETCH, void, sys_vfetch_range, unsigned, void *, int, size_t, size_t, size_t);
+MAKE_SYSCALL(ECALL_VSTORE_RANGE, unsigned, sys_vstore_range, unsigned, size_t, const void *, size_t);
 
 template <>
 PackedArray<uint8_t>::PackedArray(const std::vector<uint8_t> &data) {
@@ -169,3 +171,70 @@ template <>
 void PackedArray<Color>::store(const Color *data, size_t size) {
 	sys_vstore(m_idx, data, size);
 }
+
+// A host-side array mapped into guest memory
+template <typename T>
+struct MappedArray {
+	T *begin;
+	T *end;
+	T *capacity;
+	unsigned idx;
+};
+
+template <typename T>
+std::span<const T> PackedArray<T>::view() const {
+	MappedArray<T> mapping;
+	sys_vfetch(m_idx, &mapping, 3);
+	return { mapping.begin, mapping.end };
+}
+template <typename T>
+std::span<T> PackedArray<T>::view_mut() {
+	MappedArray<T> mapping;
+	sys_vfetch(m_idx, &mapping, 4);
+	this->m_idx = mapping.idx;
+	return { mapping.begin, mapping.end };
+}
+template std::span<const uint8_t> PackedArray<uint8_t>::view() const;
+template std::span<uint8_t> PackedArray<uint8_t>::view_mut();
+template std::span<const int32_t> PackedArray<int32_t>::view() const;
+template std::span<int32_t> PackedArray<int32_t>::view_mut();
+template std::span<const int64_t> PackedArray<int64_t>::view() const;
+template std::span<int64_t> PackedArray<int64_t>::view_mut();
+template std::span<const float> PackedArray<float>::view() const;
+template std::span<float> PackedArray<float>::view_mut();
+template std::span<const double> PackedArray<double>::view() const;
+template std::span<double> PackedArray<double>::view_mut();
+template std::span<const Vector2> PackedArray<Vector2>::view() const;
+template std::span<Vector2> PackedArray<Vector2>::view_mut();
+template std::span<const Vector3> PackedArray<Vector3>::view() const;
+template std::span<Vector3> PackedArray<Vector3>::view_mut();
+template std::span<const Color> PackedArray<Color>::view() const;
+template std::span<Color> PackedArray<Color>::view_mut();
+
+template <typename T>
+std::vector<T> PackedArray<T>::fetch(size_t offset, size_t count, size_t stride) const {
+	std::vector<T> result;
+	sys_vfetch_range(m_idx, &result, 5, offset, count, stride);
+	return result;
+}
+template <typename T>
+void PackedArray<T>::store(size_t offset, std::span<const T> data) {
+	// The array is copied on the first store if it's shared, and then referred to by a new index
+	this->m_idx = sys_vstore_range(m_idx, offset, data.data(), data.size());
+}
+template std::vector<uint8_t> PackedArray<uint8_t>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<uint8_t>::store(size_t, std::span<const uint8_t>);
+template std::vector<int32_t> PackedArray<int32_t>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<int32_t>::store(size_t, std::span<const int32_t>);
+template std::vector<int64_t> PackedArray<int64_t>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<int64_t>::store(size_t, std::span<const int64_t>);
+template std::vector<float> PackedArray<float>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<float>::store(size_t, std::span<const float>);
+template std::vector<double> PackedArray<double>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<double>::store(size_t, std::span<const double>);
+template std::vector<Vector2> PackedArray<Vector2>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<Vector2>::store(size_t, std::span<const Vector2>);
+template std::vector<Vector3> PackedArray<Vector3>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<Vector3>::store(size_t, std::span<const Vector3>);
+template std::vector<Color> PackedArray<Color>::fetch(size_t, size_t, size_t) const;
+template void PackedArray<Color>::store(size_t, std::span<const Color>);
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <span>
 #include <vector>
 #include "color.hpp"
 #include "vector.hpp"
@@ -18,6 +19,62 @@
  * 
  * @tparam T uint8_t, int32_t, int64_t, float, double, Vector2, Vector3 or Color.
  */
+template <typename T>
+struct PackedArray;
+
+/**
+ * @brief A chunk of a host-side Packed Array, see PackedArray::chunks().
+ */
+template <typename T>
+struct PackedArrayChunk {
+	size_t offset; // Index of the first element in the array
+	std::vector<T> data;
+};
+
+/**
+ * @brief The chunks of a host-side Packed Array. Only the current chunk is held in guest memory,
+ * so that huge arrays can be processed in a streaming fashion.
+ */
+template <typename T>
+class PackedArrayChunks {
+public:
+	class iterator {
+	public:
+		iterator(const PackedArray<T> *array, size_t chunk_size) :
+				m_array(array), m_chunk_size(chunk_size) {
+			if (array != nullptr) {
+				fetch(0);
+			}
+		}
+		const PackedArrayChunk<T> &operator*() const { return m_chunk; }
+		const PackedArrayChunk<T> *operator->() const { return &m_chunk; }
+		iterator &operator++() {
+			fetch(m_chunk.offset + m_chunk.data.size());
+			return *this;
+		}
+		// Iteration ends at the first empty chunk
+		bool operator!=(const iterator &) const { return !m_chunk.data.empty(); }
+
+	private:
+		void fetch(size_t offset) {
+			m_chunk.offset = offset;
+			m_chunk.data = m_array->fetch(offset, m_chunk_size);
+		}
+		const PackedArray<T> *m_array;
+		size_t m_chunk_size;
+		PackedArrayChunk<T> m_chunk{};
+	};
+
+	PackedArrayChunks(const PackedArray<T> &array, size_t chunk_size) :
+			m_array(array), m_chunk_size(chunk_size) {}
+	iterator begin() const { return iterator(&m_array, m_chunk_size); }
+	iterator end() const { return iterator(nullptr, m_chunk_size); }
+
+private:
+	const PackedArray<T> &m_array;
+	size_t m_chunk_size;
+};
+
 template <typename T>
 struct PackedArray {
 	constexpr PackedArray() {}
@@ -30,6 +87,34 @@ struct PackedArray {
 	/// @return std::vector<T> The host-side array data.
 	std::vector<T> fetch() const;
 
+	/// @brief Map the host-side array data into the guest, read-only, without copying it.
+	/// @return std::span<const T> A view of the host-side array data, valid until the current call returns.
+	std::span<const T> view() const;
+
+	/// @brief Map a private copy of the host-side array data into the guest, to be modified in place.
+	/// This PackedArray then refers to the copy, so that it can be returned with the changes.
+	/// @return std::span<T> A view of the array data, valid until the current call returns.
+	/// @note Writes through the view are not copy-on-write: if this PackedArray is stored
+	/// by the host during the call, eg. as a property, the stored array sees later writes too.
+	std::span<T> view_mut();
+
+	/// @brief Retrieve a range of the host-side array data.
+	/// @param offset The index of the first element.
+	/// @param count The maximum number of elements. Fewer are returned at the end of the array.
+	/// @param stride The distance between the elements, 1 for consecutive elements.
+	/// @return std::vector<T> The elements in the range.
+	std::vector<T> fetch(size_t offset, size_t count, size_t stride = 1) const;
+
+	/// @brief Overwrite a range of the host-side array data, in place.
+	/// @param offset The index of the first element to overwrite.
+	/// @param data The new elements. The range must be within the array.
+	void store(size_t offset, std::span<const T> data);
+
+	/// @brief Iterate over the host-side array data in chunks, fetching one range at a time.
+	/// @param chunk_size The number of elements per chunk.
+	/// @return A range of chunks, each with its offset and elements.
+	PackedArrayChunks<T> chunks(size_t chunk_size) const { return PackedArrayChunks<T>(*this, chunk_size); }
+
 	/// @brief Store a vector of data into the host-side array.
 	/// @param data The data to store.
 	void store(const std::vector<T> &data);
@@ -51,7 +51,20 @@
 
 #define ECALL_VEC3_OPS (GAME_API_BASE + 37)
 
-#define ECALL_LAST (GAME_API_BASE + 38)
+#define ECALL_VSTORE_RANGE (GAME_API_BASE + 38)
+#define ECALL_VBYTES (GAME_API_BASE + 39)
+
+#define ECALL_METHOD_HANDLE (GAME_API_BASE + 40) // Resolve a method once, for calls by handle
+#define ECALL_VMETHOD_CALL (GAME_API_BASE + 41) // Call a method on a Variant by handle
+#define ECALL_OBJ_METHOD_CALL (GAME_API_BASE + 42) // Call a method on an object by handle
+
+#define ECALL_INTERN_NAME (GAME_API_BASE + 43) // Intern a method or property name, for use by handle
+
+#define ECALL_LAST (GAME_API_BASE + 44)
+
+// Method and property names are passed as an address and a length, or as the
+// handle of an interned name in place of the address, with this length
+#define INTERNED_NAME_LENGTH 0xFFFFFFFFu
 
 #define STRINGIFY_HELPER(x) #x
 #define STRINGIFY(x) STRINGIFY_HELPER(x)
@@ -78,6 +91,10 @@ enum class Object_Op {
 	CONNECT,
 	DISCONNECT,
 	GET_SIGNAL_LIST,
+	PIN,
+	UNPIN,
+	GET_NAMED, // Get a property, by the name given in the fourth and fifth arguments
+	SET_NAMED, // Set a property, by the name given in the fourth and fifth arguments
 };
 
 enum class Node_Create_Shortlist {
@@ -145,6 +162,13 @@ enum class Array_Op {
 	CLEAR,
 	SORT,
 	FETCH_TO_VECTOR,
+	FETCH_RANGE,
+	STORE_RANGE,
+};
+
+enum class VBytes_Op {
+	ENCODE = 0, // Variant to bytes, in the var_to_bytes() format
+	DECODE, // Bytes to Variant
 };
 
 enum class Dictionary_Op {
@@ -10,6 +10,7 @@ MAKE_SYSCALL(ECALL_VCREATE, void, sys_vcreate, Variant *, int, int, const void *
 MAKE_SYSCALL(ECALL_VFETCH, void, sys_vfetch, unsigned, void *, int);
 MAKE_SYSCALL(ECALL_VCLONE, void, sys_vclone, const Variant *, Variant *);
 MAKE_SYSCALL(ECALL_VSTORE, void, sys_vstore, Variant *, const void *, size_t);
+MAKE_SYSCALL(ECALL_VBYTES, void, sys_vbytes, VBytes_Op, Variant *, void *, size_t);
 
 Variant Variant::new_array() {
 	Variant v;
@@ -29,6 +30,18 @@ Variant Variant::new_dictionary() {
 	return v;
 }
 
+Variant Variant::from_bytes(std::span<const uint8_t> bytes) {
+	Variant v;
+	sys_vbytes(VBytes_Op::DECODE, &v, (void *)bytes.data(), bytes.size());
+	return v;
+}
+
+std::vector<uint8_t> Variant::to_bytes() const {
+	std::vector<uint8_t> result;
+	sys_vbytes(VBytes_Op::ENCODE, const_cast<Variant *>(this), &result, 0);
+	return result;
+}
+
 void Variant::evaluate(const Operator &op, const Variant &a, const Variant &b, Variant &r_ret, bool &r_valid) {
 	r_valid = sys_veval(op, &a, &b, &r_ret);
 }
@@ -153,6 +153,13 @@ struct Variant
 	// Empty Dictionary constructor
 	static Variant new_dictionary();
 
+	// Create a Variant, including all nested Arrays and Dictionaries, from the var_to_bytes() format
+	// in a single system call. See VariantWriter in variant_bytes.hpp. Objects, also nested ones, are rejected.
+	static Variant from_bytes(std::span<const uint8_t> bytes);
+	// Encode this Variant, including all nested Arrays and Dictionaries, in the var_to_bytes() format
+	// in a single system call. See VariantReader in variant_bytes.hpp. Objects, also nested ones, are rejected.
+	std::vector<uint8_t> to_bytes() const;
+
 	// Conversion operators
 	operator bool() const;
 	operator int64_t() const;
@@ -0,0 +1,295 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "variant.hpp"
+
+/**
+ * @brief Reads a tree of Variants that was encoded with Variant::to_bytes(), in place.
+ * The encoding is the one of var_to_bytes() in Godot 4. Values are read in order: scalars and
+ * strings directly, containers by their element count followed by their elements (and keys).
+ * The reader never allocates: strings and packed arrays are views into the encoded bytes.
+ * Reading past the end, or a value of the wrong type, sets the error flag and returns a default.
+ */
+class VariantReader {
+public:
+	explicit VariantReader(std::span<const uint8_t> data) :
+			m_data(data) {}
+
+	/// @brief Check that all values so far were read successfully.
+	bool ok() const noexcept { return !m_error; }
+	/// @brief Check if there are no more values to read.
+	bool at_end() const noexcept { return m_pos >= m_data.size(); }
+	/// @brief Get the type of the next value, or Variant::VARIANT_MAX if there is none.
+	int type() const noexcept { return m_pos + 4 <= m_data.size() ? int(peek_u32() & HEADER_TYPE_MASK) : int(Variant::VARIANT_MAX); }
+
+	bool read_bool() { return expect(Variant::BOOL) ? u32() != 0 : false; }
+	int64_t read_int() {
+		if (!expect(Variant::INT)) {
+			return 0;
+		}
+		return (m_header & ENCODE_FLAG_64) ? int64_t(u64()) : int64_t(int32_t(u32()));
+	}
+	double read_float() {
+		if (!expect(Variant::FLOAT)) {
+			return 0.0;
+		}
+		return (m_header & ENCODE_FLAG_64) ? bits<double>(u64()) : double(bits<float>(u32()));
+	}
+	/// @brief Read a String or StringName as UTF-8, without a terminating zero.
+	std::string_view read_string() {
+		const int t = type();
+		if (t != Variant::STRING && t != Variant::STRING_NAME) {
+			return fail<std::string_view>();
+		}
+		header();
+		return string();
+	}
+	/// @brief Begin reading an Array. Its elements follow.
+	/// @return The number of elements.
+	uint32_t read_array() {
+		if (!expect(Variant::ARRAY)) {
+			return 0;
+		}
+		const uint32_t count = u32() & 0x7FFFFFFF;
+		skip_container_type(m_header >> 16);
+		return count;
+	}
+	/// @brief Begin reading a Dictionary. Its keys and values follow, as pairs.
+	/// @return The number of pairs.
+	uint32_t read_dictionary() {
+		if (!expect(Variant::DICTIONARY)) {
+			return 0;
+		}
+		const uint32_t count = u32() & 0x7FFFFFFF;
+		skip_container_type(m_header >> 16);
+		skip_container_type(m_header >> 18);
+		return count;
+	}
+	/// @brief Read a PackedByteArray, PackedInt32Array, PackedFloat32Array or PackedColorArray as a view.
+	/// @tparam T uint8_t, int32_t, float or Color.
+	template <typename T>
+	std::span<const T> read_packed() {
+		static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, Color>,
+				"Only packed arrays with 4-byte aligned elements can be viewed in place.");
+		constexpr int packed_type = std::is_same_v<T, uint8_t> ? Variant::PACKED_BYTE_ARRAY
+				: std::is_same_v<T, int32_t>                     ? Variant::PACKED_INT32_ARRAY
+				: std::is_same_v<T, float>                       ? Variant::PACKED_FLOAT32_ARRAY
+																 : Variant::PACKED_COLOR_ARRAY;
+		if (!expect(packed_type)) {
+			return {};
+		}
+		const uint32_t count = u32();
+		const uint8_t *data = bytes(padded(size_t(count) * sizeof(T)));
+		return data ? std::span<const T>((const T *)data, count) : std::span<const T>();
+	}
+	/// @brief Skip the next value, including all of its elements.
+	void skip() {
+		const int t = type();
+		header();
+		const unsigned real = (m_header & ENCODE_FLAG_64) ? 8 : 4;
+		switch (t) {
+			case Variant::NIL: break;
+			case Variant::BOOL: u32(); break;
+			case Variant::INT:
+			case Variant::FLOAT: bytes((m_header & ENCODE_FLAG_64) ? 8 : 4); break;
+			case Variant::STRING:
+			case Variant::STRING_NAME: string(); break;
+			case Variant::VECTOR2: bytes(2 * real); break;
+			case Variant::VECTOR2I: bytes(8); break;
+			case Variant::RECT2: bytes(4 * real); break;
+			case Variant::RECT2I: bytes(16); break;
+			case Variant::VECTOR3: bytes(3 * real); break;
+			case Variant::VECTOR3I: bytes(12); break;
+			case Variant::TRANSFORM2D: bytes(6 * real); break;
+			case Variant::VECTOR4: bytes(4 * real); break;
+			case Variant::VECTOR4I: bytes(16); break;
+			case Variant::PLANE:
+			case Variant::QUATERNION: bytes(4 * real); break;
+			case Variant::AABB: bytes(6 * real); break;
+			case Variant::BASIS: bytes(9 * real); break;
+			case Variant::TRANSFORM3D: bytes(12 * real); break;
+			case Variant::PROJECTION: bytes(16 * real); break;
+			case Variant::COLOR: bytes(16); break;
+			case Variant::ARRAY: {
+				const uint32_t count = u32() & 0x7FFFFFFF;
+				skip_container_type(m_header >> 16);
+				for (uint32_t i = 0; i < count && ok(); i++) {
+					skip();
+				}
+				break;
+			}
+			case Variant::DICTIONARY: {
+				const uint32_t count = u32() & 0x7FFFFFFF;
+				skip_container_type(m_header >> 16);
+				skip_container_type(m_header >> 18);
+				for (uint32_t i = 0; i < 2 * count && ok(); i++) {
+					skip();
+				}
+				break;
+			}
+			case Variant::PACKED_BYTE_ARRAY: bytes(padded(u32())); break;
+			case Variant::PACKED_INT32_ARRAY:
+			case Variant::PACKED_FLOAT32_ARRAY: bytes(size_t(u32()) * 4); break;
+			case Variant::PACKED_INT64_ARRAY:
+			case Variant::PACKED_FLOAT64_ARRAY: bytes(size_t(u32()) * 8); break;
+			case Variant::PACKED_STRING_ARRAY: {
+				const uint32_t count = u32();
+				for (uint32_t i = 0; i < count && ok(); i++) {
+					string();
+				}
+				break;
+			}
+			case Variant::PACKED_VECTOR2_ARRAY: bytes(size_t(u32()) * 2 * real); break;
+			case Variant::PACKED_VECTOR3_ARRAY: bytes(size_t(u32()) * 3 * real); break;
+			case Variant::PACKED_COLOR_ARRAY: bytes(size_t(u32()) * 16); break;
+			case PACKED_VECTOR4_ARRAY: bytes(size_t(u32()) * 4 * real); break;
+			default: m_error = true; // Objects, node paths, RIDs, callables and signals are not supported
+		}
+	}
+
+private:
+	static constexpr uint32_t HEADER_TYPE_MASK = 0xFF;
+	static constexpr uint32_t ENCODE_FLAG_64 = 1 << 16;
+	static constexpr int PACKED_VECTOR4_ARRAY = Variant::PACKED_COLOR_ARRAY + 1;
+
+	template <typename T>
+	T fail() {
+		m_error = true;
+		return T();
+	}
+	const uint8_t *bytes(size_t n) {
+		if (m_error || n > m_data.size() - m_pos) {
+			m_error = true;
+			return nullptr;
+		}
+		const uint8_t *p = m_data.data() + m_pos;
+		m_pos += n;
+		return p;
+	}
+	uint32_t peek_u32() const {
+		uint32_t value;
+		std::memcpy(&value, m_data.data() + m_pos, 4);
+		return value;
+	}
+	uint32_t u32() {
+		const uint8_t *p = bytes(4);
+		uint32_t value = 0;
+		if (p) {
+			std::memcpy(&value, p, 4);
+		}
+		return value;
+	}
+	uint64_t u64() {
+		const uint8_t *p = bytes(8);
+		uint64_t value = 0;
+		if (p) {
+			std::memcpy(&value, p, 8);
+		}
+		return value;
+	}
+	template <typename T, typename U>
+	static T bits(U value) {
+		T result;
+		std::memcpy(&result, &value, sizeof(T));
+		return result;
+	}
+	static size_t padded(size_t n) { return (n + 3) & ~size_t(3); }
+	void header() { m_header = u32(); }
+	bool expect(int t) {
+		if (type() != t) {
+			m_error = true;
+			return false;
+		}
+		header();
+		return true;
+	}
+	std::string_view string() {
+		const uint32_t len = u32();
+		const uint8_t *p = bytes(padded(len));
+		return p ? std::string_view((const char *)p, len) : std::string_view();
+	}
+	// Typed containers are followed by their element type: a builtin type, or a class name or script path
+	void skip_container_type(uint32_t kind) {
+		switch (kind & 0b11) {
+			case 0: break;
+			case 1: u32(); break;
+			default: string(); break;
+		}
+	}
+
+	std::span<const uint8_t> m_data;
+	size_t m_pos = 0;
+	uint32_t m_header = 0;
+	bool m_error = false;
+};
+
+/**
+ * @brief Writes a tree of Variants in the encoding of var_to_bytes() in Godot 4,
+ * to be turned into a Variant with a single system call by Variant::from_bytes().
+ * Containers are written by their element count, followed by their elements (and keys).
+ */
+class VariantWriter {
+public:
+	void write_nil() { u32(Variant::NIL); }
+	void write_bool(bool value) {
+		u32(Variant::BOOL);
+		u32(value);
+	}
+	void write_int(int64_t value) {
+		u32(Variant::INT | ENCODE_FLAG_64);
+		raw(&value, 8);
+	}
+	void write_float(double value) {
+		u32(Variant::FLOAT | ENCODE_FLAG_64);
+		raw(&value, 8);
+	}
+	void write_string(std::string_view value) {
+		u32(Variant::STRING);
+		string(value);
+	}
+	/// @brief Begin an Array. Write its elements next.
+	void write_array(uint32_t count) {
+		u32(Variant::ARRAY);
+		u32(count);
+	}
+	/// @brief Begin a Dictionary. Write its keys and values next, as pairs.
+	void write_dictionary(uint32_t count) {
+		u32(Variant::DICTIONARY);
+		u32(count);
+	}
+	void write_packed(std::span<const uint8_t> values) {
+		u32(Variant::PACKED_BYTE_ARRAY);
+		u32(values.size());
+		raw(values.data(), values.size());
+		pad();
+	}
+	void write_packed(std::span<const float> values) {
+		u32(Variant::PACKED_FLOAT32_ARRAY);
+		u32(values.size());
+		raw(values.data(), values.size_bytes());
+	}
+
+	const std::vector<uint8_t> &data() const noexcept { return m_data; }
+	/// @brief Create the Variant tree that was written.
+	Variant to_variant() const { return Variant::from_bytes(m_data); }
+
+private:
+	static constexpr uint32_t ENCODE_FLAG_64 = 1 << 16;
+
+	void raw(const void *data, size_t n) {
+		const uint8_t *p = (const uint8_t *)data;
+		m_data.insert(m_data.end(), p, p + n);
+	}
+	void u32(uint32_t value) { raw(&value, 4); }
+	void pad() { m_data.resize((m_data.size() + 3) & ~size_t(3)); }
+	void string(std::string_view value) {
+		u32(value.size());
+		raw(value.data(), value.size());
+		pad();
+	}
+
+	std::vector<uint8_t> m_data;
+};
@@ -12,7 +12,7 @@ usage() {
 
 locally=false
 verbose=false
-current_version=7
+current_version=8
 CPPFLAGS="-g -O2 -std=gnu++23 -DVERSION=$current_version -fno-stack-protector -fno-threadsafe-statics"
 
 while [[ "$#" -gt 0 ]]; do
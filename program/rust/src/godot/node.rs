@@ -3,6 +3,33 @@ use core::arch::asm;
 use core::ffi::c_char;
 use crate::godot::variant::Variant;
 
+/* Method names that are passed by handle have this length */
+const INTERNED_NAME_LENGTH: usize = 0xFFFFFFFF;
+
+/* A method name that is interned once, and then passed by its handle.
+   String literals are already looked up by their address after the first use,
+   so this is for names that are built at run-time. */
+pub struct InternedName
+{
+	handle: usize,
+}
+
+impl InternedName
+{
+	pub fn new(name: &str) -> InternedName
+	{
+		InternedName
+		{
+			handle: godot_intern_name(name.as_ptr(), name.len()),
+		}
+	}
+
+	pub fn handle(&self) -> usize
+	{
+		self.handle
+	}
+}
+
 pub struct Node
 {
 	address: usize,
@@ -40,6 +67,27 @@ impl Node
 		let address = self.address;
 		return godot_method_call(address, method.as_ptr(), method.len(), args.as_ptr(), args.len());
 	}
+
+	pub fn call_interned(&self, method: &InternedName, args: &[Variant]) -> Variant
+	{
+		let address = self.address;
+		return godot_method_call(address, method.handle as *const c_char, INTERNED_NAME_LENGTH, args.as_ptr(), args.len());
+	}
+}
+
+fn godot_intern_name(name: *const c_char, size: usize) -> usize
+{
+	const SYSCALL_INTERN_NAME: i32 = 543;
+	let handle: usize;
+	unsafe {
+		asm!("ecall",
+			in("a0") name,
+			in("a1") size,
+			in("a7") SYSCALL_INTERN_NAME,
+			lateout("a0") handle,
+			options(nostack));
+	}
+	return handle;
 }
 
 fn godot_node_get(parent_address: usize, path: *const c_char, size: usize) -> usize
@@ -2,7 +2,22 @@
 // Godot Sandbox Zig API
 //
 pub const V = union { b: bool, i: i64, f: f64, obj: u64, bytes: [16]u8 };
-pub extern fn sys_vcall(self: *Variant, method: [*]const u8, method_len: usize, args: [*]Variant, args_len: usize, result: *Variant) void;
+pub extern fn sys_vcall(self: *Variant, method: [*]allowzero const u8, method_len: usize, args: [*]Variant, args_len: usize, result: *Variant) void;
+pub extern fn sys_intern_name(name: [*]const u8, name_len: usize) u32;
+
+// Method names that are passed by handle have this length
+const INTERNED_NAME_LENGTH: usize = 0xFFFFFFFF;
+
+// A method name that is interned once, and then passed by its handle.
+// String literals are already looked up by their address after the first use,
+// so this is for names that are built at run-time.
+pub const InternedName = struct {
+    handle: u32,
+
+    pub fn init(name: []const u8) InternedName {
+        return InternedName{ .handle = sys_intern_name(name.ptr, name.len) };
+    }
+};
 
 pub const Variant = struct {
     type: i64,
@@ -37,6 +52,13 @@ pub const Variant = struct {
         sys_vcall(self, method.ptr, method.len, args.ptr, args.len, &result);
         return result;
     }
+
+    pub fn call_interned(self: *Variant, method: InternedName, args: []Variant) Variant {
+        var result: Variant = undefined;
+        const name: [*]allowzero const u8 = @ptrFromInt(method.handle);
+        sys_vcall(self, name, INTERNED_NAME_LENGTH, args.ptr, args.len, &result);
+        return result;
+    }
 };
 
 comptime {
@@ -47,6 +69,12 @@ comptime {
         \\  li a7, 501
         \\  ecall
         \\  ret
+        \\.global sys_intern_name;
+        \\.type sys_intern_name, @function;
+        \\sys_intern_name:
+        \\  li a7, 543
+        \\  ecall
+        \\  ret
         \\.global fast_exit;
         \\.type fast_exit, @function;
         \\fast_exit:
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# Generates the table of engine methods that method handles can call with a ptrcall.
+#
+# Usage: generate_method_binds.py <extension_api.json> <output header>
+#
+# The table lists the methods of engine classes and builtin types whose arguments and return
+# value are all passed by value in a GuestVariant: bool, int, float, enums and the vector types.
+# Those methods are called directly through their method bind, with the arguments read from the
+# guest in place. Tables are sorted by class and method, so that they can be binary searched.
+
+import json
+import sys
+
+MAX_ARGS = 4
+
+# Types that are stored in place in a GuestVariant, with the same layout as their ptrcall encoding
+VALUE_TYPES = {
+    "bool": "BOOL",
+    "int": "INT",
+    "float": "FLOAT",
+    "Vector2": "VECTOR2",
+    "Vector2i": "VECTOR2I",
+    "Vector3": "VECTOR3",
+    "Vector3i": "VECTOR3I",
+    "Vector4": "VECTOR4",
+    "Vector4i": "VECTOR4I",
+    "Color": "COLOR",
+}
+
+# Builtin types that can have their methods called, either in place or through the scoped Variant
+BUILTIN_RECEIVERS = {name: vtype for name, vtype in VALUE_TYPES.items() if vtype not in ("BOOL", "INT", "FLOAT")}
+BUILTIN_RECEIVERS.update({"String": "STRING", "Array": "ARRAY", "Dictionary": "DICTIONARY"})
+
+
+def value_type(type_name):
+    if type_name.startswith("enum::") or type_name.startswith("bitfield::"):
+        return "INT"
+    return VALUE_TYPES.get(type_name)
+
+
+def signature(method, return_type):
+    if method.get("is_vararg") or method.get("is_static") or method.get("is_virtual"):
+        return None
+    arguments = method.get("arguments", [])
+    if len(arguments) > MAX_ARGS:
+        return None
+    arg_types = [value_type(arg["type"]) for arg in arguments]
+    if None in arg_types:
+        return None
+    ret = "NIL" if return_type is None else value_type(return_type)
+    if ret is None:
+        return None
+    return ret, arg_types
+
+
+def entry(class_name, vtype, method, ret, arg_types):
+    args = "{ " + ", ".join("Variant::" + t for t in arg_types) + " }" if arg_types else "{}"
+    return '\t{ "%s", Variant::%s, "%s", %d, Variant::%s, %d, %s },' % (
+        class_name, vtype, method["name"], method["hash"], ret, len(arg_types), args)
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("Usage: %s <extension_api.json> <output header>" % sys.argv[0], file=sys.stderr)
+        return 1
+    with open(sys.argv[1], "r", encoding="utf-8") as f:
+        api = json.load(f)
+
+    engine = []
+    for cls in api["classes"]:
+        for method in cls.get("methods", []):
+            if "hash" not in method:
+                continue
+            sig = signature(method, method.get("return_value", {}).get("type"))
+            if sig is not None:
+                engine.append((cls["name"], "OBJECT", method, *sig))
+
+    builtin = []
+    for cls in api["builtin_classes"]:
+        vtype = BUILTIN_RECEIVERS.get(cls["name"])
+        if vtype is None:
+            continue
+        for method in cls.get("methods", []):
+            # Methods of builtin types are called on a copy, so only const methods are called directly
+            if not method.get("is_const") or "hash" not in method:
+                continue
+            sig = signature(method, method.get("return_type"))
+            if sig is not None:
+                builtin.append((cls["name"], vtype, method, *sig))
+
+    # Sorted by byte order, which is the order of strcmp()
+    engine.sort(key=lambda e: (e[0].encode(), e[2]["name"].encode()))
+    builtin.sort(key=lambda e: (e[0].encode(), e[2]["name"].encode()))
+
+    lines = [
+        "// Generated by scripts/generate_method_binds.py from extension_api.json. Do not edit.",
+        "#pragma once",
+        "",
+        "static const MethodBindInfo engine_method_binds[] = {",
+    ]
+    lines += [entry(*e) for e in engine]
+    lines += ["};", "", "static const MethodBindInfo builtin_method_binds[] = {"]
+    lines += [entry(*e) for e in builtin]
+    lines += ["};", ""]
+
+    with open(sys.argv[2], "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(lines))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,349 @@
+#include "dwarf_line_index.h"
+
+#include "elf_scanner.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// DWARF constants used by the line number program, see the DWARF 5 standard, section 6.2
+enum : uint8_t {
+	DW_LNS_copy = 1,
+	DW_LNS_advance_pc = 2,
+	DW_LNS_advance_line = 3,
+	DW_LNS_set_file = 4,
+	DW_LNS_set_column = 5,
+	DW_LNS_negate_stmt = 6,
+	DW_LNS_set_basic_block = 7,
+	DW_LNS_const_add_pc = 8,
+	DW_LNS_fixed_advance_pc = 9,
+	DW_LNE_end_sequence = 1,
+	DW_LNE_set_address = 2,
+	DW_LNE_define_file = 3,
+	DW_LNCT_path = 1,
+	DW_LNCT_directory_index = 2,
+	DW_FORM_data2 = 0x05,
+	DW_FORM_data4 = 0x06,
+	DW_FORM_data8 = 0x07,
+	DW_FORM_string = 0x08,
+	DW_FORM_block = 0x09,
+	DW_FORM_data1 = 0x0b,
+	DW_FORM_strp = 0x0e,
+	DW_FORM_udata = 0x0f,
+	DW_FORM_data16 = 0x1e,
+	DW_FORM_line_strp = 0x1f,
+};
+
+namespace {
+// Bounds-checked little-endian reader. Reading past the end throws, which
+// stops parsing of the current unit without affecting what was already indexed.
+struct ByteReader {
+	std::string_view data;
+	size_t pos = 0;
+
+	template <typename T>
+	T read() {
+		if (pos + sizeof(T) > data.size()) {
+			throw std::out_of_range("DWARF: read out of bounds");
+		}
+		T value;
+		std::memcpy(&value, data.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+	uint64_t read_offset(bool dwarf64) {
+		return dwarf64 ? read<uint64_t>() : read<uint32_t>();
+	}
+	uint64_t uleb() {
+		uint64_t result = 0;
+		for (unsigned shift = 0;; shift += 7) {
+			const uint8_t byte = read<uint8_t>();
+			if (shift < 64) {
+				result |= uint64_t(byte & 0x7F) << shift;
+			}
+			if ((byte & 0x80) == 0) {
+				return result;
+			}
+		}
+	}
+	int64_t sleb() {
+		int64_t result = 0;
+		unsigned shift = 0;
+		uint8_t byte;
+		do {
+			byte = read<uint8_t>();
+			if (shift < 64) {
+				result |= int64_t(byte & 0x7F) << shift;
+			}
+			shift += 7;
+		} while (byte & 0x80);
+		if (shift < 64 && (byte & 0x40)) {
+			result |= -(int64_t(1) << shift);
+		}
+		return result;
+	}
+	std::string_view cstr() {
+		const size_t end = data.find('\0', pos);
+		if (end == std::string_view::npos) {
+			throw std::out_of_range("DWARF: unterminated string");
+		}
+		std::string_view result = data.substr(pos, end - pos);
+		pos = end + 1;
+		return result;
+	}
+	void skip(uint64_t bytes) {
+		if (bytes > data.size() - pos) {
+			throw std::out_of_range("DWARF: skip out of bounds");
+		}
+		pos += bytes;
+	}
+};
+} //namespace
+
+static std::string_view string_at(std::string_view section, uint64_t offset) {
+	if (offset >= section.size()) {
+		return {};
+	}
+	const std::string_view str = section.substr(offset);
+	return str.substr(0, str.find('\0'));
+}
+
+static String join_path(std::string_view directory, std::string_view file) {
+	const String name = String::utf8(file.data(), file.size());
+	if (directory.empty() || file.starts_with('/')) {
+		return name;
+	}
+	return String::utf8(directory.data(), directory.size()).path_join(name);
+}
+
+DwarfLineIndex::DwarfLineIndex(std::string_view binary) {
+	const ElfScanner elf(binary);
+	if (!elf.is_valid()) {
+		return;
+	}
+	elf.for_each_symbol([&](const ElfScanner::Symbol &symbol) {
+		if (symbol.type == ElfScanner::STT_FUNC && symbol.value != 0) {
+			m_symbols.insert(String::utf8(symbol.name.data(), symbol.name.size()), symbol.value);
+		}
+	});
+	this->parse_line_table(elf.section(".debug_line"), elf.section(".debug_str"), elf.section(".debug_line_str"));
+
+	// Sequence ends are ordered before rows at the same address, so that a lookup
+	// of the first address of a sequence finds the sequence and not the end of another.
+	std::stable_sort(m_rows.begin(), m_rows.end(), [](const Row &a, const Row &b) {
+		if (a.address != b.address) {
+			return a.address < b.address;
+		}
+		return a.line == 0 && b.line != 0;
+	});
+}
+
+void DwarfLineIndex::parse_line_table(std::string_view debug_line, std::string_view debug_str, std::string_view debug_line_str) {
+	ByteReader unit_reader{ debug_line };
+	while (unit_reader.pos < debug_line.size()) {
+		// Each unit is parsed on its own, so that a malformed unit only loses its own rows
+		uint64_t unit_length;
+		bool dwarf64;
+		try {
+			unit_length = unit_reader.read<uint32_t>();
+			dwarf64 = unit_length == 0xFFFFFFFF;
+			if (dwarf64) {
+				unit_length = unit_reader.read<uint64_t>();
+			}
+		} catch (const std::out_of_range &) {
+			return; // A truncated unit length ends the table
+		}
+		if (unit_length > debug_line.size() - unit_reader.pos) {
+			return;
+		}
+		ByteReader r{ debug_line.substr(0, unit_reader.pos + unit_length), unit_reader.pos };
+		unit_reader.pos += unit_length;
+		try {
+			const uint16_t version = r.read<uint16_t>();
+			if (version < 2 || version > 5) {
+				continue;
+			}
+			if (version >= 5) {
+				r.skip(2); // address_size, segment_selector_size
+			}
+			const uint64_t header_length = r.read_offset(dwarf64);
+			const size_t program_start = r.pos + header_length;
+			const uint8_t min_instruction_length = r.read<uint8_t>();
+			if (version >= 4) {
+				r.skip(1); // maximum_operations_per_instruction, only used by VLIW
+			}
+			r.skip(1); // default_is_stmt
+			const int8_t line_base = r.read<int8_t>();
+			const uint8_t line_range = r.read<uint8_t>();
+			const uint8_t opcode_base = r.read<uint8_t>();
+			if (line_range == 0 || opcode_base == 0) {
+				continue;
+			}
+			std::vector<uint8_t> opcode_lengths(opcode_base - 1);
+			for (uint8_t &length : opcode_lengths) {
+				length = r.read<uint8_t>();
+			}
+
+			// The file table of this unit, appended to the shared list of file names
+			std::vector<std::string_view> directories;
+			std::vector<uint32_t> files;
+			if (version >= 5) {
+				auto read_entries = [&](auto &&on_entry) {
+					const uint8_t format_count = r.read<uint8_t>();
+					std::vector<std::pair<uint64_t, uint64_t>> format(format_count);
+					for (auto &[content, form] : format) {
+						content = r.uleb();
+						form = r.uleb();
+					}
+					const uint64_t count = r.uleb();
+					for (uint64_t i = 0; i < count; i++) {
+						std::string_view path;
+						uint64_t directory = 0;
+						for (const auto &[content, form] : format) {
+							uint64_t value = 0;
+							std::string_view str;
+							switch (form) {
+								case DW_FORM_string: str = r.cstr(); break;
+								case DW_FORM_line_strp: str = string_at(debug_line_str, r.read_offset(dwarf64)); break;
+								case DW_FORM_strp: str = string_at(debug_str, r.read_offset(dwarf64)); break;
+								case DW_FORM_udata: value = r.uleb(); break;
+								case DW_FORM_data1: value = r.read<uint8_t>(); break;
+								case DW_FORM_data2: value = r.read<uint16_t>(); break;
+								case DW_FORM_data4: value = r.read<uint32_t>(); break;
+								case DW_FORM_data8: value = r.read<uint64_t>(); break;
+								case DW_FORM_data16: r.skip(16); break;
+								case DW_FORM_block: r.skip(r.uleb()); break;
+								default: throw std::out_of_range("DWARF: unsupported form in file table");
+							}
+							if (content == DW_LNCT_path) {
+								path = str;
+							} else if (content == DW_LNCT_directory_index) {
+								directory = value;
+							}
+						}
+						on_entry(path, directory);
+					}
+				};
+				read_entries([&](std::string_view path, uint64_t) {
+					directories.push_back(path);
+				});
+				read_entries([&](std::string_view path, uint64_t directory) {
+					files.push_back(m_files.size());
+					m_files.push_back(join_path(directory < directories.size() ? directories[directory] : std::string_view(), path));
+				});
+			} else {
+				// Before DWARF 5, directory 0 is the unlisted compilation directory and files start at 1
+				directories.push_back({});
+				for (std::string_view dir = r.cstr(); !dir.empty(); dir = r.cstr()) {
+					directories.push_back(dir);
+				}
+				files.push_back(m_files.size());
+				m_files.push_back(String());
+				for (std::string_view name = r.cstr(); !name.empty(); name = r.cstr()) {
+					const uint64_t directory = r.uleb();
+					r.uleb(); // modification time
+					r.uleb(); // file length
+					files.push_back(m_files.size());
+					m_files.push_back(join_path(directory < directories.size() ? directories[directory] : std::string_view(), name));
+				}
+			}
+
+			// Run the line number program
+			r.pos = program_start;
+			uint64_t address = 0;
+			uint64_t file = 1;
+			int64_t line = 1;
+			auto emit_row = [&](bool end_sequence) {
+				const uint32_t global_file = file < files.size() ? files[file] : UINT32_MAX;
+				m_rows.push_back({ address, global_file, end_sequence ? 0u : uint32_t(std::max<int64_t>(line, 1)) });
+			};
+			while (r.pos < r.data.size()) {
+				const uint8_t opcode = r.read<uint8_t>();
+				if (opcode >= opcode_base) {
+					const uint8_t adjusted = opcode - opcode_base;
+					address += (adjusted / line_range) * min_instruction_length;
+					line += line_base + adjusted % line_range;
+					emit_row(false);
+					continue;
+				}
+				switch (opcode) {
+					case 0: { // Extended opcode
+						const uint64_t length = r.uleb();
+						if (length == 0) {
+							break;
+						}
+						const size_t end = r.pos + length;
+						const uint8_t extended = r.read<uint8_t>();
+						if (extended == DW_LNE_end_sequence) {
+							emit_row(true);
+							address = 0;
+							file = 1;
+							line = 1;
+						} else if (extended == DW_LNE_set_address) {
+							address = (length - 1 >= 8) ? r.read<uint64_t>() : r.read<uint32_t>();
+						} else if (extended == DW_LNE_define_file) {
+							const std::string_view name = r.cstr();
+							const uint64_t directory = r.uleb();
+							files.push_back(m_files.size());
+							m_files.push_back(join_path(directory < directories.size() ? directories[directory] : std::string_view(), name));
+						}
+						r.pos = end;
+						break;
+					}
+					case DW_LNS_copy:
+						emit_row(false);
+						break;
+					case DW_LNS_advance_pc:
+						address += r.uleb() * min_instruction_length;
+						break;
+					case DW_LNS_advance_line:
+						line += r.sleb();
+						break;
+					case DW_LNS_set_file:
+						file = r.uleb();
+						break;
+					case DW_LNS_const_add_pc:
+						address += ((255 - opcode_base) / line_range) * min_instruction_length;
+						break;
+					case DW_LNS_fixed_advance_pc:
+						address += r.read<uint16_t>();
+						break;
+					case DW_LNS_set_column:
+					case DW_LNS_negate_stmt:
+					case DW_LNS_set_basic_block:
+					default:
+						// Standard opcodes that don't affect the address or line, including
+						// unknown ones, whose operand count is given in the unit header.
+						for (uint8_t i = 0; i < opcode_lengths[opcode - 1]; i++) {
+							r.uleb();
+						}
+						break;
+				}
+			}
+		} catch (const std::out_of_range &) {
+			// Truncated or malformed unit, keep the rows emitted so far
+		}
+	}
+}
+
+DwarfLineIndex::Location DwarfLineIndex::lookup(uint64_t address) const {
+	// The row that covers an address is the last row at or before it
+	auto it = std::upper_bound(m_rows.begin(), m_rows.end(), address, [](uint64_t addr, const Row &row) {
+		return addr < row.address;
+	});
+	if (it == m_rows.begin()) {
+		return {};
+	}
+	const Row &row = *(it - 1);
+	if (row.line == 0 || row.file >= m_files.size()) {
+		return {}; // Between sequences
+	}
+	return { m_files[row.file], int32_t(row.line) };
+}
+
+DwarfLineIndex::Location DwarfLineIndex::lookup_symbol(const String &symbol) const {
+	const uint64_t *address = m_symbols.getptr(symbol);
+	if (address == nullptr) {
+		return {};
+	}
+	return lookup(*address);
+}
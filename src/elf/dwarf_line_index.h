@@ -0,0 +1,49 @@
+#pragma once
+
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <string_view>
+#include <vector>
+
+using namespace godot;
+
+// An index of the DWARF line table (.debug_line) and the function symbols of a RISC-V ELF
+// program, built once per program. It answers address to file:line and symbol to file:line
+// lookups without running addr2line, so that exceptions can be reported in the same frame.
+class DwarfLineIndex {
+public:
+	struct Location {
+		String file;
+		int32_t line = 0;
+
+		bool is_valid() const { return line > 0; }
+	};
+
+	/// @brief Build the index from the sections of an ELF program. Missing or malformed
+	/// debug information results in an empty index, and never in an exception.
+	/// @param binary The ELF program.
+	explicit DwarfLineIndex(std::string_view binary);
+
+	/// @brief Find the source line of an instruction.
+	/// @param address The guest address of the instruction.
+	/// @return The file and line, or an invalid location if the address has no line information.
+	Location lookup(uint64_t address) const;
+	/// @brief Find the source line where a function begins.
+	/// @param symbol The name of the function, as found in the ELF symbol table.
+	/// @return The file and line, or an invalid location if the function has no line information.
+	Location lookup_symbol(const String &symbol) const;
+	/// @brief Check if the program has any line information, ie. if it was built with -g.
+	bool has_line_info() const { return !m_rows.empty(); }
+
+private:
+	struct Row {
+		uint64_t address;
+		uint32_t file;
+		uint32_t line; // 0 marks the end of a sequence
+	};
+	void parse_line_table(std::string_view debug_line, std::string_view debug_str, std::string_view debug_line_str);
+
+	std::vector<Row> m_rows; // Sorted by address
+	std::vector<String> m_files;
+	HashMap<String, uint64_t> m_symbols;
+};
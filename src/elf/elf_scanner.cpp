@@ -0,0 +1,106 @@
+#include "elf_scanner.h"
+
+static constexpr uint32_t SHT_NOBITS = 8;
+static constexpr uint64_t SHF_ALLOC = 0x2;
+static constexpr size_t ELF_HEADER_SIZE = 64;
+static constexpr size_t SECTION_HEADER_SIZE = 64;
+
+ElfScanner::ElfScanner(std::string_view binary) :
+		m_binary(binary) {
+	static constexpr std::string_view ELF_MAGIC("\x7F\x45\x4C\x46", 4);
+	if (binary.size() < ELF_HEADER_SIZE || binary.substr(0, 4) != ELF_MAGIC || binary[4] != 2 || binary[5] != 1) {
+		return;
+	}
+	const uint64_t shoff = read_at<uint64_t>(0x28);
+	const uint16_t shentsize = read_at<uint16_t>(0x3A);
+	const uint16_t shnum = read_at<uint16_t>(0x3C);
+	const uint16_t shstrndx = read_at<uint16_t>(0x3E);
+	if (shentsize < SECTION_HEADER_SIZE || shstrndx >= shnum || shoff > binary.size() || uint64_t(shnum) * shentsize > binary.size() - shoff) {
+		return;
+	}
+	m_shoff = shoff;
+	m_shentsize = shentsize;
+	m_shstrndx = shstrndx;
+	m_shnum = shnum;
+}
+
+bool ElfScanner::section_header(unsigned index, SectionHeader &header) const {
+	if (index >= m_shnum) {
+		return false;
+	}
+	const uint64_t offset = m_shoff + uint64_t(index) * m_shentsize;
+	header.name = read_at<uint32_t>(offset + 0);
+	header.type = read_at<uint32_t>(offset + 4);
+	header.flags = read_at<uint64_t>(offset + 8);
+	header.addr = read_at<uint64_t>(offset + 16);
+	header.offset = read_at<uint64_t>(offset + 24);
+	header.size = read_at<uint64_t>(offset + 32);
+	header.link = read_at<uint32_t>(offset + 40);
+	return true;
+}
+
+std::string_view ElfScanner::section_data(const SectionHeader &header) const {
+	// NOBITS sections, like .bss, have no contents in the file
+	if (header.type == SHT_NOBITS || header.offset > m_binary.size() || header.size > m_binary.size() - header.offset) {
+		return {};
+	}
+	return m_binary.substr(header.offset, header.size);
+}
+
+std::string_view ElfScanner::string_at(std::string_view strtab, uint64_t offset) const {
+	if (offset >= strtab.size()) {
+		return {};
+	}
+	const std::string_view str = strtab.substr(offset);
+	return str.substr(0, str.find('\0'));
+}
+
+std::string_view ElfScanner::section(std::string_view name) const {
+	SectionHeader shstrtab, header;
+	if (!section_header(m_shstrndx, shstrtab)) {
+		return {};
+	}
+	const std::string_view names = section_data(shstrtab);
+	for (unsigned i = 0; i < m_shnum; i++) {
+		if (section_header(i, header) && string_at(names, header.name) == name) {
+			return section_data(header);
+		}
+	}
+	return {};
+}
+
+std::string_view ElfScanner::read(uint64_t address, uint64_t size) const {
+	SectionHeader header;
+	for (unsigned i = 0; i < m_shnum; i++) {
+		if (!section_header(i, header) || (header.flags & SHF_ALLOC) == 0) {
+			continue;
+		}
+		if (address >= header.addr && address - header.addr <= header.size && size <= header.size - (address - header.addr)) {
+			const std::string_view data = section_data(header);
+			if (data.size() != header.size) {
+				return {}; // Zero-initialized memory is not backed by the file
+			}
+			return data.substr(address - header.addr, size);
+		}
+	}
+	return {};
+}
+
+std::string_view ElfScanner::read_string(uint64_t address) const {
+	SectionHeader header;
+	for (unsigned i = 0; i < m_shnum; i++) {
+		if (!section_header(i, header) || (header.flags & SHF_ALLOC) == 0) {
+			continue;
+		}
+		if (address >= header.addr && address - header.addr < header.size) {
+			const std::string_view data = section_data(header);
+			if (data.size() != header.size) {
+				return {};
+			}
+			const std::string_view str = data.substr(address - header.addr);
+			const size_t end = str.find('\0');
+			return end != std::string_view::npos ? str.substr(0, end) : std::string_view();
+		}
+	}
+	return {};
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// A read-only view of the headers, sections and symbols of a 64-bit little-endian
+// ELF program, used to read program metadata without constructing a machine.
+// Nothing is allocated: every lookup walks the headers in place, and every
+// string is a view into the program, which must outlive the scanner.
+class ElfScanner {
+public:
+	static constexpr uint8_t STT_OBJECT = 1;
+	static constexpr uint8_t STT_FUNC = 2;
+
+	struct Symbol {
+		std::string_view name;
+		uint64_t value;
+		uint64_t size;
+		uint8_t type;
+	};
+
+	explicit ElfScanner(std::string_view binary);
+
+	/// @brief Check if the program is a 64-bit little-endian ELF with valid section headers.
+	bool is_valid() const { return m_shnum != 0; }
+	/// @brief Get the contents of a section by name.
+	/// @return The section contents, or an empty view if there is no such section.
+	std::string_view section(std::string_view name) const;
+	/// @brief Read initialized program memory at a guest address, eg. a constant global.
+	/// @return The bytes, or an empty view if the range is not backed by the file.
+	std::string_view read(uint64_t address, uint64_t size) const;
+	/// @brief Read a NUL-terminated string from initialized program memory at a guest address.
+	/// @return The string without its terminator, or an empty view if it's not backed by the file.
+	std::string_view read_string(uint64_t address) const;
+
+	/// @brief Call a function for each symbol in the symbol table.
+	template <typename Callback>
+	void for_each_symbol(Callback &&callback) const;
+	/// @brief Call a function for each string in the .comment section, eg. compiler and API versions.
+	template <typename Callback>
+	void for_each_comment(Callback &&callback) const;
+
+private:
+	struct SectionHeader {
+		uint32_t name;
+		uint32_t type;
+		uint64_t flags;
+		uint64_t addr;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t link;
+	};
+	bool section_header(unsigned index, SectionHeader &header) const;
+	std::string_view section_data(const SectionHeader &header) const;
+	std::string_view string_at(std::string_view strtab, uint64_t offset) const;
+
+	template <typename T>
+	T read_at(uint64_t offset) const {
+		T value;
+		std::memcpy(&value, m_binary.data() + offset, sizeof(T));
+		return value;
+	}
+
+	std::string_view m_binary;
+	uint64_t m_shoff = 0;
+	uint16_t m_shentsize = 0;
+	uint16_t m_shnum = 0;
+	uint16_t m_shstrndx = 0;
+};
+
+template <typename Callback>
+inline void ElfScanner::for_each_symbol(Callback &&callback) const {
+	static constexpr uint32_t SHT_SYMTAB = 2;
+	static constexpr size_t SYMBOL_SIZE = 24;
+	SectionHeader symtab, strtab;
+	for (unsigned i = 0; i < m_shnum; i++) {
+		if (!section_header(i, symtab) || symtab.type != SHT_SYMTAB || !section_header(symtab.link, strtab)) {
+			continue;
+		}
+		const std::string_view symbols = section_data(symtab);
+		const std::string_view strings = section_data(strtab);
+		for (size_t offset = 0; offset + SYMBOL_SIZE <= symbols.size(); offset += SYMBOL_SIZE) {
+			const char *sym = symbols.data() + offset;
+			uint32_t name;
+			uint64_t value, size;
+			std::memcpy(&name, sym, sizeof(name));
+			std::memcpy(&value, sym + 8, sizeof(value));
+			std::memcpy(&size, sym + 16, sizeof(size));
+			const std::string_view symbol_name = string_at(strings, name);
+			if (!symbol_name.empty()) {
+				callback(Symbol{ symbol_name, value, size, uint8_t(sym[4] & 0xF) });
+			}
+		}
+	}
+}
+
+template <typename Callback>
+inline void ElfScanner::for_each_comment(Callback &&callback) const {
+	std::string_view comments = section(".comment");
+	while (!comments.empty()) {
+		const size_t end = comments.find('\0');
+		const std::string_view comment = comments.substr(0, end);
+		if (!comment.empty()) {
+			callback(comment);
+		}
+		if (end == std::string_view::npos) {
+			break;
+		}
+		comments.remove_prefix(end + 1);
+	}
+}
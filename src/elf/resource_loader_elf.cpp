@@ -4,8 +4,8 @@
 
 Variant ResourceFormatLoaderELF::_load(const String &p_path, const String &original_path, bool use_sub_threads, int32_t cache_mode) const {
 	Ref<ELFScript> elf_model = memnew(ELFScript);
+	// set_file() reads the program metadata, so there's nothing left to reload
 	elf_model->set_file(p_path);
-	elf_model->reload(false);
 	return elf_model;
 }
 PackedStringArray ResourceFormatLoaderELF::_get_recognized_extensions() const {
@@ -3,12 +3,22 @@
 #include "../docker.h"
 #include "../register_types.h"
 #include "../sandbox.h"
+#include "../sandbox_project_settings.h"
+#include "dwarf_line_index.h"
 #include "script_instance.h"
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/json.hpp>
 #include <godot_cpp/classes/resource_loader.hpp>
+#include <libriscv/util/crc32.hpp>
+#include <mutex>
 
 static constexpr bool VERBOSE_ELFSCRIPT = false;
+// Program metadata is cached next to the .import metadata of the project, keyed by the
+// CRC32-C of the program, so that loading a program doesn't have to scan its symbols.
+static constexpr char METADATA_CACHE_DIR[] = "res://.godot/imported/";
+static constexpr int METADATA_VERSION = 1;
 
 static Dictionary prop_to_dict(const PropertyInfo &p_prop) {
 	Dictionary d;
@@ -108,8 +118,21 @@ TypedArray<Dictionary> ELFScript::_get_documentation() const {
 String ELFScript::_get_class_icon_path() const {
 	return String("res://addons/godot_sandbox/Sandbox.svg");
 }
+bool ELFScript::has_callback(const StringName &p_name) const {
+	if (get_function(p_name) != nullptr) {
+		return true;
+	}
+	static const StringName process("_process");
+	static const StringName physics_process("_physics_process");
+	if (p_name == process) {
+		return get_function(StringName("_process_group")) != nullptr;
+	} else if (p_name == physics_process) {
+		return get_function(StringName("_physics_process_group")) != nullptr;
+	}
+	return false;
+}
 bool ELFScript::_has_method(const StringName &p_method) const {
-	bool result = functions.find(p_method) != -1;
+	bool result = has_callback(p_method);
 	if (!result) {
 		if (p_method == StringName("_init"))
 			result = true;
@@ -177,6 +200,7 @@ TypedArray<Dictionary> ELFScript::_get_script_property_list() const {
 	Dictionary max_mem = prop_to_dict(PropertyInfo(Variant::Type::INT, "max_memory", PropertyHint::PROPERTY_HINT_TYPE_STRING, "Maximum memory used by the sandboxed program", PROPERTY_USAGE_DEFAULT));
 	TypedArray<Dictionary> properties;
 	properties.push_back(std::move(max_mem));
+	properties.append_array(program_properties);
 	return properties;
 }
 
@@ -202,13 +226,15 @@ TypedArray<Dictionary> ELFScript::_get_script_method_list() const {
 	return functions_array;
 }
 int32_t ELFScript::_get_member_line(const StringName &p_member) const {
-	PackedStringArray formatted_functions = _get_source_code().split("\n");
-	for (int i = 0; i < formatted_functions.size(); i++) {
-		if (formatted_functions[i].find(p_member) != -1) {
-			return i + 1;
-		}
+	// The line where the function is defined in the program source, when built with -g
+	const DwarfLineIndex::Location location = get_line_index().lookup_symbol(p_member);
+	if (location.is_valid()) {
+		return location.line;
 	}
-	return 0;
+	// Otherwise the line of the function name in _get_source_code(), where each
+	// function is a 4-line object that starts on line 2, with "name" on its third line.
+	const int64_t index = functions.find(p_member);
+	return index >= 0 ? int32_t(4 * index + 4) : 0;
 }
 Dictionary ELFScript::_get_constants() const {
 	return Dictionary();
@@ -227,19 +253,144 @@ const PackedByteArray &ELFScript::get_content() {
 	return source_code;
 }
 
+const std::shared_ptr<Sandbox> &ELFScript::get_program_template() {
+	if (!program_template && !source_code.is_empty()) {
+		program_template = Sandbox::create_program_template(source_code, get_snapshot_path());
+	}
+	return program_template;
+}
+
+const DwarfLineIndex &ELFScript::get_line_index() const {
+	// Exceptions in parallel calls may look up lines from several threads at once
+	static std::mutex line_index_mutex;
+	std::lock_guard<std::mutex> lock(line_index_mutex);
+	if (!line_index) {
+		line_index = std::make_shared<DwarfLineIndex>(std::string_view((const char *)source_code.ptr(), source_code.size()));
+	}
+	return *line_index;
+}
+
+String ELFScript::get_snapshot_path() const {
+	if (!SandboxProjectSettings::use_program_snapshots()) {
+		return String();
+	}
+	// Stale snapshots are rejected by their program hash, so the path only needs to be unique per program
+	return "user://sandbox/snapshots/" + global_name + ".snapshot";
+}
+
 String ELFScript::get_elf_programming_language() const {
 	return elf_programming_language;
 }
 
+static String metadata_path(uint32_t hash) {
+	return METADATA_CACHE_DIR + String("sandbox-") + String::num_uint64(hash, 16) + ".meta";
+}
+
+static bool load_program_metadata(const PackedByteArray &binary, Sandbox::BinaryInfo &info) {
+	const String path = metadata_path(info.hash);
+	if (!FileAccess::file_exists(path)) {
+		return false;
+	}
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::READ);
+	if (file.is_null()) {
+		return false;
+	}
+	const Variant blob = file->get_var();
+	if (blob.get_type() != Variant::DICTIONARY) {
+		return false;
+	}
+	const Dictionary metadata = blob;
+	if (int(metadata.get("version", 0)) != METADATA_VERSION || int64_t(metadata.get("size", -1)) != binary.size()) {
+		return false;
+	}
+	const PackedStringArray functions = metadata["functions"];
+	const PackedInt64Array addresses = metadata["addresses"];
+	if (functions.size() != addresses.size()) {
+		return false;
+	}
+	info.language = metadata["language"];
+	info.version = metadata["api_version"];
+	info.functions = functions;
+	info.addresses.assign(addresses.ptr(), addresses.ptr() + addresses.size());
+	const Array properties = metadata["properties"];
+	for (int i = 0; i < properties.size(); i++) {
+		const Dictionary property = properties[i];
+		info.properties.push_back({ property["name"], Variant::Type(int(property["type"])) });
+	}
+	return true;
+}
+
+static void save_program_metadata(const PackedByteArray &binary, const Sandbox::BinaryInfo &info) {
+	Dictionary metadata;
+	metadata["version"] = METADATA_VERSION;
+	metadata["size"] = binary.size();
+	metadata["hash"] = info.hash;
+	metadata["language"] = info.language;
+	metadata["api_version"] = info.version;
+	metadata["functions"] = info.functions;
+	PackedInt64Array addresses;
+	for (gaddr_t address : info.addresses) {
+		addresses.push_back(address);
+	}
+	metadata["addresses"] = addresses;
+	Array properties;
+	for (const Sandbox::BinaryInfo::Property &property : info.properties) {
+		Dictionary entry;
+		entry["name"] = property.name;
+		entry["type"] = property.type;
+		properties.push_back(entry);
+	}
+	metadata["properties"] = properties;
+
+	DirAccess::make_dir_recursive_absolute(METADATA_CACHE_DIR);
+	Ref<FileAccess> file = FileAccess::open(metadata_path(info.hash), FileAccess::ModeFlags::WRITE);
+	if (file.is_valid()) {
+		file->store_var(metadata);
+	}
+}
+
 void ELFScript::set_file(const String &p_path) {
+	PackedByteArray new_source_code = FileAccess::get_file_as_bytes(p_path);
+	const uint32_t hash = riscv::crc32c(new_source_code.ptr(), new_source_code.size());
+	if (p_path == path && hash == content_hash && new_source_code.size() == source_code.size()) {
+		return; // Reloading an unchanged program
+	}
 	path = p_path;
-	source_code = FileAccess::get_file_as_bytes(path);
+	// Existing forks keep the old template alive for as long as they need it
+	program_template.reset();
+	line_index.reset();
+	source_code = std::move(new_source_code);
+	content_hash = hash;
 	global_name = "Sandbox_" + path.get_basename().replace("res://", "").replace("/", "_").capitalize().replace(" ", "");
-	Sandbox::BinaryInfo info = Sandbox::get_program_info_from_binary(source_code);
+
+	// Use the metadata produced when the program was imported, or scan the program and cache it
+	Sandbox::BinaryInfo info;
+	info.hash = hash;
+	if (!load_program_metadata(source_code, info)) {
+		info = Sandbox::get_program_info_from_binary(source_code);
+		info.hash = hash;
+		if (Engine::get_singleton()->is_editor_hint() && !source_code.is_empty()) {
+			save_program_metadata(source_code, info);
+		}
+	}
+	this->program_properties.clear();
+	for (const Sandbox::BinaryInfo::Property &property : info.properties) {
+		this->program_properties.push_back(prop_to_dict(PropertyInfo(property.type, property.name)));
+	}
+	// Build the dispatch table shared by all instances of this program
+	this->function_table = std::make_shared<FunctionTable>();
+	for (int i = 0; i < info.functions.size(); i++) {
+		this->function_table->insert(StringName(info.functions[i]), FunctionInfo{ info.addresses[i] });
+	}
 	info.functions.sort();
 	this->functions = std::move(info.functions);
 	this->elf_programming_language = info.language;
 	this->elf_api_version = info.version;
+
+	// Translate the program into native code as part of importing it in the editor
+	if (Engine::get_singleton()->is_editor_hint() && SandboxProjectSettings::use_binary_translation()) {
+		Sandbox::generate_binary_translation_for(source_code);
+	}
 }
 
 String ELFScript::get_dockerized_program_path() const {
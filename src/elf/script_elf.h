@@ -2,12 +2,22 @@
 
 #include <godot_cpp/classes/script_extension.hpp>
 #include <godot_cpp/classes/script_language.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <memory>
 
 using namespace godot;
+class DwarfLineIndex;
+class Sandbox;
 
 class ELFScript : public ScriptExtension {
 	GDCLASS(ELFScript, ScriptExtension);
 
+public:
+	struct FunctionInfo {
+		uint64_t address; // Guest address, as found in the ELF symbol table
+	};
+	using FunctionTable = HashMap<StringName, FunctionInfo>;
+
 protected:
 	static void _bind_methods() {}
 	String _to_string() const;
@@ -16,14 +26,32 @@ protected:
 	String path;
 	int elf_api_version;
 	String elf_programming_language;
+	uint32_t content_hash = 0; // CRC32-C of source_code
+	TypedArray<Dictionary> program_properties;
+	std::shared_ptr<Sandbox> program_template;
+	mutable std::shared_ptr<DwarfLineIndex> line_index;
+	std::shared_ptr<FunctionTable> function_table = std::make_shared<FunctionTable>();
 	// TODO
 	//HashSet<Object *> instances;
 
 public:
 	PackedStringArray functions;
+	/// @brief Find a public function of the program by its interned name.
+	/// @param p_name The name of the function.
+	/// @return The function, or null if the program has no such public function.
+	const FunctionInfo *get_function(const StringName &p_name) const { return function_table->getptr(p_name); }
+	/// @brief Check if instances of the program respond to a method, either through a public function of
+	/// the same name, or through a process group function such as _process_group for _process.
+	bool has_callback(const StringName &p_name) const;
+	/// @brief Get the dispatch table of all public functions, built once when the program is loaded.
+	/// Sandboxes running the program share the table, and keep it alive when the program is reloaded.
+	const std::shared_ptr<FunctionTable> &get_function_table() const { return function_table; }
 	String get_elf_programming_language() const;
 	int get_elf_api_version() const { return elf_api_version; }
 	String get_dockerized_program_path() const;
+	/// @brief Get the source line index of the program, building it on first use.
+	/// @return The index, which is empty if the program was built without debug information.
+	const DwarfLineIndex &get_line_index() const;
 
 	virtual bool _editor_can_reload_from_file() override;
 	virtual void _placeholder_erased(void *p_placeholder) override;
@@ -62,6 +90,12 @@ public:
 	virtual Variant _get_rpc_config() const override;
 
 	const PackedByteArray &get_content();
+	/// @brief Get the pre-initialized template Sandbox of this program, creating it on first use.
+	/// @return The program template, or null if the program could not be initialized.
+	const std::shared_ptr<Sandbox> &get_program_template();
+	/// @brief Get the path of the snapshot that warm-starts the program template.
+	/// @return The snapshot path, or an empty string if snapshots are disabled in the project settings.
+	String get_snapshot_path() const;
 	void set_file(const String &path);
 	ELFScript() {}
 	~ELFScript() {}
@@ -6,6 +6,7 @@
 #include "../zig/script_zig.h"
 #include "script_elf.h"
 #include "script_instance_helper.h"
+#include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/core/object.hpp>
 #include <godot_cpp/templates/local_vector.hpp>
 static constexpr bool VERBOSE_LOGGING = false;
@@ -16,6 +17,22 @@ static const std::vector<std::string> godot_functions = {
 	"_is_read_only",
 };
 
+// Process groups: When a program exports _process_group or _physics_process_group, the nodes
+// that share its auto-created Sandbox are processed by a single guest call per frame:
+//   _process_group(PackedArray<int64_t> nodes, double delta)
+// instead of one _process(delta) call per node. The nodes may be accessed by the guest
+// for the duration of the call.
+struct ProcessGroup {
+	enum Callback {
+		PROCESS,
+		PHYSICS_PROCESS,
+		CALLBACK_COUNT
+	};
+	std::vector<ELFScriptInstance *> members;
+	uint64_t dispatched_frame[CALLBACK_COUNT] = { UINT64_MAX, UINT64_MAX };
+};
+static std::unordered_map<ELFScript *, ProcessGroup> process_groups;
+
 static void handle_language_warnings(Array &warnings, const Ref<ELFScript> &script) {
 	const String language = script->get_elf_programming_language();
 	if (language == "C++") {
@@ -107,13 +124,20 @@ Variant ELFScriptInstance::callp(
 	}
 
 retry_callp:
-	if (script->functions.has(p_method)) {
+	if (this->auto_created_sandbox) {
+		Variant result;
+		if (this->dispatch_process_group(p_method, p_args, p_argument_count, result)) {
+			r_error.error = GDEXTENSION_CALL_OK;
+			return result;
+		}
+	}
+	if (const ELFScript::FunctionInfo *info = script->get_function(p_method)) {
 		if (current_sandbox && current_sandbox->has_program_loaded()) {
 			// Set the Sandbox instance tree base to the owner node
 			current_sandbox->set_tree_base(godot::Object::cast_to<Node>(this->owner));
 			// Perform the vmcall
 			r_error.error = GDEXTENSION_CALL_OK;
-			return current_sandbox->vmcall_fn(p_method, p_args, p_argument_count);
+			return current_sandbox->vmcall_fn(p_method, *script.ptr(), *info, p_args, p_argument_count);
 		}
 	}
 
@@ -301,16 +325,10 @@ bool ELFScriptInstance::has_method(const StringName &p_name) const {
 	if (script.is_null()) {
 		return true;
 	}
-	bool result = false;
-	for (const std::string &function : godot_functions) {
-		if (p_name == StringName(function.c_str())) {
-			result = true;
-			break;
-		}
-	}
+	bool result = script->has_callback(p_name);
 	if (!result) {
-		for (String &function : script->functions) {
-			if (p_name == StringName(function)) {
+		for (const std::string &function : godot_functions) {
+			if (p_name == StringName(function.c_str())) {
 				result = true;
 				break;
 			}
@@ -395,6 +413,7 @@ ELFScriptInstance::ELFScriptInstance(Object *p_owner, const Ref<ELFScript> p_scr
 	this->auto_created_sandbox = (this->current_sandbox == nullptr);
 	if (auto_created_sandbox) {
 		this->current_sandbox = create_sandbox(p_script);
+		process_groups[p_script.ptr()].members.push_back(this);
 		//ERR_PRINT("ELFScriptInstance: owner is not a Sandbox");
 		//fprintf(stderr, "ELFScriptInstance: owner is instead a '%s'!\n", p_owner->get_class().utf8().get_data());
 	}
@@ -409,6 +428,77 @@ ELFScriptInstance::ELFScriptInstance(Object *p_owner, const Ref<ELFScript> p_scr
 }
 
 ELFScriptInstance::~ELFScriptInstance() {
+	if (this->auto_created_sandbox) {
+		auto it = process_groups.find(this->script.ptr());
+		if (it != process_groups.end()) {
+			std::vector<ELFScriptInstance *> &members = it->second.members;
+			members.erase(std::remove(members.begin(), members.end(), this), members.end());
+			// The script may be freed once it has no instances left
+			if (members.empty()) {
+				process_groups.erase(it);
+			}
+		}
+	}
+}
+
+bool ELFScriptInstance::dispatch_process_group(const StringName &p_method, const Variant **p_args, int p_argument_count, Variant &r_result) {
+	static const StringName process("_process");
+	static const StringName physics_process("_physics_process");
+	static const StringName process_group("_process_group");
+	static const StringName physics_process_group("_physics_process_group");
+
+	ProcessGroup::Callback callback;
+	const StringName *group_function;
+	if (p_method == process) {
+		callback = ProcessGroup::PROCESS;
+		group_function = &process_group;
+	} else if (p_method == physics_process) {
+		callback = ProcessGroup::PHYSICS_PROCESS;
+		group_function = &physics_process_group;
+	} else {
+		return false;
+	}
+	if (script->get_function(*group_function) == nullptr || p_argument_count != 1) {
+		return false;
+	}
+	// Only callbacks made by the engine are grouped. Direct calls to _process
+	// on a node that isn't being processed take the regular path.
+	Node *node = Object::cast_to<Node>(this->owner);
+	if (node == nullptr || !node->is_inside_tree()) {
+		return false;
+	}
+	if (callback == ProcessGroup::PROCESS ? !node->is_processing() : !node->is_physics_processing()) {
+		return false;
+	}
+
+	ProcessGroup &group = process_groups[script.ptr()];
+	const uint64_t frame = (callback == ProcessGroup::PROCESS) ? Engine::get_singleton()->get_process_frames() : Engine::get_singleton()->get_physics_frames();
+	if (group.dispatched_frame[callback] == frame) {
+		// The whole group has already been processed this frame
+		return true;
+	}
+	group.dispatched_frame[callback] = frame;
+
+	// Collect the nodes that are due for the same callback this frame
+	std::vector<godot::Object *> objects;
+	objects.reserve(group.members.size());
+	for (ELFScriptInstance *member : group.members) {
+		Node *member_node = Object::cast_to<Node>(member->owner);
+		if (member_node == nullptr || !member_node->is_inside_tree() || !member_node->can_process()) {
+			continue;
+		}
+		if (callback == ProcessGroup::PROCESS ? !member_node->is_processing() : !member_node->is_physics_processing()) {
+			continue;
+		}
+		objects.push_back(member_node);
+	}
+
+	if (current_sandbox && current_sandbox->has_program_loaded()) {
+		current_sandbox->set_tree_base(node);
+		// The nodes are passed as a PackedInt64Array of object handles, followed by delta
+		r_result = current_sandbox->vmcall_with_objects(*group_function, objects, p_args, 1);
+	}
+	return true;
 }
 
 // When a Sandbox needs to be automatically created, we instead share it
@@ -39,6 +39,9 @@ class ELFScriptInstance : public ScriptInstanceExtension {
 	void update_methods() const;
 	static void convert_prop(const PropertyInfo &p_src, GDExtensionPropertyInfo &p_dst);
 
+	// Make one guest call for every node of the script that is due for the same engine callback this frame
+	bool dispatch_process_group(const StringName &p_method, const Variant **p_args, int p_argument_count, Variant &r_result);
+
 	// Retrieve the sandbox and whether it was created automatically or not
 	std::tuple<Sandbox *, bool> get_sandbox() const;
 	Sandbox *create_sandbox(const Ref<ELFScript> &p_script);
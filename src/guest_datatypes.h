@@ -228,6 +228,12 @@ struct GuestStdVector {
 	}
 };
 
+// A packed array mapped into the guest by vfetch, see Sandbox::map_packed_array()
+struct GuestMappedArray {
+	GuestStdVector view;
+	uint32_t index; // The Variant that holds the mapped array
+};
+
 struct GuestVariant {
 	/**
 	 * @brief Creates a new godot Variant from a GuestVariant that comes from a sandbox.
@@ -34,8 +34,10 @@ Variant GuestVariant::toVariant(const Sandbox &emu) const {
 			return Variant{ godot::Color(v.v4f[0], v.v4f[1], v.v4f[2], v.v4f[3]) };
 
 		case Variant::OBJECT: {
-			godot::Object *obj = (godot::Object *)uintptr_t(v.i);
-			if (emu.is_scoped_object(obj))
+			if (v.i == 0)
+				return Variant{ (godot::Object *)nullptr };
+			godot::Object *obj = emu.get_scoped_object(v.i);
+			if (obj != nullptr)
 				return Variant{ obj };
 			else
 				throw std::runtime_error("GuestVariant::toVariant(): Object is not known/scoped");
@@ -110,9 +112,8 @@ const Variant *GuestVariant::toVariantPtr(const Sandbox &emu) const {
 }
 
 void GuestVariant::set_object(Sandbox &emu, godot::Object *obj) {
-	emu.add_scoped_object(obj);
 	this->type = Variant::OBJECT;
-	this->v.i = (uintptr_t)obj;
+	this->v.i = emu.add_scoped_object(obj);
 }
 
 void GuestVariant::set(Sandbox &emu, const Variant &value, bool implicit_trust) {
@@ -198,15 +199,14 @@ void GuestVariant::set(Sandbox &emu, const Variant &value, bool implicit_trust)
 			break;
 		}
 
-		case Variant::OBJECT: { // Objects are represented as uintptr_t
+		case Variant::OBJECT: { // Objects are represented as handles
 			if (!implicit_trust)
 				throw std::runtime_error("GuestVariant::set(): Cannot set OBJECT type without implicit trust");
 			// TODO: Check if the object is already scoped?
 			godot::Object *obj = value.operator godot::Object *();
 			if (!emu.is_allowed(obj))
 				throw std::runtime_error("GuestVariant::set(): Object is not allowed");
-			emu.add_scoped_object(obj);
-			this->v.i = (uintptr_t)obj;
+			this->v.i = emu.add_scoped_object(obj);
 			break;
 		}
 
@@ -266,8 +266,7 @@ void GuestVariant::create(Sandbox &emu, Variant &&value) {
 			godot::Object *obj = value.operator godot::Object *();
 			if (!emu.is_allowed(obj))
 				throw std::runtime_error("GuestVariant::create(): Object is not allowed");
-			emu.add_scoped_object(obj);
-			this->v.i = (uintptr_t)obj;
+			this->v.i = emu.add_scoped_object(obj);
 			break;
 		}
 
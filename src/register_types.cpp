@@ -74,6 +74,12 @@ static void initialize_riscv_module(ModuleInitializationLevel p_level) {
 	ResourceFormatLoaderZig::init();
 	ResourceFormatSaverZig::init();
 	SandboxProjectSettings::register_settings();
+	// Use the system call costs measured on this platform, if any. The table is loaded once,
+	// so that costs calibrated or set at runtime are not replaced when programs are loaded.
+	const String cost_table = SandboxProjectSettings::get_syscall_cost_table();
+	if (!cost_table.is_empty()) {
+		Sandbox::load_syscall_costs(cost_table);
+	}
 }
 
 static void uninitialize_riscv_module(ModuleInitializationLevel p_level) {
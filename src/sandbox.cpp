@@ -11,8 +11,6 @@
 
 using namespace godot;
 
-static const int HEAP_SYSCALLS_BASE = 480;
-static const int MEMORY_SYSCALLS_BASE = 485;
 static const std::vector<std::string> program_arguments = { "program" };
 
 String Sandbox::_to_string() const {
@@ -32,7 +30,31 @@ void Sandbox::_bind_methods() {
 		ClassDB::bind_vararg_method(METHOD_FLAGS_DEFAULT, "vmcall", &Sandbox::vmcall, mi, DEFVAL(std::vector<Variant>{}));
 		ClassDB::bind_vararg_method(METHOD_FLAGS_DEFAULT, "vmcallv", &Sandbox::vmcallv, mi, DEFVAL(std::vector<Variant>{}));
 	}
+	{
+		MethodInfo mi;
+		mi.arguments.push_back(PropertyInfo(Variant::STRING, "function"));
+		mi.arguments.push_back(PropertyInfo(Variant::INT, "budget_per_frame"));
+		mi.name = "vmcall_sliced";
+		mi.return_val = PropertyInfo(Variant::BOOL, "started");
+		ClassDB::bind_vararg_method(METHOD_FLAGS_DEFAULT, "vmcall_sliced", &Sandbox::vmcall_sliced, mi, DEFVAL(std::vector<Variant>{}));
+	}
+	ClassDB::bind_static_method("Sandbox", D_METHOD("call_parallel", "sandboxes", "function", "args"), &Sandbox::call_parallel, DEFVAL(Array()));
+	ClassDB::bind_method(D_METHOD("is_in_parallel_call"), &Sandbox::is_in_parallel_call);
+	ClassDB::bind_method(D_METHOD("parallel_map", "function", "data", "chunk_size"), &Sandbox::parallel_map);
+	ClassDB::bind_method(D_METHOD("is_sliced_call_active"), &Sandbox::is_sliced_call_active);
+	ClassDB::bind_method(D_METHOD("cancel_sliced_call"), &Sandbox::cancel_sliced_call);
+	ADD_SIGNAL(MethodInfo("sliced_call_finished", PropertyInfo(Variant::NIL, "result", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NIL_IS_VARIANT)));
+	{
+		MethodInfo mi;
+		mi.arguments.push_back(PropertyInfo(Variant::STRING, "function"));
+		mi.name = "vmcall_async";
+		mi.return_val = PropertyInfo(Variant::INT, "handle");
+		ClassDB::bind_vararg_method(METHOD_FLAGS_DEFAULT, "vmcall_async", &Sandbox::vmcall_async, mi, DEFVAL(std::vector<Variant>{}));
+	}
+	ClassDB::bind_method(D_METHOD("get_async_calls_pending"), &Sandbox::get_async_calls_pending);
+	ADD_SIGNAL(MethodInfo("async_call_finished", PropertyInfo(Variant::INT, "handle"), PropertyInfo(Variant::NIL, "result", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NIL_IS_VARIANT)));
 	ClassDB::bind_method(D_METHOD("vmcallable", "function", "args"), &Sandbox::vmcallable, DEFVAL(Array{}));
+	ClassDB::bind_method(D_METHOD("vmcall_batch", "function", "args", "arity"), &Sandbox::vmcall_batch, DEFVAL(0));
 
 	// Sandbox restrictions.
 	ClassDB::bind_method(D_METHOD("enable_restrictions"), &Sandbox::enable_restrictions);
@@ -47,8 +69,35 @@ void Sandbox::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_floating_point_registers"), &Sandbox::get_floating_point_registers);
 	ClassDB::bind_method(D_METHOD("set_argument_registers", "args"), &Sandbox::set_argument_registers);
 	ClassDB::bind_method(D_METHOD("get_current_instruction"), &Sandbox::get_current_instruction);
+	ClassDB::bind_method(D_METHOD("get_source_location", "function"), &Sandbox::get_source_location);
 	ClassDB::bind_method(D_METHOD("resume"), &Sandbox::resume);
 
+	// Binary translation.
+	ClassDB::bind_method(D_METHOD("generate_binary_translation"), &Sandbox::generate_binary_translation);
+	ClassDB::bind_method(D_METHOD("is_binary_translated"), &Sandbox::is_binary_translated);
+	ClassDB::bind_method(D_METHOD("is_jit_compiled"), &Sandbox::is_jit_compiled);
+
+	// Profiling.
+	ClassDB::bind_method(D_METHOD("get_profile"), &Sandbox::get_profile);
+	ClassDB::bind_method(D_METHOD("clear_profile"), &Sandbox::clear_profile);
+	ClassDB::bind_method(D_METHOD("start_sampling", "interval"), &Sandbox::start_sampling, DEFVAL(10000));
+	ClassDB::bind_method(D_METHOD("stop_sampling"), &Sandbox::stop_sampling);
+	ClassDB::bind_method(D_METHOD("get_sample_count"), &Sandbox::get_sample_count);
+	ClassDB::bind_method(D_METHOD("save_samples", "path"), &Sandbox::save_samples, DEFVAL("user://sandbox_samples.folded"));
+	ClassDB::bind_method(D_METHOD("get_syscall_trace"), &Sandbox::get_syscall_trace);
+	ClassDB::bind_static_method("Sandbox", D_METHOD("get_global_syscall_trace"), &Sandbox::get_global_syscall_trace);
+	ClassDB::bind_method(D_METHOD("save_syscall_trace", "path"), &Sandbox::save_syscall_trace, DEFVAL("user://sandbox_syscalls.json"));
+	ClassDB::bind_method(D_METHOD("clear_syscall_trace"), &Sandbox::clear_syscall_trace);
+	ClassDB::bind_method(D_METHOD("calibrate_syscall_costs", "instructions_per_second"), &Sandbox::calibrate_syscall_costs);
+	ClassDB::bind_static_method("Sandbox", D_METHOD("get_syscall_costs"), &Sandbox::get_syscall_costs);
+	ClassDB::bind_static_method("Sandbox", D_METHOD("set_syscall_costs", "costs"), &Sandbox::set_syscall_costs);
+	ClassDB::bind_static_method("Sandbox", D_METHOD("save_syscall_costs", "path"), &Sandbox::save_syscall_costs, DEFVAL("user://sandbox_syscall_costs.json"));
+	ClassDB::bind_static_method("Sandbox", D_METHOD("load_syscall_costs", "path"), &Sandbox::load_syscall_costs, DEFVAL("user://sandbox_syscall_costs.json"));
+
+	// Snapshots.
+	ClassDB::bind_method(D_METHOD("save_snapshot", "path"), &Sandbox::save_snapshot);
+	ClassDB::bind_method(D_METHOD("load_snapshot", "path"), &Sandbox::load_snapshot);
+
 	ClassDB::bind_method(D_METHOD("assault", "test", "iterations"), &Sandbox::assault);
 	ClassDB::bind_method(D_METHOD("has_function", "function"), &Sandbox::has_function);
 
@@ -65,31 +114,75 @@ void Sandbox::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_instructions_max"), &Sandbox::get_instructions_max);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "execution_timeout", PROPERTY_HINT_NONE, "Maximum millions of instructions executed before cancelling execution"), "set_instructions_max", "get_instructions_max");
 
+	ClassDB::bind_method(D_METHOD("set_frame_budget_weight", "weight"), &Sandbox::set_frame_budget_weight);
+	ClassDB::bind_method(D_METHOD("get_frame_budget_weight"), &Sandbox::get_frame_budget_weight);
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "frame_budget_weight", PROPERTY_HINT_RANGE, "0,100,0.01,or_greater"), "set_frame_budget_weight", "get_frame_budget_weight");
+	ClassDB::bind_method(D_METHOD("get_frame_instruction_share"), &Sandbox::get_frame_instruction_share);
+	ClassDB::bind_static_method("Sandbox", D_METHOD("set_frame_instruction_budget", "budget"), &Sandbox::set_frame_instruction_budget);
+	ClassDB::bind_static_method("Sandbox", D_METHOD("get_frame_instruction_budget"), &Sandbox::get_frame_instruction_budget);
+
 	ClassDB::bind_method(D_METHOD("set_use_unboxed_arguments", "use_unboxed_arguments"), &Sandbox::set_use_unboxed_arguments);
 	ClassDB::bind_method(D_METHOD("get_use_unboxed_arguments"), &Sandbox::get_use_unboxed_arguments);
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_unboxed_arguments", PROPERTY_HINT_NONE, "Use unboxed arguments for VM function calls"), "set_use_unboxed_arguments", "get_use_unboxed_arguments");
 
+	ClassDB::bind_method(D_METHOD("set_use_binary_translation", "use_binary_translation"), &Sandbox::set_use_binary_translation);
+	ClassDB::bind_method(D_METHOD("get_use_binary_translation"), &Sandbox::get_use_binary_translation);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_binary_translation", PROPERTY_HINT_NONE, "Run ahead-of-time translated native code for the program, when it is available"), "set_use_binary_translation", "get_use_binary_translation");
+
+	ClassDB::bind_method(D_METHOD("set_use_jit_compilation", "use_jit_compilation"), &Sandbox::set_use_jit_compilation);
+	ClassDB::bind_method(D_METHOD("get_use_jit_compilation"), &Sandbox::get_use_jit_compilation);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_jit_compilation", PROPERTY_HINT_NONE, "JIT-compile the program in the background once one of its functions becomes hot (requires libtcc)"), "set_use_jit_compilation", "get_use_jit_compilation");
+
+	ClassDB::bind_method(D_METHOD("set_use_program_template", "use_program_template"), &Sandbox::set_use_program_template);
+	ClassDB::bind_method(D_METHOD("get_use_program_template"), &Sandbox::get_use_program_template);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_program_template", PROPERTY_HINT_NONE, "Fork the program from its pre-initialized template instead of loading it from scratch"), "set_use_program_template", "get_use_program_template");
+
+	ClassDB::bind_method(D_METHOD("set_profiling", "profiling"), &Sandbox::set_profiling);
+	ClassDB::bind_method(D_METHOD("get_profiling"), &Sandbox::get_profiling);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "profiling", PROPERTY_HINT_NONE, "Profile each guest function called on this sandbox, and show it in the debugger monitors"), "set_profiling", "get_profiling");
+
+	ClassDB::bind_method(D_METHOD("set_syscall_tracing", "syscall_tracing"), &Sandbox::set_syscall_tracing);
+	ClassDB::bind_method(D_METHOD("get_syscall_tracing"), &Sandbox::get_syscall_tracing);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "syscall_tracing", PROPERTY_HINT_NONE, "Trace the calls, host time and bytes copied of each Godot API system call"), "set_syscall_tracing", "get_syscall_tracing");
+
 	// Group for monitored Sandbox health.
 	ADD_GROUP("Sandbox Monitoring", "monitor_");
 
 	ClassDB::bind_method(D_METHOD("get_heap_usage"), &Sandbox::get_heap_usage);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_heap_usage", PROPERTY_HINT_NONE, "Current arena usage"), "", "get_heap_usage");
 
+	ClassDB::bind_method(D_METHOD("get_instance_memory_usage"), &Sandbox::get_instance_memory_usage);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_instance_memory_usage", PROPERTY_HINT_NONE, "Memory owned by this sandbox alone"), "", "get_instance_memory_usage");
+
+	ClassDB::bind_method(D_METHOD("get_shared_memory_usage"), &Sandbox::get_shared_memory_usage);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_shared_memory_usage", PROPERTY_HINT_NONE, "Memory shared with other sandboxes of the same program"), "", "get_shared_memory_usage");
+
 	ClassDB::bind_method(D_METHOD("get_exceptions"), &Sandbox::get_exceptions);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_exceptions", PROPERTY_HINT_NONE, "Number of exceptions thrown"), "", "get_exceptions");
 
 	ClassDB::bind_method(D_METHOD("get_timeouts"), &Sandbox::get_timeouts);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_execution_timeouts", PROPERTY_HINT_NONE, "Number of execution timeouts"), "", "get_timeouts");
 
+	ClassDB::bind_method(D_METHOD("get_frame_budget_overruns"), &Sandbox::get_frame_budget_overruns);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_frame_budget_overruns", PROPERTY_HINT_NONE, "Number of calls skipped or stopped by the frame instruction budget"), "", "get_frame_budget_overruns");
+
 	ClassDB::bind_method(D_METHOD("get_calls_made"), &Sandbox::get_calls_made);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_calls_made", PROPERTY_HINT_NONE, "Number of calls made"), "", "get_calls_made");
 
+	ClassDB::bind_method(D_METHOD("get_jit_compiled_functions"), &Sandbox::get_jit_compiled_functions);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_jit_compiled_functions", PROPERTY_HINT_NONE, "Number of public functions running JIT-compiled code"), "", "get_jit_compiled_functions");
+
+	ClassDB::bind_method(D_METHOD("get_jit_compile_time"), &Sandbox::get_jit_compile_time);
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "monitor_jit_compile_time", PROPERTY_HINT_NONE, "Time spent JIT-compiling the program, in seconds"), "", "get_jit_compile_time");
+
 	ClassDB::bind_static_method("Sandbox", D_METHOD("get_global_calls_made"), &Sandbox::get_global_calls_made);
 	ClassDB::bind_static_method("Sandbox", D_METHOD("get_global_exceptions"), &Sandbox::get_global_exceptions);
 	ClassDB::bind_static_method("Sandbox", D_METHOD("get_global_timeouts"), &Sandbox::get_global_timeouts);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_global_calls_made", PROPERTY_HINT_NONE, "Number of calls made"), "", "get_global_calls_made");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_global_exceptions", PROPERTY_HINT_NONE, "Number of exceptions thrown"), "", "get_global_exceptions");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_global_execution_timeouts", PROPERTY_HINT_NONE, "Number of execution timeouts"), "", "get_global_timeouts");
+	ClassDB::bind_static_method("Sandbox", D_METHOD("get_global_frame_budget_overruns"), &Sandbox::get_global_frame_budget_overruns);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "monitor_global_frame_budget_overruns", PROPERTY_HINT_NONE, "Number of calls skipped or stopped by the frame instruction budget"), "", "get_global_frame_budget_overruns");
 
 	ClassDB::bind_static_method("Sandbox", D_METHOD("get_global_instance_count"), &Sandbox::get_global_instance_count);
 	ClassDB::bind_static_method("Sandbox", D_METHOD("get_accumulated_startup_time"), &Sandbox::get_accumulated_startup_time);
@@ -102,7 +195,18 @@ void Sandbox::_bind_methods() {
 
 Sandbox::Sandbox() {
 	this->m_use_unboxed_arguments = SandboxProjectSettings::use_native_types();
+	this->m_use_program_template = SandboxProjectSettings::use_program_templates();
+	this->m_use_binary_translation = SandboxProjectSettings::use_binary_translation();
+	this->m_use_jit_compilation = SandboxProjectSettings::use_jit_compilation();
+	this->m_jit_call_threshold = std::max<int64_t>(1, SandboxProjectSettings::get_jit_call_threshold());
 	this->m_global_instance_count += 1;
+	this->m_global_frame_budget_weight += this->m_frame_budget_weight;
+	// The frame budget is shared by all sandboxes, so it's read from the project settings once
+	static const bool frame_budget_initialized = [] {
+		set_frame_instruction_budget(SandboxProjectSettings::get_frame_instruction_budget());
+		return true;
+	}();
+	(void)frame_budget_initialized;
 	// For each call state, reset the state
 	for (CurrentState &state : this->m_states) {
 		state.initialize(this->m_max_refs);
@@ -118,7 +222,14 @@ Sandbox::Sandbox() {
 
 Sandbox::~Sandbox() {
 	this->m_global_instance_count -= 1;
+	this->m_global_frame_budget_weight -= this->m_frame_budget_weight;
+	this->clear_profile();
+	this->set_syscall_tracing(false);
 	try {
+		this->cancel_sliced_call();
+		this->free_worker_forks();
+		this->free_async_forks();
+		this->finish_jit_compilation();
 		delete this->m_machine;
 	} catch (const std::exception &e) {
 		ERR_PRINT(("Sandbox exception: " + std::string(e.what())).c_str());
@@ -131,6 +242,11 @@ void Sandbox::set_program(Ref<ELFScript> program) {
 		// TODO unload program
 		return;
 	}
+	if (this->m_use_program_template) {
+		if (this->load_from_template(m_program_data->get_program_template())) {
+			return;
+		}
+	}
 	this->load(&m_program_data->get_content());
 }
 Ref<ELFScript> Sandbox::get_program() {
@@ -159,21 +275,13 @@ void Sandbox::load(const PackedByteArray *buffer, const std::vector<std::string>
 
 	/** We can't handle exceptions until the Machine is fully constructed. Two steps.  */
 	try {
+		this->cancel_sliced_call();
+		this->finish_jit_compilation();
 		delete this->m_machine;
+		this->m_machine = nullptr;
+		this->m_program_template = nullptr;
 
-		const riscv::MachineOptions<RISCV_ARCH> options{
-			.memory_max = uint64_t(get_memory_max()) << 20, // in MiB
-			//.verbose_loader = true,
-			.default_exit_function = "fast_exit",
-#ifdef RISCV_BINARY_TRANSLATION
-			// We don't care about the instruction limit when full binary translation is enabled
-			// Specifically, for the Machines where full binary translation is *available*, so
-			// technically we need a way to check if a Machine has it available before setting this.
-			.translate_ignore_instruction_limit = true,
-#endif
-		};
-
-		this->m_machine = new machine_t{ binary_view, options };
+		this->m_machine = new machine_t{ binary_view, this->machine_options() };
 	} catch (const std::exception &e) {
 		ERR_PRINT(("Sandbox construction exception: " + std::string(e.what())).c_str());
 		this->m_machine = new machine_t{};
@@ -185,17 +293,7 @@ void Sandbox::load(const PackedByteArray *buffer, const std::vector<std::string>
 	try {
 		machine_t &m = machine();
 
-		m.set_userdata(this);
-		this->m_current_state = &this->m_states[0]; // Set the current state to the first state
-
-		this->initialize_syscalls();
-
-		const gaddr_t heap_size = MAX_HEAP << 20; // in MiB
-		const gaddr_t heap_area = machine().memory.mmap_allocate(heap_size);
-
-		// Add native system call interfaces
-		machine().setup_native_heap(HEAP_SYSCALLS_BASE, heap_area, heap_size);
-		machine().setup_native_memory(MEMORY_SYSCALLS_BASE);
+		this->setup_machine();
 
 		// Set up a Linux environment for the program
 		const std::vector<std::string> *argv = argv_ptr ? argv_ptr : &program_arguments;
@@ -212,16 +310,77 @@ void Sandbox::load(const PackedByteArray *buffer, const std::vector<std::string>
 	this->read_program_properties(true);
 
 	// Pre-cache some functions
-	PackedStringArray functions = this->get_functions();
-	for (int i = 0; i < functions.size(); i++) {
-		this->cached_address_of(functions[i].hash(), functions[i]);
-	}
+	this->precache_functions();
 
 	// Accumulate startup time
 	const uint64_t startup_t1 = Time::get_singleton()->get_ticks_usec();
 	m_accumulated_startup_time += (startup_t1 - startup_t0) / 1e6;
 }
 
+riscv::MachineOptions<RISCV_ARCH> Sandbox::machine_options() {
+	riscv::MachineOptions<RISCV_ARCH> options{
+		.memory_max = uint64_t(get_memory_max()) << 20, // in MiB
+		//.verbose_loader = true,
+		.default_exit_function = "fast_exit",
+	};
+#ifdef RISCV_BINARY_TRANSLATION
+	// Run ahead-of-time translated code when it exists for this exact program,
+	// otherwise fall back to the interpreter without invoking any compiler.
+	options.translate_enabled = false;
+	if (m_use_binary_translation && m_binary != nullptr) {
+		if (apply_translation_options(*m_binary, options, false)) {
+			return options;
+		}
+	}
+	if (m_use_jit_compilation) {
+		this->apply_jit_options(options);
+	}
+#endif
+	return options;
+}
+
+void Sandbox::setup_machine() {
+	machine_t &m = machine();
+
+	m.set_userdata(this);
+	this->m_current_state = &this->m_states[0]; // Set the current state to the first state
+	this->clear_scoped_objects();
+	this->clear_profile();
+	this->m_method_handles = std::make_shared<MethodHandles>();
+	this->setup_guest_names();
+
+	this->initialize_syscalls();
+
+	const gaddr_t heap_size = MAX_HEAP << 20; // in MiB
+	const gaddr_t heap_area = m.memory.mmap_allocate(heap_size);
+
+	// Add native system call interfaces
+	m.setup_native_heap(HEAP_SYSCALLS_BASE, heap_area, heap_size);
+	m.setup_native_memory(MEMORY_SYSCALLS_BASE);
+}
+
+void Sandbox::precache_functions() const {
+	m_lookup.clear();
+	// Sandboxes of the same program share one table of public functions. The program's
+	// dispatch table already holds it, otherwise the program is scanned once, and forks
+	// of this sandbox share the result.
+	if (m_program_data.is_valid() && m_binary != nullptr && m_program_data->get_content().ptr() == m_binary->ptr()) {
+		m_functions = m_program_data->get_function_table();
+	} else {
+		const BinaryInfo info = get_program_info_from_binary(machine().memory.binary());
+		std::shared_ptr<ELFScript::FunctionTable> functions = std::make_shared<ELFScript::FunctionTable>();
+		for (int i = 0; i < info.functions.size(); i++) {
+			functions->insert(StringName(info.functions[i]), ELFScript::FunctionInfo{ info.addresses[i] });
+		}
+		m_functions = std::move(functions);
+	}
+	for (const KeyValue<StringName, ELFScript::FunctionInfo> &function : *m_functions) {
+		if (function.value.address != 0x0) {
+			const_cast<machine_t *>(m_machine)->cpu.create_fast_path_function(function.value.address);
+		}
+	}
+}
+
 Variant Sandbox::vmcall_address(gaddr_t address, const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error) {
 	error.error = GDEXTENSION_CALL_OK;
 	return this->vmcall_internal(address, args, arg_count);
@@ -237,8 +396,9 @@ Variant Sandbox::vmcall(const Variant **args, GDExtensionInt arg_count, GDExtens
 	const Variant &function = *args[0];
 	args += 1;
 	arg_count -= 1;
-	const String function_name = function.operator String();
-	return this->vmcall_internal(cached_address_of(function_name.hash(), function_name), args, arg_count);
+	// Free when the caller passes a StringName, otherwise the name is interned once
+	const StringName function_name = function.operator StringName();
+	return this->vmcall_internal(cached_address_of(function_name), args, arg_count);
 }
 Variant Sandbox::vmcallv(const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error) {
 	if (arg_count < 1) {
@@ -251,12 +411,12 @@ Variant Sandbox::vmcallv(const Variant **args, GDExtensionInt arg_count, GDExten
 	const Variant &function = *args[0];
 	args += 1;
 	arg_count -= 1;
-	const String function_name = function.operator String();
+	const StringName function_name = function.operator StringName();
 	// Store use_unboxed_arguments state and restore it after the call
 	Variant result;
 	auto old_use_unboxed_arguments = this->m_use_unboxed_arguments;
 	this->m_use_unboxed_arguments = false;
-	result = this->vmcall_internal(cached_address_of(function_name.hash(), function_name), args, arg_count);
+	result = this->vmcall_internal(cached_address_of(function_name), args, arg_count);
 	this->m_use_unboxed_arguments = old_use_unboxed_arguments;
 	return result;
 }
@@ -265,9 +425,26 @@ Variant Sandbox::vmcall_fn(const StringName &function, const Variant **args, GDE
 		this->m_throttled--;
 		return Variant();
 	}
-	Variant result = this->vmcall_internal(cached_address_of(function.hash()), args, arg_count);
+	Variant result = this->vmcall_internal(cached_address_of(function), args, arg_count);
 	return result;
 }
+Variant Sandbox::vmcall_fn(const StringName &function, const ELFScript &script, const ELFScript::FunctionInfo &info, const Variant **args, GDExtensionInt arg_count) {
+	if (this->m_throttled > 0) {
+		this->m_throttled--;
+		return Variant();
+	}
+	// Calls that are counted towards JIT compilation go through the lookup table
+	const bool same_table = m_functions == script.get_function_table() && !m_jit_armed;
+	const gaddr_t address = same_table ? gaddr_t(info.address) : cached_address_of(function);
+	return this->vmcall_internal(address, args, arg_count);
+}
+Variant Sandbox::vmcall_with_objects(const StringName &function, const std::vector<godot::Object *> &objects, const Variant **args, GDExtensionInt arg_count) {
+	if (this->m_throttled > 0) {
+		this->m_throttled--;
+		return Variant();
+	}
+	return this->vmcall_internal(cached_address_of(function), args, arg_count, &objects);
+}
 void Sandbox::setup_arguments_native(gaddr_t arrayDataPtr, GuestVariant *v, const Variant **args, int argc) {
 	// In this mode we will try to use registers when possible
 	// The stack is already set up from setup_arguments(), so we just need to set up the registers
@@ -329,10 +506,9 @@ void Sandbox::setup_arguments_native(gaddr_t arrayDataPtr, GuestVariant *v, cons
 				machine.cpu.reg(index++) = *(gaddr_t *)&inner->color_flt[2];
 				break;
 			}
-			case Variant::OBJECT: { // Objects are represented as uintptr_t
+			case Variant::OBJECT: { // Objects are represented as handles
 				godot::Object *obj = inner->to_object();
-				this->add_scoped_object(obj);
-				machine.cpu.reg(index++) = uintptr_t(obj); // Fits in a single register
+				machine.cpu.reg(index++) = this->add_scoped_object(obj); // Fits in a single register
 				break;
 			}
 			case Variant::ARRAY:
@@ -417,9 +593,29 @@ GuestVariant *Sandbox::setup_arguments(gaddr_t &sp, const Variant **args, int ar
 	// A0 is the return value (Variant) of the function
 	return &v[0];
 }
-Variant Sandbox::vmcall_internal(gaddr_t address, const Variant **args, int argc) {
+Variant Sandbox::vmcall_internal(gaddr_t address, const Variant **args, int argc, const std::vector<godot::Object *> *objects) {
+	// Calls from the host are limited by the share of the frame budget, when there is one.
+	// Worker forks run on other threads, outside of the frames, and are not scheduled.
+	// Calls made while a sliced call is suspended run on top of it, and are scheduled as well.
+	const bool is_scheduled = m_frame_instruction_budget != 0 && is_outermost_call() && !m_worker_fork;
+	uint64_t max_instructions = get_instructions_max() << 20;
+	bool limited_by_share = false;
+	if (is_scheduled) [[unlikely]] {
+		const uint64_t remaining = this->frame_instructions_remaining();
+		if (remaining == 0) {
+			// Over its share of this frame, the call is skipped
+			this->record_frame_budget_overrun();
+			return Variant();
+		}
+		limited_by_share = remaining < max_instructions;
+		max_instructions = std::min(max_instructions, remaining);
+		// Nothing is charged for a call that fails before it runs
+		m_machine->set_instruction_counter(0);
+	}
+
 	CurrentState &state = this->m_states[m_level];
 	const bool is_reentrant_call = m_level > 1;
+	this->release_scoped_objects(state);
 	state.reset(this->m_level);
 	m_level++;
 
@@ -429,8 +625,30 @@ Variant Sandbox::vmcall_internal(gaddr_t address, const Variant **args, int argc
 	// Call statistics
 	this->m_calls_made++;
 	Sandbox::m_global_calls_made++;
+	const uint64_t profile_t0 = m_profiling ? profile_ticks() : 0;
 
 	try {
+		Variant handles_arg;
+		std::array<const Variant *, 8> object_args;
+		if (objects != nullptr) {
+			// Objects provided by the host are implicitly trusted, just like object arguments,
+			// and a process group may hand over more of them than the guest may acquire
+			if (argc >= int(object_args.size())) {
+				throw std::runtime_error("Too many arguments.");
+			}
+			PackedInt64Array handles;
+			handles.resize(objects->size());
+			int64_t *handles_ptr = handles.ptrw();
+			for (size_t i = 0; i < objects->size(); i++) {
+				handles_ptr[i] = this->add_scoped_object((*objects)[i], true);
+			}
+			handles_arg = std::move(handles);
+			object_args[0] = &handles_arg;
+			std::copy(args, args + argc, object_args.begin() + 1);
+			args = object_args.data();
+			argc++;
+		}
+
 		GuestVariant *retvar = nullptr;
 		riscv::CPU<RISCV_ARCH> &cpu = m_machine->cpu;
 		auto &sp = cpu.reg(riscv::REG_SP);
@@ -442,7 +660,14 @@ Variant Sandbox::vmcall_internal(gaddr_t address, const Variant **args, int argc
 			// set up each argument, and return value
 			retvar = this->setup_arguments(sp, args, argc);
 			// execute!
-			m_machine->simulate_with(get_instructions_max() << 20, 0u, address);
+			if (m_sampling_active) [[unlikely]] {
+				this->simulate_sampled(address, max_instructions);
+			} else {
+				m_machine->simulate_with(max_instructions, 0u, address);
+			}
+			if (is_scheduled) [[unlikely]] {
+				this->charge_frame_instructions();
+			}
 		} else if (m_level < MAX_LEVEL) {
 			riscv::Registers<RISCV_ARCH> regs;
 			regs = cpu.registers();
@@ -453,25 +678,45 @@ Variant Sandbox::vmcall_internal(gaddr_t address, const Variant **args, int argc
 			// set up each argument, and return value
 			retvar = this->setup_arguments(sp, args, argc);
 			// execute!
-			cpu.preempt_internal(regs, true, address, get_instructions_max() << 20);
+			cpu.preempt_internal(regs, true, address, max_instructions);
+			if (is_scheduled) [[unlikely]] {
+				this->charge_frame_instructions();
+			}
 		} else {
 			throw std::runtime_error("Recursion level exceeded");
 		}
 
+		// Mapped arrays are written back before the return value is read
+		this->unmap_arrays(m_level);
 		// Treat return value as pointer to Variant
 		Variant result = retvar->toVariant(*this);
+		if (m_profiling) [[unlikely]] {
+			this->record_profile(address, profile_t0, is_reentrant_call, false);
+		}
 		// Restore the previous state
 		this->m_level--;
 		this->m_current_state = old_state;
 		return result;
 
 	} catch (const std::exception &e) {
+		this->unmap_arrays(m_level);
 		this->m_level--;
+		if (is_scheduled && this->charge_frame_instructions(limited_by_share ? max_instructions : 0)) [[unlikely]] {
+			// Stopped at the end of its share of the frame, which is neither an error nor a timeout
+			if (m_profiling) {
+				this->record_profile(address, profile_t0, is_reentrant_call, false);
+			}
+			this->m_current_state = old_state;
+			return Variant();
+		}
 		if (Engine::get_singleton()->is_editor_hint()) {
 			// Throttle exceptions in the sandbox when calling from the editor
 			this->m_throttled += EDITOR_THROTTLE;
 		}
 		this->handle_exception(address);
+		if (m_profiling) [[unlikely]] {
+			this->record_profile(address, profile_t0, is_reentrant_call, true);
+		}
 		// TODO: Free the function arguments and return value? Will help keep guest memory clean
 
 		this->m_current_state = old_state;
@@ -479,7 +724,7 @@ Variant Sandbox::vmcall_internal(gaddr_t address, const Variant **args, int argc
 	}
 }
 Variant Sandbox::vmcallable(String function, Array args) {
-	const gaddr_t address = cached_address_of(function.hash(), function);
+	const gaddr_t address = cached_address_of(StringName(function));
 	if (address == 0x0) {
 		ERR_PRINT("Function not found in the guest: " + function);
 		return Variant();
@@ -525,32 +770,36 @@ void Sandbox::print(std::string_view text) {
 	this->m_last_newline = (text.back() == '\n');
 }
 
-gaddr_t Sandbox::cached_address_of(int64_t hash, const String &function) const {
-	gaddr_t address = 0x0;
-	auto it = m_lookup.find(hash);
-	if (it == m_lookup.end()) {
-		const CharString ascii = function.ascii();
-		const std::string_view str{ ascii.get_data(), (size_t)ascii.length() };
-		address = address_of(str);
-		if (address != 0x0) {
+gaddr_t Sandbox::cached_address_of(const StringName &function) const {
+	// Public functions are found in the shared table, unless calls are counted towards JIT compilation
+	const ELFScript::FunctionInfo *info = m_functions ? m_functions->getptr(function) : nullptr;
+	if (info != nullptr && !m_jit_armed) [[likely]] {
+		return info->address;
+	}
+	LookupEntry *entry = m_lookup.getptr(function);
+	if (entry != nullptr) [[likely]] {
+		if (m_jit_armed && ++entry->calls == m_jit_call_threshold) [[unlikely]] {
 			// Cheating a bit here, as we are in a const function
-			// But this does not functionally change the Machine, it only boosts performance a bit
-			const_cast<machine_t *>(m_machine)->cpu.create_fast_path_function(address);
+			// But compiling does not change the behavior of the Machine
+			const_cast<Sandbox *>(this)->start_jit_compilation();
 		}
-		m_lookup.insert_or_assign(hash, address);
-	} else {
-		address = it->second;
+		return entry->address;
 	}
 
-	return address;
-}
-
-gaddr_t Sandbox::cached_address_of(int64_t hash) const {
-	auto it = m_lookup.find(hash);
-	if (it != m_lookup.end()) {
-		return it->second;
+	if (info != nullptr) {
+		m_lookup.insert(function, LookupEntry{ gaddr_t(info->address) });
+		return info->address;
 	}
-	return 0;
+	const CharString ascii = String(function).ascii();
+	const std::string_view str{ ascii.get_data(), (size_t)ascii.length() };
+	const gaddr_t address = address_of(str);
+	if (address != 0x0) {
+		// Cheating a bit here, as we are in a const function
+		// But this does not functionally change the Machine, it only boosts performance a bit
+		const_cast<machine_t *>(m_machine)->cpu.create_fast_path_function(address);
+	}
+	m_lookup.insert(function, LookupEntry{ address });
+	return address;
 }
 
 gaddr_t Sandbox::address_of(std::string_view name) const {
@@ -558,7 +807,7 @@ gaddr_t Sandbox::address_of(std::string_view name) const {
 }
 
 bool Sandbox::has_function(const StringName &p_function) const {
-	const gaddr_t address = cached_address_of(p_function.hash(), p_function);
+	const gaddr_t address = cached_address_of(p_function);
 	return address != 0x0;
 }
 
@@ -569,6 +818,37 @@ int64_t Sandbox::get_heap_usage() const {
 	return 0;
 }
 
+// The execute segment and the function table belong to the program, and are
+// shared with every sandbox forked from the same template.
+static int64_t program_memory_usage(const machine_t &machine, const ELFScript::FunctionTable *functions) {
+	const auto &segment = machine.cpu.current_execute_segment();
+	int64_t usage = int64_t(segment.exec_end() - segment.exec_begin());
+	if (functions != nullptr) {
+		usage += functions->size() * int64_t(sizeof(StringName) + sizeof(ELFScript::FunctionInfo));
+	}
+	return usage;
+}
+
+int64_t Sandbox::get_instance_memory_usage() const {
+	if (!has_program_loaded()) {
+		return 0;
+	}
+	int64_t usage = int64_t(machine().memory.owned_pages_active()) * riscv::Page::size();
+	if (m_program_template == nullptr) {
+		usage += program_memory_usage(machine(), m_functions.get());
+	}
+	return usage;
+}
+
+int64_t Sandbox::get_shared_memory_usage() const {
+	if (!has_program_loaded() || m_program_template == nullptr) {
+		return 0;
+	}
+	// Pages that are not owned are the read-only pages of the template
+	const size_t shared_pages = machine().memory.pages_active() - machine().memory.owned_pages_active();
+	return int64_t(shared_pages) * riscv::Page::size() + program_memory_usage(machine(), m_functions.get());
+}
+
 //-- Scoped objects and variants --//
 
 unsigned Sandbox::add_scoped_variant(const Variant *value) const {
@@ -617,12 +897,133 @@ Variant &Sandbox::get_mutable_scoped_variant(unsigned index) {
 	return *it;
 }
 
-void Sandbox::add_scoped_object(const void *ptr) {
-	if (state().scoped_objects.size() >= this->m_max_refs) {
+unsigned Sandbox::owned_scoped_variant(unsigned index, Variant *&r_var) {
+	std::optional<const Variant *> var_opt = get_scoped_variant(index);
+	if (!var_opt.has_value()) {
+		ERR_PRINT("Invalid scoped variant index.");
+		throw std::runtime_error("Invalid scoped variant index.");
+	}
+	std::vector<Variant> &variants = state().variants;
+	const Variant *var = var_opt.value();
+	if (var >= variants.data() && var < variants.data() + variants.size()) {
+		r_var = &variants[var - variants.data()];
+		return index;
+	}
+	const unsigned new_index = this->create_scoped_variant(Variant(*var));
+	r_var = &variants.back();
+	return new_index;
+}
+
+static inline uint64_t scoped_object_handle(uint32_t index, uint32_t generation) {
+	return (uint64_t(generation) << 32) | (index + 1);
+}
+
+void Sandbox::track_scoped_object(uint64_t handle, bool host_provided) {
+	CurrentState &current = state();
+	if (host_provided) {
+		current.host_objects++;
+	} else if (current.scoped_objects.size() - current.host_objects >= this->m_max_refs) {
 		ERR_PRINT("Maximum number of scoped objects reached.");
 		throw std::runtime_error("Maximum number of scoped objects reached.");
 	}
-	state().scoped_objects.push_back(reinterpret_cast<uintptr_t>(ptr));
+	current.scoped_objects.push_back(handle);
+}
+
+uint64_t Sandbox::add_scoped_object(godot::Object *obj, bool host_provided) {
+	if (obj == nullptr) {
+		return 0;
+	}
+	const uint8_t level = uint8_t(this->m_current_state - this->m_states.data());
+	const uint64_t object_id = obj->get_instance_id();
+	const uint32_t *existing = m_scoped_object_ids.getptr(object_id);
+	if (existing != nullptr) {
+		ScopedObject &entry = m_scoped_objects[*existing];
+		const uint64_t handle = scoped_object_handle(*existing, entry.generation);
+		// An object acquired again by an outer call must live as long as that call
+		if (!entry.pinned && level < entry.level) {
+			this->track_scoped_object(handle, host_provided);
+			entry.level = level;
+		}
+		return handle;
+	}
+
+	uint32_t index;
+	if (!m_free_scoped_objects.empty()) {
+		index = m_free_scoped_objects.back();
+		m_free_scoped_objects.pop_back();
+	} else {
+		index = m_scoped_objects.size();
+		m_scoped_objects.emplace_back();
+	}
+	ScopedObject &entry = m_scoped_objects[index];
+	const uint64_t handle = scoped_object_handle(index, entry.generation);
+	try {
+		this->track_scoped_object(handle, host_provided);
+	} catch (...) {
+		m_free_scoped_objects.push_back(index);
+		throw;
+	}
+	entry.object = obj;
+	entry.owner = obj->_owner;
+	entry.object_id = object_id;
+	entry.level = level;
+	m_scoped_object_ids.insert(object_id, index);
+	return handle;
+}
+
+bool Sandbox::pin_scoped_object(uint64_t handle) {
+	ScopedObject *entry = this->scoped_object_entry(handle);
+	if (entry == nullptr || entry->object == nullptr) {
+		return false;
+	}
+	if (!entry->pinned) {
+		if (m_pinned_objects >= this->m_max_refs) {
+			ERR_PRINT("Maximum number of pinned objects reached.");
+			return false;
+		}
+		entry->pinned = true;
+		m_pinned_objects++;
+	}
+	return true;
+}
+
+bool Sandbox::unpin_scoped_object(uint64_t handle) {
+	ScopedObject *entry = this->scoped_object_entry(handle);
+	if (entry == nullptr || !entry->pinned) {
+		return false;
+	}
+	this->track_scoped_object(handle, false);
+	entry->pinned = false;
+	entry->level = uint8_t(this->m_current_state - this->m_states.data());
+	m_pinned_objects--;
+	return true;
+}
+
+void Sandbox::release_scoped_objects(CurrentState &state) {
+	const uint8_t level = uint8_t(&state - this->m_states.data());
+	for (const uint64_t handle : state.scoped_objects) {
+		ScopedObject *entry = this->scoped_object_entry(handle);
+		// Objects that were pinned, or handed over to an outer call, are kept
+		if (entry == nullptr || entry->pinned || entry->level != level) {
+			continue;
+		}
+		m_scoped_object_ids.erase(entry->object_id);
+		*entry = ScopedObject{ .generation = entry->generation + 1 };
+		m_free_scoped_objects.push_back(entry - m_scoped_objects.data());
+	}
+	state.scoped_objects.clear();
+	state.host_objects = 0;
+}
+
+void Sandbox::clear_scoped_objects() {
+	m_scoped_objects.clear();
+	m_free_scoped_objects.clear();
+	m_scoped_object_ids.clear();
+	m_pinned_objects = 0;
+	for (CurrentState &state : this->m_states) {
+		state.scoped_objects.clear();
+		state.host_objects = 0;
+	}
 }
 
 //-- Properties --//
@@ -703,9 +1104,27 @@ bool Sandbox::set_property(const StringName &name, const Variant &value) {
 	} else if (name == StringName("execution_timeout")) {
 		set_instructions_max(value);
 		return true;
+	} else if (name == StringName("frame_budget_weight")) {
+		set_frame_budget_weight(value);
+		return true;
 	} else if (name == StringName("use_unboxed_arguments")) {
 		set_use_unboxed_arguments(value);
 		return true;
+	} else if (name == StringName("use_program_template")) {
+		set_use_program_template(value);
+		return true;
+	} else if (name == StringName("use_binary_translation")) {
+		set_use_binary_translation(value);
+		return true;
+	} else if (name == StringName("use_jit_compilation")) {
+		set_use_jit_compilation(value);
+		return true;
+	} else if (name == StringName("profiling")) {
+		set_profiling(value);
+		return true;
+	} else if (name == StringName("syscall_tracing")) {
+		set_syscall_tracing(value);
+		return true;
 	}
 	return false;
 }
@@ -731,21 +1150,57 @@ bool Sandbox::get_property(const StringName &name, Variant &r_ret) {
 	} else if (name == StringName("execution_timeout")) {
 		r_ret = get_instructions_max();
 		return true;
+	} else if (name == StringName("frame_budget_weight")) {
+		r_ret = get_frame_budget_weight();
+		return true;
 	} else if (name == StringName("use_unboxed_arguments")) {
 		r_ret = get_use_unboxed_arguments();
 		return true;
+	} else if (name == StringName("use_program_template")) {
+		r_ret = get_use_program_template();
+		return true;
+	} else if (name == StringName("use_binary_translation")) {
+		r_ret = get_use_binary_translation();
+		return true;
+	} else if (name == StringName("use_jit_compilation")) {
+		r_ret = get_use_jit_compilation();
+		return true;
+	} else if (name == StringName("profiling")) {
+		r_ret = get_profiling();
+		return true;
+	} else if (name == StringName("syscall_tracing")) {
+		r_ret = get_syscall_tracing();
+		return true;
 	} else if (name == StringName("monitor_heap_usage")) {
 		r_ret = get_heap_usage();
 		return true;
+	} else if (name == StringName("monitor_instance_memory_usage")) {
+		r_ret = get_instance_memory_usage();
+		return true;
+	} else if (name == StringName("monitor_shared_memory_usage")) {
+		r_ret = get_shared_memory_usage();
+		return true;
 	} else if (name == StringName("monitor_exceptions")) {
 		r_ret = get_exceptions();
 		return true;
 	} else if (name == StringName("monitor_execution_timeouts")) {
 		r_ret = get_timeouts();
 		return true;
+	} else if (name == StringName("monitor_frame_budget_overruns")) {
+		r_ret = get_frame_budget_overruns();
+		return true;
+	} else if (name == StringName("monitor_global_frame_budget_overruns")) {
+		r_ret = get_global_frame_budget_overruns();
+		return true;
 	} else if (name == StringName("monitor_calls_made")) {
 		r_ret = get_calls_made();
 		return true;
+	} else if (name == StringName("monitor_jit_compiled_functions")) {
+		r_ret = get_jit_compiled_functions();
+		return true;
+	} else if (name == StringName("monitor_jit_compile_time")) {
+		r_ret = get_jit_compile_time();
+		return true;
 	} else if (name == StringName("global_calls_made")) {
 		r_ret = get_global_calls_made();
 		return true;
@@ -3,8 +3,12 @@
 #include <godot_cpp/classes/control.hpp>
 
 #include <godot_cpp/core/binder_common.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
 #include <godot_cpp/templates/hash_set.hpp>
 #include <libriscv/machine.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <optional>
 
 using namespace godot;
@@ -12,6 +16,7 @@ using namespace godot;
 using gaddr_t = riscv::address_type<RISCV_ARCH>;
 using machine_t = riscv::Machine<RISCV_ARCH>;
 #include "elf/script_elf.h"
+#include "syscalls.h"
 #include "vmcallable.h"
 #include "vmproperty.h"
 
@@ -28,6 +33,9 @@ using machine_t = riscv::Machine<RISCV_ARCH>;
  * 5. Run the program through to its main() function.
  * 6. Read the program's properties. These will be visible to the Godot editor.
  * 7. Pre-cache some public functions. These will be available to call from GDScript.
+ *
+ * Steps 2-7 are normally done only once per program: the ELFScript keeps a template Sandbox that has
+ * already returned from main(), and new Sandboxes are forked copy-on-write from it instead.
  **/
 class Sandbox : public Node {
 	GDCLASS(Sandbox, Node);
@@ -45,11 +53,17 @@ public:
 	static constexpr unsigned MAX_REFS = 100; // Default maximum number of references
 	static constexpr unsigned EDITOR_THROTTLE = 8; // Throttle VM calls from the editor
 	static constexpr unsigned MAX_PROPERTIES = 16; // Maximum number of sandboxed properties
+	static constexpr int HEAP_SYSCALLS_BASE = 480; // Native heap system calls
+	static constexpr int MEMORY_SYSCALLS_BASE = 485; // Native memory system calls
+	static constexpr unsigned TRACED_SYSCALLS = 64; // Godot API system calls that can be traced
+	static constexpr gaddr_t MAPPED_ARRAYS_AREA = gaddr_t(1) << 40; // Guest addresses of mapped packed arrays
+	static constexpr gaddr_t MAPPED_ARRAYS_AREA_SIZE = gaddr_t(1) << 36;
 
 	struct CurrentState {
 		std::vector<Variant> variants;
 		std::vector<const Variant *> scoped_variants;
-		std::vector<uintptr_t> scoped_objects;
+		std::vector<uint64_t> scoped_objects; // Handles acquired at this level
+		uint32_t host_objects = 0; // Of those, objects provided by the host, which are not limited by max refs
 
 		void append(Variant &&value);
 		void initialize(unsigned max_refs);
@@ -79,6 +93,23 @@ public:
 	/// @param arg_count The number of arguments.
 	/// @return The return value of the function call.
 	Variant vmcall_fn(const StringName &function, const Variant **args, GDExtensionInt arg_count);
+	/// @brief Make a function call to a public function of a program, found in the function table of the program.
+	/// When this sandbox runs the program, the address in the table is used without looking up the name again.
+	/// @param function The name of the function to call.
+	/// @param script The program that has the function.
+	/// @param info The function, as found in the function table of the program.
+	/// @param args The arguments to pass to the function.
+	/// @param arg_count The number of arguments.
+	/// @return The return value of the function call.
+	Variant vmcall_fn(const StringName &function, const ELFScript &script, const ELFScript::FunctionInfo &info, const Variant **args, GDExtensionInt arg_count);
+	/// @brief Make a function call to a function in the guest by its name, allowing it to access a batch of objects.
+	/// @param function The name of the function to call.
+	/// @param objects The objects the guest may access during the call. They are passed as a PackedInt64Array
+	/// of object handles, in front of the other arguments.
+	/// @param args The arguments to pass to the function.
+	/// @param arg_count The number of arguments.
+	/// @return The return value of the function call.
+	Variant vmcall_with_objects(const StringName &function, const std::vector<godot::Object *> &objects, const Variant **args, GDExtensionInt arg_count);
 	/// @brief Make a function call to a function in the guest by its guest address.
 	/// @param address The address of the function to call.
 	/// @param args The arguments to pass to the function.
@@ -87,6 +118,85 @@ public:
 	/// @return The return value of the function call.
 	Variant vmcall_address(gaddr_t address, const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error);
 
+	/// @brief Call a function in the guest once for each argument tuple in a batch, entering the VM only once.
+	/// @param function The name of the function to call.
+	/// @param args An Array of argument Arrays, or a PackedInt64Array or PackedFloat32Array of flattened argument tuples.
+	/// @param arity The number of arguments per tuple, when the arguments are packed.
+	/// @return An Array of results for an Array of arguments, otherwise a packed array of the same type as the arguments.
+	/// Returns null if the batch was aborted by an exception.
+	/// @note The instruction limit applies to each call in the batch separately.
+	Variant vmcall_batch(const String &function, const Variant &args, int arity = 0);
+
+	/// @brief Call a function in many sandboxes at once, each sandbox on a thread of the WorkerThreadPool,
+	/// and wait for all of them. System calls that change the scene, such as setting a property, calling
+	/// a method or adding a child, are recorded instead, and applied on the main thread once every call
+	/// has finished, sandbox by sandbox in the order given, so that the outcome doesn't depend on threading.
+	/// @param sandboxes The sandboxes to call. Each sandbox may only appear once.
+	/// @param function The name of the function to call.
+	/// @param args The arguments to pass to the function, the same for each sandbox.
+	/// @return The return value of each call, in the same order as the sandboxes. Null for a sandbox
+	/// that could not be called, or whose call threw an exception.
+	/// @note Recorded system calls return nothing to the guest. Reading nodes that are in the scene
+	/// tree is subject to the thread guards of Godot, so parallel functions should work on their own
+	/// state and their arguments.
+	static Array call_parallel(const Array &sandboxes, const StringName &function, const Array &args = Array());
+	/// @brief Check if this sandbox is running on a worker thread in call_parallel().
+	bool is_in_parallel_call() const { return m_in_parallel_call; }
+	/// @brief Check if this sandbox is a fork that runs async calls or parallel_map() on worker threads.
+	/// Worker forks can't access any objects.
+	bool is_worker_fork() const { return m_worker_fork; }
+	/// @brief Check if a Variant is, or contains, an Object or a Callable or Signal that refers to one.
+	/// Containers that are nested too deep, or that contain themselves, count as containing an object.
+	static bool contains_object(const Variant &var, unsigned depth = 0);
+	/// @brief Record a method call on an object, made on the main thread when the parallel call has finished.
+	/// @param object The object to call. It is looked up again by its ID, in case it has been freed.
+	/// @param method The name of the method.
+	/// @param args The arguments to the method.
+	void defer_command(godot::Object *object, const StringName &method, Array &&args);
+
+	/// @brief Start a call to a function in the guest that runs for a limited number of instructions per frame.
+	/// The call is suspended when the budget runs out, and resumed on the next frame, until it returns. Then
+	/// the sliced_call_finished signal is emitted with the return value, or null if the call threw an exception.
+	/// @param args The name of the function, the instruction budget per frame, and the arguments to pass to the function.
+	/// @param arg_count The number of arguments.
+	/// @param error The error code, if any.
+	/// @return True if the call was started.
+	/// @note Only one sliced call can run at a time. Other calls can be made while it is suspended.
+	/// The execution timeout does not apply to sliced calls, as each slice is already limited.
+	Variant vmcall_sliced(const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error);
+	/// @brief Check if a sliced call has been started and has not yet finished.
+	bool is_sliced_call_active() const { return m_sliced_call.active; }
+	/// @brief Stop a suspended sliced call without finishing it. The finished signal is not emitted.
+	void cancel_sliced_call();
+
+	/// @brief Map a packed array through a guest function, in chunks, on worker threads.
+	/// The chunks are spread over forks of the program template, one per thread, which are kept
+	/// for the next call. The function is called with each chunk as a packed array of the same type,
+	/// and must return a packed array of the same type and size, which is copied into the output.
+	/// The forks are restricted like those of vmcall_async().
+	/// @param function The name of the function to call for each chunk.
+	/// @param data A PackedByteArray, PackedFloat32Array or PackedVector3Array.
+	/// @param chunk_size The number of elements per chunk. The last chunk may be smaller.
+	/// @return The mapped array, of the same type and size as data, or null if a chunk failed.
+	/// @note Chunks share no state, so the function must not rely on globals set by other chunks.
+	Variant parallel_map(const StringName &function, const Variant &data, int64_t chunk_size);
+
+	/// @brief Start a call to a pure compute function in the guest on a worker thread.
+	/// The call runs in a new fork of the program template, so it can't see or change the state of this
+	/// sandbox. The fork is restricted, and only allowed the system calls that work on Variants and math.
+	/// When the call returns, the async_call_finished signal is emitted on the main thread with the
+	/// handle of the call and its return value, or null if the call threw an exception.
+	/// Calls that are still running when this sandbox is freed are waited for, and their results dropped.
+	/// @param args The name of the function, and the arguments to pass to the function.
+	/// @param arg_count The number of arguments.
+	/// @param error The error code, if any.
+	/// @return A handle for the call, or -1 if it could not be started.
+	/// @note Arguments cannot be objects, callables or signals. Arrays and dictionaries are deep-copied.
+	/// Requires a program that can be used as a program template.
+	Variant vmcall_async(const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error);
+	/// @brief Get the number of async calls started by this sandbox that have not yet finished.
+	int64_t get_async_calls_pending() const { return m_async_forks.size(); }
+
 	/// @brief Make a function call to a function in the guest by its name.
 	/// @param function The name of the function to call.
 	/// @param args The arguments to pass to the function.
@@ -104,6 +214,36 @@ public:
 	/// @return True if register values are preferred, false if Variant values are preferred.
 	bool get_use_unboxed_arguments() const { return m_use_unboxed_arguments; }
 
+	/// @brief Set whether to run ahead-of-time translated native code for the program, when it is available.
+	/// @param use_binary_translation True to run translated code, false to always use the interpreter.
+	void set_use_binary_translation(bool use_binary_translation) { m_use_binary_translation = use_binary_translation; }
+	/// @brief Get whether ahead-of-time translated native code is used, when it is available.
+	/// @return True if translated code is used, false otherwise.
+	bool get_use_binary_translation() const { return m_use_binary_translation; }
+
+	/// @brief Set whether to JIT-compile the program in the background once one of its functions becomes hot.
+	/// @param use_jit_compilation True to JIT-compile hot programs, false to keep interpreting them.
+	/// @note Only has an effect when the extension is built with libtcc, and no ahead-of-time translation is in use.
+	void set_use_jit_compilation(bool use_jit_compilation) { m_use_jit_compilation = use_jit_compilation; }
+	/// @brief Get whether the program is JIT-compiled once one of its functions becomes hot.
+	/// @return True if hot programs are JIT-compiled, false otherwise.
+	bool get_use_jit_compilation() const { return m_use_jit_compilation; }
+
+	/// @brief Set whether to fork the program from its pre-initialized template, instead of loading it from scratch.
+	/// @param use_program_template True to fork from the program template, false to always load the program.
+	void set_use_program_template(bool use_program_template) { m_use_program_template = use_program_template; }
+	/// @brief Get whether the program is forked from its pre-initialized template.
+	/// @return True if the program is forked from the program template, false otherwise.
+	bool get_use_program_template() const { return m_use_program_template; }
+
+	/// @brief Set whether to profile the guest functions called on this sandbox.
+	/// @param profiling True to collect per-function call counts, instructions, wall time and latencies.
+	/// @note While disabled, profiling costs a single branch per call.
+	void set_profiling(bool profiling);
+	/// @brief Get whether the guest functions called on this sandbox are being profiled.
+	/// @return True if profiling is enabled, false otherwise.
+	bool get_profiling() const { return m_profiling; }
+
 	// -= Sandbox Properties =-
 
 	uint32_t get_max_refs() const { return m_max_refs; }
@@ -114,16 +254,41 @@ public:
 	int64_t get_instructions_max() const { return m_insn_max; }
 	void set_heap_usage(int64_t) {} // Do nothing (it's a read-only property)
 	int64_t get_heap_usage() const;
+	/// @brief Get the memory owned by this sandbox alone, ie. its written pages and, unless forked, its program.
+	int64_t get_instance_memory_usage() const;
+	/// @brief Get the memory this sandbox shares with the other sandboxes of its program, ie. the
+	/// execute segment, the read-only pages and the function table of the template it was forked from.
+	int64_t get_shared_memory_usage() const;
 	void set_exceptions(unsigned exceptions) {} // Do nothing (it's a read-only property)
 	unsigned get_exceptions() const { return m_exceptions; }
 	void set_timeouts(unsigned budget) {} // Do nothing (it's a read-only property)
 	unsigned get_timeouts() const { return m_timeouts; }
 	void set_calls_made(unsigned calls) {} // Do nothing (it's a read-only property)
 	unsigned get_calls_made() const { return m_calls_made; }
+	/// @brief Get the number of public functions of the program that run JIT-compiled code.
+	/// The whole program is compiled at once, so this is every public function once it's compiled, and 0 before.
+	unsigned get_jit_compiled_functions() const;
+	double get_jit_compile_time() const;
+
+	/// @brief Set the global instruction budget per frame, which is shared by all sandboxes.
+	/// @param budget The budget in millions of instructions, or 0 for no budget.
+	static void set_frame_instruction_budget(int64_t budget);
+	static int64_t get_frame_instruction_budget();
+	/// @brief Set the weight of this sandbox in the frame budget. Each sandbox may execute a share
+	/// of the budget every frame, in proportion to its weight among all sandboxes.
+	/// @param weight The weight, where 0 means that the sandbox can't run while there is a budget.
+	void set_frame_budget_weight(double weight);
+	double get_frame_budget_weight() const { return m_frame_budget_weight; }
+	/// @brief Get the number of instructions this sandbox may execute each frame, or 0 if there is no budget.
+	int64_t get_frame_instruction_share() const;
+	void set_frame_budget_overruns(unsigned) {} // Do nothing (it's a read-only property)
+	/// @brief Get the number of calls that were skipped or stopped because this sandbox used up its share of a frame.
+	unsigned get_frame_budget_overruns() const { return m_frame_budget_overruns; }
 
 	static uint64_t get_global_timeouts() { return m_global_timeouts; }
 	static uint64_t get_global_exceptions() { return m_global_exceptions; }
 	static uint64_t get_global_calls_made() { return m_global_calls_made; }
+	static uint64_t get_global_frame_budget_overruns() { return m_global_frame_budget_overruns; }
 
 	/// @brief Get the global instance count of all sandbox instances.
 	/// @return The global instance count.
@@ -133,11 +298,112 @@ public:
 	/// @return The accumulated startup time.
 	static double get_accumulated_startup_time() { return m_accumulated_startup_time; }
 
+	// -= Profiling =-
+
+	/// @brief Get the profile of each guest function called while profiling was enabled.
+	/// @return A Dictionary keyed by function name. Each entry holds the number of calls, instructions
+	/// retired and exceptions, and the total wall time and p50/p95/p99 latencies in seconds.
+	Dictionary get_profile() const;
+	/// @brief Discard the collected profile, and its performance monitors.
+	void clear_profile();
+
+	/// @brief Start sampling the guest call stack every given number of instructions, discarding earlier samples.
+	/// @param interval The number of guest instructions between samples.
+	/// @note Sampling is driven by the instruction counter, so the same calls always produce the same samples.
+	/// Stacks are walked through the frame pointer chain, which requires programs built with frame pointers.
+	void start_sampling(int64_t interval);
+	/// @brief Stop sampling the guest call stack, keeping the samples taken so far.
+	void stop_sampling();
+	/// @brief Get the number of call stack samples taken since sampling was started.
+	/// @return The number of samples.
+	int64_t get_sample_count() const;
+	/// @brief Save the call stack samples, eg. to user://. Paths ending in .json are written as a Chrome trace,
+	/// anything else as folded stacks, one line per unique stack, for use with flamegraph tools.
+	/// @param path The path of the file to write.
+	/// @return True if the file was written, false otherwise.
+	bool save_samples(const String &path) const;
+
+	// -= System Call Tracing =-
+
+	/// @brief Set whether to trace the Godot API system calls made by the program.
+	/// @param syscall_tracing True to record the calls, host time and bytes copied of each system call.
+	/// @note The system call handlers are only wrapped while at least one sandbox is being traced.
+	void set_syscall_tracing(bool syscall_tracing);
+	/// @brief Get whether the Godot API system calls made by the program are being traced.
+	/// @return True if system calls are traced, false otherwise.
+	bool get_syscall_tracing() const { return m_syscall_tracing; }
+	/// @brief Get the traced system calls of this sandbox.
+	/// @return A Dictionary keyed by system call name, with the number of calls, the host time in seconds
+	/// and the number of bytes copied between the guest and the host.
+	Dictionary get_syscall_trace() const;
+	/// @brief Get the traced system calls of all sandboxes.
+	/// @return A Dictionary in the same format as get_syscall_trace().
+	static Dictionary get_global_syscall_trace();
+	/// @brief Save each traced system call as a span in a Chrome trace, with one marker per engine frame.
+	/// The timestamps use the same clock as Time.get_ticks_usec().
+	/// @param path The path of the file to write.
+	/// @return True if the file was written, false otherwise.
+	bool save_syscall_trace(const String &path) const;
+	/// @brief Discard the traced system calls of this sandbox.
+	void clear_syscall_trace();
+	/// @brief Get the name of a Godot API system call, as used in system call traces and cost tables.
+	/// @param index The system call number, relative to GAME_API_BASE.
+	/// @return The name of the system call.
+	static String syscall_name(unsigned index);
+	/// @brief Count bytes copied between the guest and the host by the current system call,
+	/// and charge them at the per-byte cost of the system call.
+	/// @param ecall The system call number.
+	/// @param bytes The number of bytes copied.
+	void add_syscall_bytes(int ecall, uint64_t bytes) {
+		m_syscall_bytes += bytes;
+		m_machine->penalize(uint64_t(bytes * m_syscall_costs[ecall - GAME_API_BASE].per_byte));
+	}
+
+	// -= System Call Costs =-
+
+	struct SyscallCost {
+		uint32_t base = 0; // in instructions
+		float per_byte = 0.0f; // in instructions per byte copied
+	};
+
+	/// @brief Charge the cost of a Godot API system call to the instruction counter. Bytes copied by
+	/// the system call are charged by add_syscall_bytes(), using the per-byte cost of the system call.
+	/// @param ecall The system call number.
+	void penalize_syscall(int ecall) {
+		m_machine->penalize(m_syscall_costs[ecall - GAME_API_BASE].base);
+	}
+	/// @brief Measure the cost of each traced system call, and use it as the cost of the system call in all sandboxes.
+	/// The host time of each call is fitted to a base cost plus a cost per byte copied, and converted to instructions.
+	/// @param instructions_per_second The speed of the guest on this host, eg. from get_profile().
+	/// @return The new cost table, in the same format as get_syscall_costs().
+	/// @note Requires syscall_tracing, and only system calls that were traced are changed.
+	Dictionary calibrate_syscall_costs(double instructions_per_second);
+	/// @brief Get the cost of each Godot API system call that has a cost.
+	/// @return A Dictionary keyed by system call name, with the base cost and the cost per byte, in instructions.
+	static Dictionary get_syscall_costs();
+	/// @brief Set the cost of Godot API system calls in all sandboxes.
+	/// @param costs A Dictionary in the same format as get_syscall_costs(). Unlisted system calls are unchanged.
+	static void set_syscall_costs(const Dictionary &costs);
+	/// @brief Save the system call cost table as JSON, eg. to be used with the syscall cost table project setting.
+	/// @param path The path of the file to write.
+	/// @return True if the file was written, false otherwise.
+	static bool save_syscall_costs(const String &path);
+	/// @brief Load a system call cost table that was saved with save_syscall_costs().
+	/// @param path The path of the file to read.
+	/// @return True if the table was loaded, false otherwise.
+	static bool load_syscall_costs(const String &path);
+
 	// -= Address Lookup =-
 
 	gaddr_t address_of(std::string_view name) const;
-	gaddr_t cached_address_of(int64_t hash) const;
-	gaddr_t cached_address_of(int64_t hash, const String &name) const;
+	/// @brief Get the address of a function in the guest, looking it up and caching it on first use.
+	/// @param name The interned name of the function.
+	/// @return The address of the function, or 0 if it does not exist.
+	gaddr_t cached_address_of(const StringName &name) const;
+	/// @brief Find where a function is defined in the source code of the program, using its debug information.
+	/// @param function The name of the function.
+	/// @return A Dictionary with the "file" and "line", or an empty Dictionary if the location is unknown.
+	Dictionary get_source_location(const String &function) const;
 
 	/// @brief Check if a function exists in the guest program.
 	/// @param p_function The name of the function to check.
@@ -176,23 +442,104 @@ public:
 	/// @return The variant, or an empty optional if the index is invalid.
 	std::optional<const Variant *> get_scoped_variant(unsigned idx) const noexcept;
 
+	/// @brief Get a scoped variant that can be modified in place, in the current state. A variant that
+	/// belongs to the caller, like a function argument, is first copied into a new scoped variant.
+	/// @param idx The index of the variant.
+	/// @param r_var Receives the variant that can be modified.
+	/// @return The index of the variant that can be modified, which is idx unless it was copied.
+	unsigned owned_scoped_variant(unsigned idx, Variant *&r_var);
+
+	/// @brief Map the buffer of a packed array into the guest, without copying it, until the current call returns.
+	/// @param array The packed array to map.
+	/// @param writable If true, the guest writes into a private copy of the array, held by a new scoped variant.
+	/// @param r_index Receives the index of the new scoped variant, when writable.
+	/// @param r_bytes Receives the size of the array in bytes.
+	/// @return The guest address of the first element, or 0 if the array is empty.
+	gaddr_t map_packed_array(const Variant &array, bool writable, unsigned &r_index, size_t &r_bytes);
+	/// @brief Unmap the packed arrays that were mapped at or above a call level.
+	/// @param level The call level.
+	void unmap_arrays(unsigned level);
+
 	/// @brief Get a mutable scoped variant by its index.
 	/// @param idx The index of the variant to get.
 	/// @return The variant.
 	Variant &get_mutable_scoped_variant(unsigned idx);
 
-	/// @brief Add a scoped object to the current state.
-	/// @param ptr The pointer to the object to add.
-	void add_scoped_object(const void *ptr);
-
-	/// @brief Remove a scoped object from the current state.
-	/// @param ptr The pointer to the object to remove.
-	void rem_scoped_object(const void *ptr) { state().scoped_objects.erase(std::remove(state().scoped_objects.begin(), state().scoped_objects.end(), reinterpret_cast<uintptr_t>(ptr)), state().scoped_objects.end()); }
+	/// @brief Give the guest access to an object for the duration of the current call.
+	/// @param obj The object to add.
+	/// @param host_provided True for objects that the host hands to the guest, like the nodes of a
+	/// process group, which are not limited by the maximum number of references.
+	/// @return The handle the guest uses to refer to the object, or 0 for a null object.
+	uint64_t add_scoped_object(godot::Object *obj, bool host_provided = false);
+
+	/// @brief Look up a scoped object by its handle.
+	/// @param handle The handle of the object, as given to the guest.
+	/// @return The object, or nullptr if the handle is stale or the object has been freed.
+	godot::Object *get_scoped_object(uint64_t handle) const noexcept;
+
+	/// @brief Keep a scoped object accessible across calls, until it is unpinned.
+	/// @param handle The handle of the object.
+	/// @return True if the object is pinned, false if the handle is invalid or too many objects are pinned.
+	bool pin_scoped_object(uint64_t handle);
+
+	/// @brief Return a pinned object to the current call, which releases it when it ends.
+	/// @param handle The handle of the object.
+	/// @return True if the object was pinned, false otherwise.
+	bool unpin_scoped_object(uint64_t handle);
+
+	/// @brief Get the number of objects currently pinned by the guest.
+	/// @return The number of pinned objects.
+	uint32_t get_pinned_objects() const noexcept { return m_pinned_objects; }
+
+	// -= Guest Names =-
+
+	/// @brief Get a method or property name that the guest passed as an address and a length.
+	/// Names in the read-only data of the program, like string literals, never change, so they are
+	/// looked up by their address after the first time, instead of being hashed again.
+	/// @param address The guest address of the name, or the handle of an interned name.
+	/// @param length The length of the name, or INTERNED_NAME_LENGTH for an interned name.
+	/// @return The name.
+	/// @throw std::runtime_error If the name is not readable, or the interned name handle is invalid.
+	StringName guest_name(gaddr_t address, unsigned length);
+	/// @brief Intern a name, so that the guest can pass it by its handle.
+	/// @param name The name.
+	/// @return The handle of the name. The same name always gets the same handle.
+	/// @throw std::runtime_error If there are too many interned names.
+	unsigned intern_name(const StringName &name);
+
+	// -= Method Handles =-
+
+	struct MethodBindInfo;
+	struct MethodHandle {
+		Variant::Type type = Variant::NIL; // OBJECT, or the builtin type that has the method
+		StringName class_name; // For methods of objects
+		StringName method; // For calls by name
+		// The direct call, if the method is in the table of engine methods that can be ptrcalled
+		const MethodBindInfo *bind_info = nullptr;
+		GDExtensionMethodBindPtr method_bind = nullptr; // For methods of objects
+		void *class_tag = nullptr; // The class that has the method, for methods of objects
+		GDExtensionPtrBuiltInMethod builtin_method = nullptr; // For methods of builtin types
+	};
 
-	/// @brief Check if an object is scoped in the current state.
-	/// @param ptr The pointer to the object to check.
-	/// @return True if the object is scoped, false otherwise.
-	bool is_scoped_object(const void *ptr) const noexcept { return state().scoped_objects.end() != std::find(state().scoped_objects.begin(), state().scoped_objects.end(), reinterpret_cast<uintptr_t>(ptr)); }
+	/// @brief Resolve a method once, so that the guest can call it many times by its handle.
+	/// Engine methods that take and return only values stored in a GuestVariant are called directly,
+	/// with a ptrcall on their method bind, when the argument types match. Other methods, and other
+	/// arguments, are called by name.
+	/// @param type Variant::OBJECT for a method of a class, otherwise the builtin type that has the method.
+	/// @param class_name The class that has the method, for Variant::OBJECT.
+	/// @param method The name of the method.
+	/// @return The handle of the method. The same method always gets the same handle.
+	/// @throw std::runtime_error If the class doesn't have the method, or there are too many handles.
+	unsigned resolve_method_handle(Variant::Type type, const StringName &class_name, const StringName &method);
+	/// @brief Get a method that was resolved with resolve_method_handle().
+	/// @throw std::runtime_error If the handle is invalid.
+	const MethodHandle &get_method_handle(unsigned handle) const;
+	/// @brief Call a method of an object directly, if it has a method bind and the arguments match its signature.
+	/// @return True if the method was called, false if it must be called by name instead.
+	bool call_fast_method(const MethodHandle &handle, godot::Object *obj, const GuestVariant *args, unsigned argc, Variant &r_ret) const;
+	/// @brief Call a method of a builtin type directly, if it has a method bind and the arguments match its signature.
+	/// @return True if the method was called, false if it must be called by name instead.
+	bool call_fast_method(const MethodHandle &handle, const GuestVariant &self, const GuestVariant *args, unsigned argc, Variant &r_ret) const;
 
 	// -= Sandbox Restrictions =-
 
@@ -275,14 +622,61 @@ public:
 	/// @return Array of public callable functions.
 	PackedStringArray get_functions() const;
 	struct BinaryInfo {
+		struct Property {
+			String name;
+			Variant::Type type;
+		};
 		String language;
 		PackedStringArray functions;
+		std::vector<gaddr_t> addresses; // In the same order as functions
+		std::vector<Property> properties; // Sandboxed properties, without their default values
 		int version = 0;
+		uint32_t hash = 0; // CRC32-C of the program, set by the metadata cache
 	};
-	/// @brief Get information about the program from the binary.
+	/// @brief Get information about the program from the binary, by scanning its ELF headers in place
+	/// without constructing a machine.
 	/// @param binary The binary data.
 	/// @return An array of public callable functions and programming language.
 	static BinaryInfo get_program_info_from_binary(const PackedByteArray &binary);
+	static BinaryInfo get_program_info_from_binary(std::string_view binary);
+
+	/// @brief Create a template Sandbox for a program, which has been run through to its main() function.
+	/// @param binary The program binary. The template keeps its own reference to it.
+	/// @param snapshot_path If not empty, warm-start the template from this snapshot, or create the snapshot if it's missing or stale.
+	/// @return The template, or null if the program failed to initialize.
+	/// @note Forks borrow pages from the template machine, so every fork keeps the template alive.
+	static std::shared_ptr<Sandbox> create_program_template(const PackedByteArray &binary, const String &snapshot_path = String());
+
+	// -= Binary translation =-
+
+	/// @brief Translate the current program into a native shared object, and store it in the translation
+	/// cache next to the imported resources. The cache is keyed by the program hash, so a rebuilt program
+	/// is never matched with a stale translation. Requires a system C compiler.
+	/// @return True if a translation for the program is available in the cache afterwards.
+	bool generate_binary_translation() const;
+	/// @brief Translate a program into the translation cache, unless it is already there.
+	/// @param binary The program binary.
+	/// @return True if a translation for the program is available in the cache afterwards.
+	static bool generate_binary_translation_for(const PackedByteArray &binary);
+	/// @brief Check if the loaded program is running translated native code.
+	/// @return True if the program is running translated code, false if it is interpreted.
+	bool is_binary_translated() const;
+	/// @brief Check if the program has been JIT-compiled, and is now running native code.
+	/// @return True if the JIT-compiled code is live, false otherwise.
+	bool is_jit_compiled() const;
+
+	// -= Snapshots =-
+
+	/// @brief Save the current program state to a snapshot file. The snapshot includes the machine
+	/// registers and memory, the native heap and the permanent Variants of the program.
+	/// @param path The path of the snapshot file.
+	/// @return True if the snapshot was saved, false otherwise.
+	/// @note Programs that hold on to objects during initialization cannot be snapshotted.
+	bool save_snapshot(const String &path) const;
+	/// @brief Restore the program state from a snapshot file, skipping ELF loading and the program's initialization.
+	/// @param path The path of the snapshot file.
+	/// @return True if the snapshot was loaded, false if it was missing, incompatible or made from another program.
+	bool load_snapshot(const String &path);
 
 	// -= Self-testing, inspection and internal functions =-
 
@@ -304,39 +698,207 @@ public:
 
 	/// @brief Resume execution of the program. Loses the current call state.
 	void resume(uint64_t max_instructions);
+	void resume_sliced_call();
 
 	void assault(const String &test, int64_t iterations);
 	void print(std::string_view text);
-	Variant vmcall_internal(gaddr_t address, const Variant **args, int argc);
+	Variant vmcall_internal(gaddr_t address, const Variant **args, int argc, const std::vector<godot::Object *> *objects = nullptr);
 	machine_t &machine() { return *m_machine; }
 	const machine_t &machine() const { return *m_machine; }
 
 private:
 	void load(const PackedByteArray *vbuf, const std::vector<std::string> *argv = nullptr);
+	bool load_from_template(const std::shared_ptr<Sandbox> &program_template);
+	/// @brief Fork the program template of this sandbox, to run calls on a worker thread.
+	/// The fork is restricted, and only allowed the system calls that work on Variants and math.
+	/// @return The fork, owned by the caller, or null if the program has no template.
+	Sandbox *create_worker_fork() const;
+	std::shared_ptr<Sandbox> worker_fork_template() const;
+	/// @brief Get at least count forks for parallel_map(), kept between calls, or fewer if forking fails.
+	const std::vector<Sandbox *> &worker_forks(size_t count);
+	void free_worker_forks();
+	bool load_snapshot_internal(const PackedByteArray *buffer, const String &path);
+	riscv::MachineOptions<RISCV_ARCH> machine_options();
+#ifdef RISCV_BINARY_TRANSLATION
+	static bool apply_translation_options(const PackedByteArray &binary, riscv::MachineOptions<RISCV_ARCH> &options, bool generate);
+	void apply_jit_options(riscv::MachineOptions<RISCV_ARCH> &options);
+#endif
+	void start_jit_compilation();
+	void jit_compile();
+	void finish_jit_compilation();
+	void setup_machine();
+	void precache_functions() const;
 	void read_program_properties(bool editor) const;
 	void handle_exception(gaddr_t);
 	void handle_timeout(gaddr_t);
 	void print_backtrace(gaddr_t);
 	void initialize_syscalls();
 	GuestVariant *setup_arguments(gaddr_t &sp, const Variant **args, int argc);
+	template <typename ArgumentsFn, typename ResultFn>
+	bool run_batch(gaddr_t address, int64_t count, ArgumentsFn &&arguments, ResultFn &&result);
+	template <typename T, typename PackedT>
+	Variant vmcall_batch_scalars(gaddr_t address, const PackedT &args, int arity);
 	void setup_arguments_native(gaddr_t arrayDataPtr, GuestVariant *v, const Variant **args, int argc);
+	struct ScopedObject;
+	static uint64_t profile_ticks();
+	void record_profile(gaddr_t address, uint64_t t0, bool nested, bool exception);
+	void add_profile_monitors(gaddr_t address);
+	double get_profile_monitor(int64_t address, int field) const;
+	void simulate_sampled(gaddr_t address, uint64_t max_instructions);
+	void record_sample();
+	template <size_t N>
+	static void traced_syscall(machine_t &machine);
+	static void install_syscall_tracing(bool enable);
+	template <size_t N>
+	static void checked_syscall(machine_t &machine);
+	/// @brief Check every Godot API system call against the allowed system calls of the sandbox making it.
+	static void install_syscall_allowlist();
+	void record_syscall(unsigned index, uint64_t t0, uint64_t bytes_before);
+	ScopedObject *scoped_object_entry(uint64_t handle) const noexcept;
+	void track_scoped_object(uint64_t handle, bool host_provided);
+	void release_scoped_objects(CurrentState &state);
+	void clear_scoped_objects();
+
+	void end_sliced_call();
+	void run_async_call();
+	void finish_async_call();
+	void free_async_forks();
+	void apply_deferred_commands();
+	void setup_guest_names();
+	static void parallel_call_task(uint32_t index);
+	static void parallel_map_task(uint32_t index);
+	template <typename PackedT>
+	Variant parallel_map_packed(gaddr_t address, const PackedT &input, int64_t chunk_size);
+	uint64_t frame_instructions_remaining();
+	/// @brief Charge the instructions of the last call to the share of this frame.
+	/// @param share_limit The instruction limit of the call, when the share of the frame was its limit, otherwise 0.
+	/// @return True if the call was stopped at the end of the share of the frame.
+	bool charge_frame_instructions(uint64_t share_limit = 0);
+	/// @brief Check if no call is in progress, other than a suspended sliced call.
+	bool is_outermost_call() const { return m_level == ((m_sliced_call.active && !m_sliced_call.running) ? 2 : 1); }
+	void record_frame_budget_overrun();
 
 	Ref<ELFScript> m_program_data;
 	machine_t *m_machine = nullptr;
 	godot::Node *m_tree_base = nullptr;
 	const PackedByteArray *m_binary = nullptr;
+	std::shared_ptr<Sandbox> m_program_template; // The template this machine was forked from, if any
+	PackedByteArray m_template_binary; // Template instances own a reference to their program
 	uint32_t m_max_refs = MAX_REFS;
 	uint32_t m_memory_max = MAX_VMEM;
 	int64_t m_insn_max = MAX_INSTRUCTIONS;
 
 	std::unordered_set<godot::Object *> m_allowed_objects;
 	godot::HashSet<String> m_allowed_classes;
-	mutable std::unordered_map<int64_t, gaddr_t> m_lookup;
+	struct LookupEntry {
+		gaddr_t address;
+		uint32_t calls = 0; // Counted towards the JIT call threshold
+	};
+	mutable HashMap<StringName, LookupEntry> m_lookup;
+	mutable std::shared_ptr<const ELFScript::FunctionTable> m_functions; // Shared by all sandboxes of the program
 
 	bool m_last_newline = false;
 	uint8_t m_throttled = 0;
 	uint8_t m_level = 1; // Current call level (0 is for initialization)
 	bool m_use_unboxed_arguments = false;
+	bool m_use_program_template = false;
+	bool m_use_binary_translation = false;
+	bool m_use_jit_compilation = false;
+	bool m_profiling = false;
+
+	// JIT compilation
+	uint32_t m_jit_call_threshold = 0;
+	int64_t m_jit_task = -1; // WorkerThreadPool task, when started
+	std::function<void()> m_jit_compilation_step; // Deferred until a function becomes hot
+	bool m_jit_armed = false; // Calls are counted until this machine or its template is compiled
+	std::atomic<bool> m_jit_live = false;
+	std::atomic<uint64_t> m_jit_compile_time = 0; // in microseconds
+
+	// Sliced calls, which hold the first call level while suspended
+	struct SlicedCall {
+		gaddr_t address = 0;
+		gaddr_t retvar = 0; // Guest address of the return value
+		uint64_t budget = 0; // Instructions per frame
+		uint64_t instructions = 0; // Executed so far
+		bool active = false;
+		bool running = false; // A slice is executing, rather than suspended
+	};
+	SlicedCall m_sliced_call;
+
+	// Commands recorded while running on a worker thread, see call_parallel()
+	struct DeferredCommand {
+		uint64_t object_id;
+		StringName method;
+		Array args;
+	};
+	std::vector<DeferredCommand> m_deferred_commands;
+	bool m_in_parallel_call = false;
+
+	// Packed arrays mapped into the guest, see map_packed_array()
+	struct MappedArray {
+		gaddr_t address = 0;
+		uint8_t *data = nullptr; // The host buffer
+		size_t bytes = 0;
+		Variant array; // Keeps the buffer alive
+		unsigned level = 0;
+		bool writable = false;
+	};
+	std::vector<MappedArray> m_mapped_arrays;
+
+	// Methods resolved by the guest, see resolve_method_handle(). Forks share the table of
+	// their template, and copy it on write, so a fork never changes the table of another.
+	struct MethodKey {
+		Variant::Type type = Variant::NIL;
+		StringName class_name;
+		StringName method;
+		bool operator==(const MethodKey &other) const { return type == other.type && method == other.method && class_name == other.class_name; }
+		static uint32_t hash(const MethodKey &key) { return hash_murmur3_one_32(key.type, hash_murmur3_one_32(key.class_name.hash(), key.method.hash())); }
+	};
+	struct MethodHandles {
+		std::vector<MethodHandle> handles;
+		HashMap<MethodKey, unsigned, MethodKey> lookup;
+	};
+	std::shared_ptr<MethodHandles> m_method_handles = std::make_shared<MethodHandles>();
+
+	// Names passed by the guest, see guest_name(). Like method handles, forks share the
+	// names of their template, and copy them on write.
+	struct CachedName {
+		unsigned length = 0;
+		StringName name;
+	};
+	struct GuestNames {
+		HashMap<gaddr_t, CachedName> cached; // By address, for names in read-only data
+		std::vector<StringName> interned;
+		HashMap<StringName, unsigned> interned_handles;
+	};
+	GuestNames &guest_names_for_writing();
+	std::shared_ptr<GuestNames> m_guest_names = std::make_shared<GuestNames>();
+	gaddr_t m_rodata_begin = 0;
+	gaddr_t m_rodata_end = 0;
+
+	// Async calls, see vmcall_async(). The call is owned by the fork that runs it
+	struct AsyncCall {
+		int64_t handle = 0;
+		uint64_t owner_id = 0; // The sandbox that started the call
+		gaddr_t address = 0;
+		std::vector<Variant> args;
+		Variant result;
+		int64_t task = -1; // WorkerThreadPool task
+	};
+	std::unique_ptr<AsyncCall> m_async_call;
+	uint64_t m_allowed_syscalls = ~uint64_t(0); // Bit per Godot API system call, see install_syscall_allowlist()
+	bool m_worker_fork = false; // Runs on worker threads, outside of the frame budget
+	std::vector<Sandbox *> m_worker_forks; // Owned forks for parallel_map()
+	std::vector<Sandbox *> m_async_forks; // Owned forks of the async calls that have not yet finished
+	static inline int64_t m_next_async_handle = 0;
+
+	// Share of the global frame budget
+	double m_frame_budget_weight = 1.0;
+	uint64_t m_frame = 0; // The frame that m_frame_instructions belongs to
+	uint64_t m_frame_instructions = 0; // Executed during m_frame
+	unsigned m_frame_budget_overruns = 0;
+	static inline uint64_t m_frame_instruction_budget = 0; // 0 means no budget
+	static inline double m_global_frame_budget_weight = 0.0;
 
 	// Stats
 	unsigned m_timeouts = 0;
@@ -349,13 +911,90 @@ private:
 	// so that they can be accessed by future VM calls, and not lost when a call ends.
 	std::array<CurrentState, MAX_LEVEL + 1> m_states;
 
+	// Objects are given to the guest as generational handles into this table, instead of
+	// their addresses. Each handle is validated by generation and ObjectID, so that a stale
+	// handle or a freed object is never dereferenced. Objects are released at the end of
+	// the call level that acquired them, unless the guest has pinned them.
+	struct ScopedObject {
+		godot::Object *object = nullptr; // The wrapper, only valid while the object is alive
+		GDExtensionObjectPtr owner = nullptr; // The engine object, compared without touching the wrapper
+		uint64_t object_id = 0;
+		uint32_t generation = 1; // Incremented when the slot is released
+		uint8_t level = 0; // The call level that releases the object
+		bool pinned = false;
+	};
+	mutable std::vector<ScopedObject> m_scoped_objects;
+	std::vector<uint32_t> m_free_scoped_objects;
+	HashMap<uint64_t, uint32_t> m_scoped_object_ids; // ObjectID to slot, so that each object has one handle
+	uint32_t m_pinned_objects = 0;
+
+	// Profiling, keyed by function address
+	struct FunctionProfile {
+		static constexpr unsigned BUCKETS = 48; // Latency histogram, by log2 of nanoseconds
+		uint64_t calls = 0;
+		uint64_t instructions = 0;
+		uint64_t time = 0; // in nanoseconds
+		uint64_t exceptions = 0;
+		std::array<uint32_t, BUCKETS> histogram{};
+
+		double percentile(double p) const;
+	};
+	HashMap<gaddr_t, FunctionProfile> m_profile;
+	std::vector<StringName> m_profile_monitors;
+	std::vector<gaddr_t> m_pending_profile_monitors; // Functions first called on a worker thread
+
+	// Sampling, by instruction count
+	struct SamplingProfile {
+		struct Sample {
+			uint64_t time; // Guest instructions executed while sampling
+			uint32_t offset; // The first frame of the sample
+			uint32_t count; // The number of frames, starting with PC and RA
+		};
+		uint64_t interval = 0;
+		uint64_t countdown = 0;
+		uint64_t instructions = 0;
+		std::vector<gaddr_t> frames;
+		std::vector<Sample> samples;
+	};
+	std::unique_ptr<SamplingProfile> m_sampling;
+	bool m_sampling_active = false;
+
+	// System call tracing
+	struct SyscallStats {
+		uint64_t calls = 0;
+		uint64_t time = 0; // in nanoseconds
+		uint64_t bytes = 0;
+	};
+	struct SyscallTrace {
+		struct Span {
+			uint64_t start; // in nanoseconds, see profile_ticks()
+			uint64_t frame; // Engine process frame
+			uint32_t duration; // in nanoseconds
+			uint32_t index;
+			uint64_t bytes;
+		};
+		std::array<SyscallStats, TRACED_SYSCALLS> stats{};
+		std::vector<Span> spans;
+		int64_t clock_offset = 0; // From profile_ticks() to Time::get_ticks_usec(), in nanoseconds
+	};
+	std::unique_ptr<SyscallTrace> m_syscall_trace;
+	uint64_t m_syscall_bytes = 0;
+	bool m_syscall_tracing = false;
+	static inline std::array<SyscallStats, TRACED_SYSCALLS> m_global_syscall_stats{};
+	static inline unsigned m_syscall_tracing_instances = 0;
+
+	// System call costs, shared by all sandboxes
+	static std::array<SyscallCost, TRACED_SYSCALLS> m_syscall_costs;
+
 	// Properties
 	mutable std::vector<SandboxProperty> m_properties;
 
 	// Global statistics
-	static inline uint64_t m_global_timeouts = 0;
-	static inline uint64_t m_global_exceptions = 0;
-	static inline uint64_t m_global_calls_made = 0;
+	// Atomic, as sandboxes may run on worker threads, see call_parallel()
+	static inline std::atomic<uint64_t> m_global_timeouts = 0;
+	static inline std::atomic<uint64_t> m_global_exceptions = 0;
+	static inline std::atomic<uint64_t> m_global_calls_made = 0;
+	static inline std::atomic<uint64_t> m_global_frame_budget_overruns = 0;
 	static inline uint32_t m_global_instance_count = 0;
 	static inline double m_accumulated_startup_time = 0.0;
 };
@@ -369,6 +1008,29 @@ inline void Sandbox::CurrentState::reset(unsigned index) {
 	variants.clear();
 	scoped_variants.clear();
 	scoped_objects.clear();
+	host_objects = 0;
+}
+
+inline Sandbox::ScopedObject *Sandbox::scoped_object_entry(uint64_t handle) const noexcept {
+	// The low 32 bits are the slot index plus one, so that 0 is never a valid handle
+	const uint32_t index = uint32_t(handle) - 1;
+	if (index >= m_scoped_objects.size() || m_scoped_objects[index].generation != uint32_t(handle >> 32)) {
+		return nullptr;
+	}
+	return &m_scoped_objects[index];
+}
+
+inline godot::Object *Sandbox::get_scoped_object(uint64_t handle) const noexcept {
+	const ScopedObject *entry = scoped_object_entry(handle);
+	if (entry == nullptr || entry->object == nullptr) {
+		return nullptr;
+	}
+	// The object may have been freed by the engine while the guest held on to it,
+	// and then its wrapper was freed too, so the wrapper is only used once the ID is known to be alive
+	if (internal::gdextension_interface_object_get_instance_from_id(entry->object_id) != entry->owner) {
+		return nullptr;
+	}
+	return entry->object;
 }
 
 inline bool Sandbox::is_allowed(godot::Object *obj) const {
@@ -0,0 +1,101 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+
+// Async calls: a pure compute function runs on a thread of the WorkerThreadPool, in a fork of
+// the program template. The fork is restricted: it can't access any objects, and may only make
+// the system calls that work on Variants and math. The result is delivered on the main thread
+// through the async_call_finished signal of the sandbox that started the call, which owns the
+// fork until then.
+
+// Arguments must not give the worker thread access to objects, or to containers
+// that the main thread may change while the call runs. A deep copy of a container
+// still refers to the same objects, so containers with objects are rejected too.
+static bool make_async_argument(const Variant &arg, Variant &result) {
+	if (Sandbox::contains_object(arg)) {
+		return false;
+	}
+	switch (arg.get_type()) {
+		case Variant::ARRAY:
+		case Variant::DICTIONARY:
+			result = arg.duplicate(true);
+			return true;
+		default:
+			result = arg;
+			return true;
+	}
+}
+
+Variant Sandbox::vmcall_async(const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error) {
+	if (arg_count < 1) {
+		error.error = GDEXTENSION_CALL_ERROR_TOO_FEW_ARGUMENTS;
+		error.argument = 1;
+		return -1;
+	}
+	error.error = GDEXTENSION_CALL_OK;
+
+	const StringName function = args[0]->operator StringName();
+	const gaddr_t address = cached_address_of(function);
+	if (address == 0x0) {
+		ERR_PRINT("Function not found in the guest: " + String(function));
+		return -1;
+	}
+	std::unique_ptr<AsyncCall> call = std::make_unique<AsyncCall>();
+	call->args.resize(arg_count - 1);
+	for (int i = 1; i < arg_count; i++) {
+		if (!make_async_argument(*args[i], call->args[i - 1])) {
+			ERR_PRINT("Sandbox: vmcall_async arguments cannot be or contain objects, callables or signals.");
+			return -1;
+		}
+	}
+
+	Sandbox *worker = this->create_worker_fork();
+	if (worker == nullptr) {
+		ERR_PRINT("Sandbox: vmcall_async requires a program that can be forked from a program template.");
+		return -1;
+	}
+
+	call->handle = Sandbox::m_next_async_handle++;
+	call->owner_id = get_instance_id();
+	call->address = address;
+	const int64_t handle = call->handle;
+	worker->m_async_call = std::move(call);
+	worker->m_async_call->task = WorkerThreadPool::get_singleton()->add_task(
+			callable_mp(worker, &Sandbox::run_async_call), true, "Sandbox async call");
+	this->m_async_forks.push_back(worker);
+	return handle;
+}
+
+void Sandbox::run_async_call() {
+	AsyncCall &call = *this->m_async_call;
+	std::vector<const Variant *> arg_ptrs(call.args.size());
+	for (size_t i = 0; i < call.args.size(); i++) {
+		arg_ptrs[i] = &call.args[i];
+	}
+	call.result = this->vmcall_internal(call.address, arg_ptrs.data(), arg_ptrs.size());
+	// Deliver the result on the main thread
+	callable_mp(this, &Sandbox::finish_async_call).call_deferred();
+}
+
+void Sandbox::finish_async_call() {
+	std::unique_ptr<AsyncCall> call = std::move(this->m_async_call);
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(call->task);
+	// The sandbox that started the call may have been freed in the meantime
+	Sandbox *owner = Object::cast_to<Sandbox>(ObjectDB::get_instance(call->owner_id));
+	if (owner != nullptr) {
+		std::vector<Sandbox *> &forks = owner->m_async_forks;
+		forks.erase(std::remove(forks.begin(), forks.end(), this), forks.end());
+		owner->emit_signal("async_call_finished", call->handle, call->result);
+	}
+	// The fork belongs to the call, and is not used again
+	memdelete(this);
+}
+
+void Sandbox::free_async_forks() {
+	// The deferred finish_async_call() of each fork is dropped along with the fork
+	for (Sandbox *worker : m_async_forks) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(worker->m_async_call->task);
+		memdelete(worker);
+	}
+	m_async_forks.clear();
+}
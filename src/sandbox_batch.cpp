@@ -0,0 +1,184 @@
+#include "sandbox.h"
+
+#include "guest_datatypes.h"
+#include <godot_cpp/classes/engine.hpp>
+
+// Run one guest function once per element, entering the VM only once for the whole batch.
+// Each element gets a fresh call state and stack, and its own instruction budget.
+template <typename ArgumentsFn, typename ResultFn>
+bool Sandbox::run_batch(gaddr_t address, int64_t count, ArgumentsFn &&arguments, ResultFn &&result) {
+	if (this->m_level != 1) {
+		ERR_PRINT("Sandbox: vmcall_batch cannot be used during a Sandbox call.");
+		return false;
+	}
+	CurrentState &state = this->m_states[m_level];
+	CurrentState *old_state = this->m_current_state;
+	this->m_current_state = &state;
+	m_level++;
+
+	riscv::CPU<RISCV_ARCH> &cpu = m_machine->cpu;
+	const gaddr_t exit_address = m_machine->memory.exit_address();
+	const gaddr_t stack_initial = m_machine->memory.stack_initial();
+	const bool is_scheduled = m_frame_instruction_budget != 0;
+	uint64_t max_instructions = get_instructions_max() << 20;
+	bool limited_by_share = false;
+	uint64_t profile_t0 = 0;
+	try {
+		for (int64_t i = 0; i < count; i++) {
+			if (is_scheduled) [[unlikely]] {
+				// The whole batch shares the frame budget of the sandbox, and stops when it runs out
+				const uint64_t remaining = this->frame_instructions_remaining();
+				if (remaining == 0) {
+					this->record_frame_budget_overrun();
+					throw std::runtime_error("Sandbox: vmcall_batch exceeded the frame instruction budget.");
+				}
+				limited_by_share = remaining < (get_instructions_max() << 20);
+				max_instructions = std::min(get_instructions_max() << 20, remaining);
+				m_machine->set_instruction_counter(0);
+			}
+			this->release_scoped_objects(state);
+			state.reset(this->m_level - 1);
+			// Call statistics
+			this->m_calls_made++;
+			Sandbox::m_global_calls_made++;
+			if (m_profiling) [[unlikely]] {
+				profile_t0 = profile_ticks();
+			}
+
+			cpu.reg(riscv::REG_RA) = exit_address;
+			gaddr_t &sp = cpu.reg(riscv::REG_SP);
+			sp = stack_initial;
+			GuestVariant *retvar = arguments(sp, i);
+			// The budget is per element, just like separate calls
+			m_machine->simulate_with(max_instructions, 0u, address);
+			if (is_scheduled) [[unlikely]] {
+				this->charge_frame_instructions();
+			}
+			this->unmap_arrays(m_level);
+			result(i, *retvar);
+			if (m_profiling) [[unlikely]] {
+				this->record_profile(address, profile_t0, false, false);
+			}
+		}
+	} catch (const std::exception &e) {
+		this->unmap_arrays(m_level);
+		this->m_level--;
+		// A batch stopped at the end of the share of the frame has not timed out
+		const bool stopped_by_share = is_scheduled && this->charge_frame_instructions(limited_by_share ? max_instructions : 0);
+		if (!stopped_by_share) {
+			if (Engine::get_singleton()->is_editor_hint()) {
+				// Throttle exceptions in the sandbox when calling from the editor
+				this->m_throttled += EDITOR_THROTTLE;
+			}
+			this->handle_exception(address);
+		}
+		if (m_profiling) [[unlikely]] {
+			this->record_profile(address, profile_t0, false, true);
+		}
+		this->m_current_state = old_state;
+		return false;
+	}
+	this->m_level--;
+	this->m_current_state = old_state;
+	return true;
+}
+
+template <typename T, typename PackedT>
+Variant Sandbox::vmcall_batch_scalars(gaddr_t address, const PackedT &args, int arity) {
+	if (arity < 1 || arity > 7) {
+		ERR_PRINT("Sandbox: vmcall_batch arity must be between 1 and 7 for packed arguments.");
+		return Variant();
+	}
+	if (args.size() % arity != 0) {
+		ERR_PRINT("Sandbox: vmcall_batch packed arguments are not a multiple of the arity.");
+		return Variant();
+	}
+	const int64_t count = args.size() / arity;
+	const T *data = args.ptr();
+	PackedT results;
+	results.resize(count);
+	T *results_ptr = results.ptrw();
+
+	auto collect = [&](int64_t i, const GuestVariant &retvar) {
+		results_ptr[i] = T(retvar.toVariant(*this));
+	};
+	if (this->m_use_unboxed_arguments) {
+		// Scalars go straight into argument registers, without creating any Variants
+		auto registers = [&](gaddr_t &sp, int64_t i) {
+			sp -= sizeof(GuestVariant);
+			sp &= ~gaddr_t(0xF); // re-align stack pointer
+			riscv::CPU<RISCV_ARCH> &cpu = m_machine->cpu;
+			cpu.reg(10) = sp;
+			const T *tuple = &data[i * arity];
+			for (int j = 0; j < arity; j++) {
+				if constexpr (std::is_integral_v<T>) {
+					cpu.reg(11 + j) = tuple[j];
+				} else { // Variant floats are always 64-bit
+					cpu.registers().getfl(10 + j).set_double(tuple[j]);
+				}
+			}
+			return m_machine->memory.memarray<GuestVariant>(sp, 1);
+		};
+		if (!run_batch(address, count, registers, collect)) {
+			return Variant();
+		}
+		return results;
+	}
+
+	Variant tuple[7];
+	const Variant *tuple_ptrs[7];
+	for (int j = 0; j < arity; j++) {
+		tuple_ptrs[j] = &tuple[j];
+	}
+	auto variants = [&](gaddr_t &sp, int64_t i) {
+		for (int j = 0; j < arity; j++) {
+			tuple[j] = data[i * arity + j];
+		}
+		return this->setup_arguments(sp, tuple_ptrs, arity);
+	};
+	if (!run_batch(address, count, variants, collect)) {
+		return Variant();
+	}
+	return results;
+}
+
+Variant Sandbox::vmcall_batch(const String &function, const Variant &args, int arity) {
+	const gaddr_t address = cached_address_of(StringName(function));
+	if (address == 0x0) {
+		ERR_PRINT("Function not found in the guest: " + function);
+		return Variant();
+	}
+
+	switch (args.get_type()) {
+		case Variant::ARRAY: {
+			const Array batch = args;
+			Array results;
+			results.resize(batch.size());
+			std::vector<const Variant *> arg_ptrs;
+			Array tuple;
+			auto arguments = [&](gaddr_t &sp, int64_t i) {
+				// Keep the tuple alive for the duration of the call
+				tuple = batch[i];
+				arg_ptrs.resize(tuple.size());
+				for (int j = 0; j < tuple.size(); j++) {
+					arg_ptrs[j] = &tuple[j];
+				}
+				return this->setup_arguments(sp, arg_ptrs.data(), tuple.size());
+			};
+			auto collect = [&](int64_t i, const GuestVariant &retvar) {
+				results[i] = retvar.toVariant(*this);
+			};
+			if (!run_batch(address, batch.size(), arguments, collect)) {
+				return Variant();
+			}
+			return results;
+		}
+		case Variant::PACKED_INT64_ARRAY:
+			return vmcall_batch_scalars<int64_t>(address, PackedInt64Array(args), arity);
+		case Variant::PACKED_FLOAT32_ARRAY:
+			return vmcall_batch_scalars<float>(address, PackedFloat32Array(args), arity);
+		default:
+			ERR_PRINT("Sandbox: vmcall_batch expects an Array of argument Arrays, or a PackedInt64Array or PackedFloat32Array of arguments.");
+			return Variant();
+	}
+}
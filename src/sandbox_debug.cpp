@@ -40,6 +40,7 @@ String Sandbox::get_current_instruction() const {
 void Sandbox::resume(uint64_t max_instructions) {
 	CurrentState &state = this->m_states[m_level];
 	const bool is_reentrant_call = m_level > 1;
+	this->release_scoped_objects(state);
 	state.reset(this->m_level);
 	m_level++;
 
@@ -1,6 +1,6 @@
 #include "sandbox.h"
 
-#include "cpp/script_cpp.h"
+#include "elf/dwarf_line_index.h"
 #include <charconv>
 
 static constexpr bool VERBOSE_EXCEPTIONS = false;
@@ -46,14 +46,15 @@ void Sandbox::handle_exception(gaddr_t address) {
 		ERR_PRINT(("Exception: " + std::string(e.what())).c_str());
 	}
 
-	// Attempt to print the source code line using addr2line from the C++ Docker container
-	// It's not unthinkable that this works for every ELF, regardless of the language
-	Array line_out;
-	String elfpath = get_program()->get_dockerized_program_path();
-	CPPScript::DockerContainerExecute({ "/usr/api/build.sh", "--line", to_hex(address), elfpath }, line_out, false);
-	if (line_out.size() > 0) {
-		const String line = String(line_out[0]).replace("\n", "").replace("/usr/src/", "res://");
-		UtilityFunctions::printerr("Exception in Sandbox function: ", line);
+	// Print the source code line from the line table of the program, which works for
+	// every ELF built with debug information, regardless of the language
+	if (get_program().is_null()) {
+		return; // Program templates don't know where their program lives
+	}
+	const DwarfLineIndex::Location location = get_program()->get_line_index().lookup(machine().cpu.pc());
+	if (location.is_valid()) {
+		// Programs are built in the C++ Docker container, where the project is mounted at /usr/src/
+		UtilityFunctions::printerr("Exception in Sandbox function: ", location.file.replace("/usr/src/", "res://"), ":", location.line);
 	}
 
 	if constexpr (VERBOSE_EXCEPTIONS) {
@@ -64,6 +65,20 @@ void Sandbox::handle_exception(gaddr_t address) {
 	}
 }
 
+Dictionary Sandbox::get_source_location(const String &function) const {
+	if (m_program_data.is_null()) {
+		return Dictionary();
+	}
+	const DwarfLineIndex::Location location = m_program_data->get_line_index().lookup_symbol(function);
+	if (!location.is_valid()) {
+		return Dictionary();
+	}
+	Dictionary result;
+	result["file"] = location.file.replace("/usr/src/", "res://");
+	result["line"] = location.line;
+	return result;
+}
+
 void Sandbox::handle_timeout(gaddr_t address) {
 	this->m_timeouts++;
 	Sandbox::m_global_timeouts++;
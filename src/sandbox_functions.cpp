@@ -1,5 +1,7 @@
 #include "sandbox.h"
 
+#include "elf/elf_scanner.h"
+#include <charconv>
 #include <unordered_set>
 
 using namespace godot;
@@ -1167,80 +1169,98 @@ static const std::unordered_set<std::string_view> exclude_functions{
 	"OUTLINED_FUNCTION_2",
 };
 
+// Public functions are unmangled functions, except those that belong to the C/C++ runtime,
+// the system call wrappers and compiler-generated functions.
+static bool is_public_function(const ElfScanner::Symbol &symbol) {
+	if (symbol.type != ElfScanner::STT_FUNC || symbol.name.starts_with("_Z")) {
+		return false;
+	}
+	// Double underscore functions are compiler-generated functions.
+	if (symbol.name.starts_with("__")) {
+		return false;
+	}
+	return exclude_functions.count(symbol.name) == 0;
+}
+
 PackedStringArray Sandbox::get_functions() const {
-	PackedStringArray result;
-	// Get all unmangled public functions from the guest program.
-	// Exclude functions that belong to the C/C++ runtime, as well as compiler-generated functions.
-	for (std::string_view function : machine().memory.all_unmangled_function_symbols()) {
-		// Double underscore functions are compiler-generated functions.
-		if (function.size() >= 2 && function[0] == '_' && function[1] == '_') {
-			continue;
-		}
-		if (exclude_functions.count(function) == 0) {
-			result.append(String(std::string(function).c_str()));
-		}
+	// The program's metadata already holds the public functions
+	if (m_program_data.is_valid() && m_binary != nullptr && m_program_data->get_content().ptr() == m_binary->ptr()) {
+		return m_program_data->functions;
 	}
-	return result;
+	return get_program_info_from_binary(machine().memory.binary()).functions;
 }
 
 Sandbox::BinaryInfo Sandbox::get_program_info_from_binary(const PackedByteArray &binary) {
+	return get_program_info_from_binary(std::string_view{ (const char *)binary.ptr(), static_cast<size_t>(binary.size()) });
+}
+
+Sandbox::BinaryInfo Sandbox::get_program_info_from_binary(std::string_view binary) {
 	BinaryInfo result;
-	if (binary.is_empty()) {
+	if (binary.empty()) {
+		return result;
+	}
+	const ElfScanner elf(binary);
+	if (!elf.is_valid()) {
+		ERR_PRINT("Failed to get functions from binary. Not a 64-bit ELF program.");
 		return result;
 	}
 
-	const std::string_view binary_view = std::string_view{ (const char *)binary.ptr(), static_cast<size_t>(binary.size()) };
-	try {
-		// Instantiate Machine without loading the ELF
-		machine_t machine{ binary_view, riscv::MachineOptions<RISCV_ARCH>{
-												.load_program = false, // Do not load the ELF program.
-										} };
-		std::vector<std::string_view> comments = machine.memory.elf_comments();
-		// Detect language: C++, Rust, etc.
-		result.language = "Unknown";
-		result.version = 0;
-		for (std::string_view comment : comments) {
-			if (comment.find("Godot Rust") != std::string::npos) {
-				// Rust: "Godot Rust API v1"
-				result.language = "Rust";
-				auto version = comment.find("API v");
-				if (version != std::string::npos) {
-					result.version = std::stoi(std::string(comment.substr(version + 5)));
-				}
-				break;
-			} else if (comment.find("Godot C++") != std::string::npos) {
-				// C++: "Godot C++ API v1"
-				result.language = "C++";
-				auto version = comment.find("API v");
-				if (version != std::string::npos) {
-					result.version = std::stoi(std::string(comment.substr(version + 5)));
-				}
-				break;
-			} else if (comment.find("Godot Zig") != std::string::npos) {
-				// Zig: "Godot Zig API v1"
-				result.language = "Zig";
-				auto version = comment.find("API v");
-				if (version != std::string::npos) {
-					result.version = std::stoi(std::string(comment.substr(version + 5)));
-				}
-				break;
-			}
-		}
-		//printf("Detected language: %s, version: %d\n", result.language.utf8().ptr(), result.version);
-
-		// Get all unmangled public functions from the guest program.
-		// Exclude functions that belong to the C/C++ runtime, as well as compiler-generated functions.
-		for (std::string_view function : machine.memory.all_unmangled_function_symbols()) {
-			// Double underscore functions are compiler-generated functions.
-			if (function.size() >= 2 && function[0] == '_' && function[1] == '_') {
+	// Detect language: C++, Rust, etc. from eg. "Godot C++ API v1"
+	static constexpr std::pair<std::string_view, const char *> languages[] = {
+		{ "Godot Rust", "Rust" },
+		{ "Godot C++", "C++" },
+		{ "Godot Zig", "Zig" },
+	};
+	result.language = "Unknown";
+	result.version = 0;
+	bool detected = false;
+	elf.for_each_comment([&](std::string_view comment) {
+		for (const auto &[marker, language] : languages) {
+			if (detected || comment.find(marker) == std::string_view::npos) {
 				continue;
 			}
-			if (exclude_functions.count(function) == 0) {
-				result.functions.append(String(std::string(function).c_str()));
+			detected = true;
+			result.language = language;
+			const size_t version = comment.find("API v");
+			if (version != std::string_view::npos) {
+				std::from_chars(comment.data() + version + 5, comment.data() + comment.size(), result.version);
 			}
 		}
-	} catch (const std::exception &e) {
-		ERR_PRINT("Failed to get functions from binary. " + String(e.what()));
+	});
+
+	gaddr_t properties_address = 0;
+	elf.for_each_symbol([&](const ElfScanner::Symbol &symbol) {
+		if (is_public_function(symbol)) {
+			result.functions.append(String::utf8(symbol.name.data(), symbol.name.size()));
+			result.addresses.push_back(symbol.value);
+		} else if (symbol.type == ElfScanner::STT_OBJECT && symbol.name == "properties") {
+			properties_address = symbol.value;
+		}
+	});
+
+	// Sandboxed properties are a constant array of Property structs, see SANDBOXED_PROPERTIES(),
+	// which ends with an empty property. Only the names and types are needed without a machine.
+	struct GuestPropertyHeader {
+		gaddr_t g_name;
+		unsigned size;
+		Variant::Type type;
+	};
+	for (unsigned i = 0; properties_address != 0 && i < MAX_PROPERTIES; i++) {
+		const std::string_view first = elf.read(properties_address, sizeof(GuestPropertyHeader));
+		if (first.empty()) {
+			break;
+		}
+		GuestPropertyHeader prop;
+		std::memcpy(&prop, first.data(), sizeof(prop));
+		if (prop.g_name == 0 || prop.size < sizeof(GuestPropertyHeader)) {
+			break;
+		}
+		const std::string_view name = elf.read_string(prop.g_name);
+		if (name.empty()) {
+			break;
+		}
+		result.properties.push_back({ String::utf8(name.data(), name.size()), prop.type });
+		properties_address += prop.size;
 	}
 	return result;
 }
@@ -0,0 +1,65 @@
+#include "sandbox.h"
+
+#include "syscalls.h"
+
+// Guest names: method and property names cross from the guest as an address and a length, and
+// become StringNames on the host, which hashes them and looks them up in the global table of
+// names. Most names are string literals in the read-only data of the program, so those are
+// cached by their address. Other names can be interned by the guest once, and passed by handle.
+
+static constexpr unsigned MAX_CACHED_NAMES = 4096;
+static constexpr unsigned MAX_INTERNED_NAMES = 4096;
+
+void Sandbox::setup_guest_names() {
+	// The names of the previous program may still be shared with its forks
+	m_guest_names = std::make_shared<GuestNames>();
+	const auto *rodata = machine().memory.section_by_name(".rodata");
+	m_rodata_begin = rodata ? gaddr_t(rodata->sh_addr) : 0;
+	m_rodata_end = rodata ? gaddr_t(rodata->sh_addr + rodata->sh_size) : 0;
+}
+
+StringName Sandbox::guest_name(gaddr_t address, unsigned length) {
+	if (length == INTERNED_NAME_LENGTH) {
+		if (address >= m_guest_names->interned.size()) {
+			ERR_PRINT("Sandbox: Invalid interned name handle");
+			throw std::runtime_error("Invalid interned name handle");
+		}
+		return m_guest_names->interned[address];
+	}
+	const bool in_rodata = address >= m_rodata_begin && address < m_rodata_end && length <= m_rodata_end - address;
+	if (in_rodata) {
+		const CachedName *cached = m_guest_names->cached.getptr(address);
+		if (cached != nullptr && cached->length == length) [[likely]] {
+			return cached->name;
+		}
+	}
+	const std::string_view view = m_machine->memory.memview(address, length);
+	const StringName name = String::utf8(view.data(), view.size());
+	if (in_rodata && m_guest_names->cached.size() < MAX_CACHED_NAMES) {
+		guest_names_for_writing().cached.insert(address, CachedName{ length, name });
+	}
+	return name;
+}
+
+unsigned Sandbox::intern_name(const StringName &name) {
+	const unsigned *handle = m_guest_names->interned_handles.getptr(name);
+	if (handle != nullptr) {
+		return *handle;
+	}
+	if (m_guest_names->interned.size() >= MAX_INTERNED_NAMES) {
+		ERR_PRINT("Sandbox: Too many interned names");
+		throw std::runtime_error("Too many interned names");
+	}
+	GuestNames &names = guest_names_for_writing();
+	names.interned.push_back(name);
+	names.interned_handles.insert(name, names.interned.size() - 1);
+	return names.interned.size() - 1;
+}
+
+// The names may be shared with the template and its other forks
+Sandbox::GuestNames &Sandbox::guest_names_for_writing() {
+	if (m_guest_names.use_count() > 1) {
+		m_guest_names = std::make_shared<GuestNames>(*m_guest_names);
+	}
+	return *m_guest_names;
+}
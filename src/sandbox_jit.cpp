@@ -0,0 +1,90 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+#ifdef RISCV_BINARY_TRANSLATION
+void Sandbox::apply_jit_options(riscv::MachineOptions<RISCV_ARCH> &options) {
+#ifdef RISCV_LIBTCC
+	// libtcc compiles the translated program in-memory, so nothing is written to the
+	// translation cache. Unlike ahead-of-time translations, JIT-compiled code keeps
+	// counting instructions, so execution timeouts still apply.
+	options.translate_enabled = true;
+	options.translate_invoke_compiler = true;
+	options.translation_cache = false;
+	// libriscv hands us the compilation step instead of running it while loading the
+	// program. It's held back until one of the program's functions becomes hot.
+	options.translate_background_callback = [this](std::function<void()> &compilation_step) {
+		this->m_jit_compilation_step = std::move(compilation_step);
+		this->m_jit_armed = true;
+	};
+#endif
+}
+#endif
+
+void Sandbox::start_jit_compilation() {
+	this->m_jit_armed = false;
+	if (!this->m_jit_compilation_step) {
+		// Forks share the execute segment of their template, which owns the compilation step
+		if (this->m_program_template != nullptr) {
+			this->m_program_template->start_jit_compilation();
+		}
+		return;
+	}
+	if (this->m_jit_task >= 0) {
+		return;
+	}
+	this->m_jit_task = WorkerThreadPool::get_singleton()->add_task(
+			callable_mp(this, &Sandbox::jit_compile), false, "Sandbox JIT compilation");
+}
+
+void Sandbox::jit_compile() {
+	// Runs on a worker thread. libriscv makes the compiled code live
+	// once the compilation step returns, even while the machine is running.
+	const uint64_t t0 = Time::get_singleton()->get_ticks_usec();
+	try {
+		this->m_jit_compilation_step();
+		this->m_jit_live = true;
+	} catch (const std::exception &e) {
+		ERR_PRINT(("Sandbox: JIT compilation failed: " + std::string(e.what())).c_str());
+	}
+	const uint64_t t1 = Time::get_singleton()->get_ticks_usec();
+	this->m_jit_compile_time = t1 - t0;
+}
+
+void Sandbox::finish_jit_compilation() {
+	// The compilation step refers to the current machine, so it must
+	// complete before the machine can be deleted or replaced.
+	if (this->m_jit_task >= 0) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(this->m_jit_task);
+		this->m_jit_task = -1;
+	}
+	this->m_jit_compilation_step = nullptr;
+	this->m_jit_armed = false;
+	this->m_jit_live = false;
+	this->m_jit_compile_time = 0;
+}
+
+bool Sandbox::is_jit_compiled() const {
+	if (this->m_program_template != nullptr) {
+		return this->m_program_template->is_jit_compiled();
+	}
+	return this->m_jit_live;
+}
+
+unsigned Sandbox::get_jit_compiled_functions() const {
+	if (!this->is_jit_compiled()) {
+		return 0;
+	}
+	// The whole execute segment is compiled at once, so every public function of the program is now
+	// native. The function table is the program's own, and shared with the template and its forks.
+	return this->m_functions ? this->m_functions->size() : 0;
+}
+
+double Sandbox::get_jit_compile_time() const {
+	if (this->m_program_template != nullptr) {
+		return this->m_program_template->get_jit_compile_time();
+	}
+	return this->m_jit_compile_time / 1e6;
+}
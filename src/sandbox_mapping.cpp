@@ -0,0 +1,105 @@
+#include "sandbox.h"
+
+// Mapped arrays: the buffer of a host packed array is inserted into the page table of the guest,
+// in an area above the arena, so that the guest can read it in place instead of fetching a copy.
+// Pages are only mapped whole, so the last partial page of the buffer is copied. Mappings last
+// until the call that made them returns.
+
+static constexpr gaddr_t PAGE_SIZE = riscv::Page::size();
+
+static size_t page_align(size_t bytes) {
+	return (bytes + PAGE_SIZE - 1) & ~size_t(PAGE_SIZE - 1);
+}
+
+template <typename PackedT>
+static uint8_t *packed_array_buffer(const Variant &var, bool writable, Variant &r_pinned, size_t &r_bytes) {
+	PackedT array = var;
+	// The array is shared with var, so ptrw() makes a private copy for the guest to write into
+	const auto *data = writable ? array.ptrw() : array.ptr();
+	r_bytes = array.size() * sizeof(*data);
+	r_pinned = std::move(array);
+	return (uint8_t *)data;
+}
+
+static uint8_t *packed_array_buffer(const Variant &var, bool writable, Variant &r_pinned, size_t &r_bytes) {
+	switch (var.get_type()) {
+		case Variant::PACKED_BYTE_ARRAY:
+			return packed_array_buffer<PackedByteArray>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_INT32_ARRAY:
+			return packed_array_buffer<PackedInt32Array>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_INT64_ARRAY:
+			return packed_array_buffer<PackedInt64Array>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_FLOAT32_ARRAY:
+			return packed_array_buffer<PackedFloat32Array>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_FLOAT64_ARRAY:
+			return packed_array_buffer<PackedFloat64Array>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_VECTOR2_ARRAY:
+			return packed_array_buffer<PackedVector2Array>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_VECTOR3_ARRAY:
+			return packed_array_buffer<PackedVector3Array>(var, writable, r_pinned, r_bytes);
+		case Variant::PACKED_COLOR_ARRAY:
+			return packed_array_buffer<PackedColorArray>(var, writable, r_pinned, r_bytes);
+		default:
+			throw std::runtime_error("vfetch: Only packed arrays can be mapped into the guest");
+	}
+}
+
+gaddr_t Sandbox::map_packed_array(const Variant &array, bool writable, unsigned &r_index, size_t &r_bytes) {
+	MappedArray mapping;
+	mapping.data = packed_array_buffer(array, writable, mapping.array, mapping.bytes);
+	r_bytes = mapping.bytes;
+	mapping.level = this->m_level;
+	mapping.writable = writable;
+	if (writable) {
+		// A writable mapping belongs to a new Variant, which the guest can return or pass on.
+		// The Variant shares its buffer with the mapping, and guest writes go straight into the
+		// buffer, bypassing copy-on-write. So if the Variant is stored by the host during the
+		// call, eg. as a property, later writes by the guest are seen by the stored array too,
+		// until the call that made the mapping returns.
+		r_index = this->create_scoped_variant(Variant(mapping.array));
+	}
+	if (mapping.bytes == 0) {
+		return 0;
+	}
+
+	// Mappings are placed one after another, with an unmapped guard page in between
+	mapping.address = MAPPED_ARRAYS_AREA;
+	if (!m_mapped_arrays.empty()) {
+		const MappedArray &last = m_mapped_arrays.back();
+		mapping.address = last.address + page_align(last.bytes) + PAGE_SIZE;
+	}
+	if (mapping.address + mapping.bytes > MAPPED_ARRAYS_AREA + MAPPED_ARRAYS_AREA_SIZE) {
+		throw std::runtime_error("vfetch: Out of address space for mapped arrays");
+	}
+
+	riscv::PageAttributes attr;
+	attr.read = true;
+	attr.write = writable;
+	attr.exec = false;
+	const size_t whole_pages = mapping.bytes & ~size_t(PAGE_SIZE - 1);
+	if (whole_pages > 0) {
+		m_machine->memory.insert_non_owned_memory(mapping.address, mapping.data, whole_pages, attr);
+	}
+	if (mapping.bytes > whole_pages) {
+		// The buffer may end anywhere on its last page, so that page is a copy
+		m_machine->memory.memcpy(mapping.address + whole_pages, mapping.data + whole_pages, mapping.bytes - whole_pages);
+		m_machine->memory.set_page_attr(mapping.address + whole_pages, PAGE_SIZE, attr);
+		this->add_syscall_bytes(ECALL_VFETCH, mapping.bytes - whole_pages);
+	}
+	const gaddr_t address = mapping.address;
+	m_mapped_arrays.push_back(std::move(mapping));
+	return address;
+}
+
+void Sandbox::unmap_arrays(unsigned level) {
+	while (!m_mapped_arrays.empty() && m_mapped_arrays.back().level >= level) {
+		const MappedArray &mapping = m_mapped_arrays.back();
+		const size_t whole_pages = mapping.bytes & ~size_t(PAGE_SIZE - 1);
+		if (mapping.writable && mapping.bytes > whole_pages) {
+			// Whole pages were written in place, but the copied last page must be written back
+			m_machine->memory.memcpy_out(mapping.data + whole_pages, mapping.address + whole_pages, mapping.bytes - whole_pages);
+		}
+		m_machine->memory.free_pages(mapping.address, page_align(mapping.bytes));
+		m_mapped_arrays.pop_back();
+	}
+}
@@ -0,0 +1,211 @@
+#include "sandbox.h"
+
+#include "guest_datatypes.h"
+#include <godot_cpp/classes/class_db_singleton.hpp>
+#include <algorithm>
+#include <cstring>
+
+// Method handles: the guest resolves a method once, and calls it by its handle from then on,
+// instead of sending the method name with every call. Engine methods that take and return only
+// values that are stored in place in a GuestVariant are called with a ptrcall on their method
+// bind, which is looked up once. Arguments are read straight from the guest, without being boxed
+// into Variants. The table of those methods is generated from extension_api.json at build time,
+// see scripts/generate_method_binds.py.
+
+static constexpr unsigned MAX_METHOD_HANDLES = 4096;
+static constexpr unsigned MAX_PTRCALL_ARGS = 4;
+
+struct Sandbox::MethodBindInfo {
+	const char *class_name; // The class or builtin type that has the method
+	Variant::Type type; // OBJECT, or the builtin type that has the method
+	const char *method;
+	int64_t hash; // The hash of the method signature, from extension_api.json
+	Variant::Type return_type; // NIL for methods without a return value
+	unsigned argc;
+	std::array<Variant::Type, MAX_PTRCALL_ARGS> arg_types;
+};
+using MethodBindInfo = Sandbox::MethodBindInfo;
+
+#include "method_binds.gen.h"
+
+// Vectors are floats in the guest, and real_t in the engine
+static constexpr bool REAL_T_IS_FLOAT = sizeof(real_t) == sizeof(float);
+
+static bool is_ptrcall_type(Variant::Type type) {
+	switch (type) {
+		case Variant::VECTOR2:
+		case Variant::VECTOR3:
+		case Variant::VECTOR4:
+			return REAL_T_IS_FLOAT;
+		default:
+			return true;
+	}
+}
+
+static bool is_ptrcall_signature(const MethodBindInfo &info) {
+	if (!is_ptrcall_type(info.type) || !is_ptrcall_type(info.return_type)) {
+		return false;
+	}
+	for (unsigned i = 0; i < info.argc; i++) {
+		if (!is_ptrcall_type(info.arg_types[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <size_t N>
+static const MethodBindInfo *find_method_bind(const MethodBindInfo (&table)[N], const char *class_name, const char *method) {
+	const MethodBindInfo *end = table + N;
+	const MethodBindInfo *it = std::lower_bound(table, end, std::make_pair(class_name, method),
+			[](const MethodBindInfo &info, const std::pair<const char *, const char *> &key) {
+				const int cmp = std::strcmp(info.class_name, key.first);
+				return cmp < 0 || (cmp == 0 && std::strcmp(info.method, key.second) < 0);
+			});
+	if (it != end && std::strcmp(it->class_name, class_name) == 0 && std::strcmp(it->method, method) == 0) {
+		return it;
+	}
+	return nullptr;
+}
+
+static void bind_method_handle(Sandbox::MethodHandle &handle) {
+	const CharString method = String(handle.method).utf8();
+	if (handle.type != Variant::OBJECT) {
+		const CharString type_name = Variant::get_type_name(handle.type).utf8();
+		const MethodBindInfo *info = find_method_bind(builtin_method_binds, type_name.get_data(), method.get_data());
+		if (info == nullptr || !is_ptrcall_signature(*info)) {
+			return;
+		}
+		handle.builtin_method = internal::gdextension_interface_variant_get_ptr_builtin_method(
+				GDExtensionVariantType(handle.type), handle.method._native_ptr(), info->hash);
+		handle.bind_info = handle.builtin_method ? info : nullptr;
+		return;
+	}
+	// Methods are found in the class that defines them, so the class hierarchy is searched upwards
+	ClassDBSingleton *class_db = ClassDBSingleton::get_singleton();
+	for (StringName cls = handle.class_name; !cls.is_empty(); cls = class_db->get_parent_class(cls)) {
+		const CharString class_str = String(cls).utf8();
+		const MethodBindInfo *info = find_method_bind(engine_method_binds, class_str.get_data(), method.get_data());
+		if (info == nullptr) {
+			continue;
+		}
+		if (!is_ptrcall_signature(*info)) {
+			return;
+		}
+		handle.method_bind = internal::gdextension_interface_classdb_get_method_bind(cls._native_ptr(), handle.method._native_ptr(), info->hash);
+		handle.class_tag = internal::gdextension_interface_classdb_get_class_tag(cls._native_ptr());
+		if (handle.method_bind != nullptr && handle.class_tag != nullptr) {
+			handle.bind_info = info;
+		} else {
+			handle.method_bind = nullptr;
+		}
+		return;
+	}
+}
+
+static bool arguments_match(const MethodBindInfo &info, const GuestVariant *args, unsigned argc) {
+	if (argc != info.argc) {
+		return false;
+	}
+	for (unsigned i = 0; i < argc; i++) {
+		if (args[i].type != info.arg_types[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+unsigned Sandbox::resolve_method_handle(Variant::Type type, const StringName &class_name, const StringName &method) {
+	MethodKey key{ type, class_name, method };
+	if (const unsigned *index = m_method_handles->lookup.getptr(key)) {
+		return *index;
+	}
+	if (m_method_handles->handles.size() >= MAX_METHOD_HANDLES) {
+		ERR_PRINT("Sandbox: Too many method handles");
+		throw std::runtime_error("Too many method handles");
+	}
+	if (type == Variant::OBJECT && !ClassDBSingleton::get_singleton()->class_has_method(class_name, method)) {
+		ERR_PRINT("Sandbox: Method not found: " + String(class_name) + "." + String(method));
+		throw std::runtime_error("Method not found: " + std::string(String(class_name).utf8().get_data()) + "." + std::string(String(method).utf8().get_data()));
+	}
+	MethodHandle handle{ type, class_name, method };
+	bind_method_handle(handle);
+
+	// The table may be shared with the template and its other forks
+	if (m_method_handles.use_count() > 1) {
+		m_method_handles = std::make_shared<MethodHandles>(*m_method_handles);
+	}
+	const unsigned index = m_method_handles->handles.size();
+	m_method_handles->handles.push_back(std::move(handle));
+	m_method_handles->lookup.insert(std::move(key), index);
+	return index;
+}
+
+const Sandbox::MethodHandle &Sandbox::get_method_handle(unsigned handle) const {
+	if (handle >= m_method_handles->handles.size()) {
+		ERR_PRINT("Sandbox: Invalid method handle");
+		throw std::runtime_error("Invalid method handle");
+	}
+	return m_method_handles->handles[handle];
+}
+
+// The values of arguments and return values have the layout of their ptrcall encoding
+static void gather_arguments(const GuestVariant *args, unsigned argc, std::array<GDExtensionConstTypePtr, MAX_PTRCALL_ARGS> &argptrs) {
+	for (unsigned i = 0; i < argc; i++) {
+		argptrs[i] = &args[i].v;
+	}
+}
+
+bool Sandbox::call_fast_method(const MethodHandle &handle, godot::Object *obj, const GuestVariant *args, unsigned argc, Variant &r_ret) const {
+	const MethodBindInfo *info = handle.bind_info;
+	if (handle.method_bind == nullptr || !arguments_match(*info, args, argc)) {
+		return false;
+	}
+	// The object is of the class that has the method, unless the guest used the handle on another object
+	if (internal::gdextension_interface_object_cast_to(obj->_owner, handle.class_tag) == nullptr) {
+		return false;
+	}
+	std::array<GDExtensionConstTypePtr, MAX_PTRCALL_ARGS> argptrs;
+	gather_arguments(args, argc, argptrs);
+	GuestVariant result;
+	internal::gdextension_interface_object_method_bind_ptrcall(handle.method_bind, obj->_owner, argptrs.data(), &result.v);
+	result.type = info->return_type;
+	r_ret = result.toVariant(*this);
+	return true;
+}
+
+bool Sandbox::call_fast_method(const MethodHandle &handle, const GuestVariant &self, const GuestVariant *args, unsigned argc, Variant &r_ret) const {
+	const MethodBindInfo *info = handle.bind_info;
+	if (handle.builtin_method == nullptr || self.type != handle.type || !arguments_match(*info, args, argc)) {
+		return false;
+	}
+	std::array<GDExtensionConstTypePtr, MAX_PTRCALL_ARGS> argptrs;
+	gather_arguments(args, argc, argptrs);
+	GuestVariant result;
+	// Only const methods are in the table, so they are called on a copy
+	switch (self.type) {
+		case Variant::STRING: {
+			String base = *self.toVariantPtr(*this);
+			handle.builtin_method(base._native_ptr(), argptrs.data(), &result.v, argc);
+			break;
+		}
+		case Variant::ARRAY: {
+			Array base = *self.toVariantPtr(*this);
+			handle.builtin_method(base._native_ptr(), argptrs.data(), &result.v, argc);
+			break;
+		}
+		case Variant::DICTIONARY: {
+			Dictionary base = *self.toVariantPtr(*this);
+			handle.builtin_method(base._native_ptr(), argptrs.data(), &result.v, argc);
+			break;
+		}
+		default: { // Vectors and colors are stored in place
+			auto base = self.v;
+			handle.builtin_method(&base, argptrs.data(), &result.v, argc);
+			break;
+		}
+	}
+	result.type = info->return_type;
+	r_ret = result.toVariant(*this);
+	return true;
+}
@@ -0,0 +1,248 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
+
+// Parallel calls: many sandboxes run the same function at once on the WorkerThreadPool, with
+// each sandbox on one thread, while the main thread waits. Sandboxes share nothing mutable but
+// the global statistics, which are atomic. System calls that change the scene are recorded in
+// the command buffer of their sandbox, and the buffers are applied on the main thread afterwards.
+// Parallel maps instead split one packed array over forks of a single sandbox's program template.
+
+namespace {
+struct ParallelCall {
+	std::vector<Sandbox *> sandboxes;
+	std::vector<gaddr_t> addresses;
+	std::vector<const Variant *> args;
+	std::vector<Variant> results;
+};
+} //namespace
+
+// Parallel calls are started from the main thread, so there is only one at a time
+static ParallelCall *current_parallel_call = nullptr;
+
+namespace {
+struct ParallelMap {
+	std::vector<Sandbox *> workers;
+	gaddr_t address = 0;
+	int64_t chunk_size = 0;
+	int64_t chunks = 0;
+	std::function<bool(Sandbox &, int64_t, int64_t)> map_chunk; // Maps elements [begin, end)
+	std::atomic<bool> failed = false;
+};
+} //namespace
+
+static ParallelMap *current_parallel_map = nullptr;
+
+void Sandbox::parallel_call_task(uint32_t index) {
+	ParallelCall &call = *current_parallel_call;
+	call.results[index] = call.sandboxes[index]->vmcall_internal(call.addresses[index], call.args.data(), call.args.size());
+}
+
+Array Sandbox::call_parallel(const Array &sandboxes, const StringName &function, const Array &args) {
+	Array results;
+	results.resize(sandboxes.size());
+	if (current_parallel_call != nullptr) {
+		ERR_PRINT("Sandbox: call_parallel cannot be used during another parallel call.");
+		return results;
+	}
+
+	// Function lookups may change the lookup tables, so they are done up-front on the main thread
+	ParallelCall call;
+	std::vector<int64_t> indices; // Index of each called sandbox in the results
+	HashSet<Sandbox *> seen;
+	for (int64_t i = 0; i < sandboxes.size(); i++) {
+		Sandbox *sandbox = Object::cast_to<Sandbox>(sandboxes[i]);
+		if (sandbox == nullptr || seen.has(sandbox)) {
+			ERR_PRINT("Sandbox: call_parallel needs an Array of distinct Sandboxes.");
+			continue;
+		}
+		seen.insert(sandbox);
+		if (sandbox->m_level != 1) {
+			ERR_PRINT("Sandbox: call_parallel cannot be used on a Sandbox that is already in a call.");
+			continue;
+		}
+		if (sandbox->m_throttled > 0) {
+			sandbox->m_throttled--;
+			continue;
+		}
+		const gaddr_t address = sandbox->cached_address_of(function);
+		if (address == 0x0) {
+			ERR_PRINT("Function not found in the guest: " + String(function));
+			continue;
+		}
+		call.sandboxes.push_back(sandbox);
+		call.addresses.push_back(address);
+		indices.push_back(i);
+	}
+	for (int64_t i = 0; i < args.size(); i++) {
+		call.args.push_back(&args[i]);
+	}
+	call.results.resize(call.sandboxes.size());
+
+	for (Sandbox *sandbox : call.sandboxes) {
+		sandbox->m_in_parallel_call = true;
+	}
+	current_parallel_call = &call;
+	if (call.sandboxes.size() == 1) {
+		parallel_call_task(0);
+	} else if (!call.sandboxes.empty()) {
+		WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+		const int64_t group = pool->add_group_task(callable_mp_static(&Sandbox::parallel_call_task), call.sandboxes.size(), -1, true, "Sandbox parallel call");
+		pool->wait_for_group_task_completion(group);
+	}
+	current_parallel_call = nullptr;
+
+	// Apply the recorded commands in the order of the sandboxes, so that the outcome is deterministic
+	for (size_t i = 0; i < call.sandboxes.size(); i++) {
+		Sandbox *sandbox = call.sandboxes[i];
+		sandbox->m_in_parallel_call = false;
+		sandbox->apply_deferred_commands();
+		results[indices[i]] = std::move(call.results[i]);
+	}
+	return results;
+}
+
+void Sandbox::defer_command(godot::Object *object, const StringName &method, Array &&args) {
+	this->m_deferred_commands.push_back({ object->get_instance_id(), method, std::move(args) });
+}
+
+void Sandbox::apply_deferred_commands() {
+	// Functions that were first profiled on a worker thread get their monitors here
+	const std::vector<gaddr_t> monitors = std::move(this->m_pending_profile_monitors);
+	this->m_pending_profile_monitors.clear();
+	for (const gaddr_t address : monitors) {
+		this->add_profile_monitors(address);
+	}
+	// Commands may start new calls into this sandbox, so the buffer is taken first
+	std::vector<DeferredCommand> commands = std::move(this->m_deferred_commands);
+	this->m_deferred_commands.clear();
+	for (const DeferredCommand &command : commands) {
+		Object *object = ObjectDB::get_instance(command.object_id);
+		if (object == nullptr) {
+			ERR_PRINT("Sandbox: Deferred command on a freed object: " + String(command.method));
+			continue;
+		}
+		object->callv(command.method, command.args);
+	}
+}
+
+void Sandbox::parallel_map_task(uint32_t index) {
+	ParallelMap &map = *current_parallel_map;
+	Sandbox &worker = *map.workers[index];
+	// Each worker maps every N-th chunk, so that no two threads share a machine
+	for (int64_t chunk = index; chunk < map.chunks && !map.failed; chunk += map.workers.size()) {
+		const int64_t begin = chunk * map.chunk_size;
+		if (!map.map_chunk(worker, begin, begin + map.chunk_size)) {
+			map.failed = true;
+		}
+	}
+}
+
+template <typename PackedT>
+Variant Sandbox::parallel_map_packed(gaddr_t address, const PackedT &input, int64_t chunk_size) {
+	const int64_t size = input.size();
+	PackedT output;
+	output.resize(size);
+	if (size == 0) {
+		return output;
+	}
+	// The output is written in place by the workers, so it must be unshared before they start
+	auto *output_ptr = output.ptrw();
+	const Variant::Type type = Variant(input).get_type();
+
+	ParallelMap map;
+	map.address = address;
+	map.chunk_size = chunk_size;
+	map.chunks = (size + chunk_size - 1) / chunk_size;
+	map.map_chunk = [&](Sandbox &worker, int64_t begin, int64_t end) {
+		end = std::min(end, size);
+		// Each chunk crosses into the guest and back as one packed array, copied in bulk
+		const Variant chunk = input.slice(begin, end);
+		const Variant *args[] = { &chunk };
+		const Variant result = worker.vmcall_internal(map.address, args, 1);
+		if (result.get_type() != type) {
+			ERR_PRINT("Sandbox: parallel_map function must return a packed array of the same type as its argument.");
+			return false;
+		}
+		const PackedT values = result;
+		if (values.size() != end - begin) {
+			ERR_PRINT("Sandbox: parallel_map function must return as many elements as it was given.");
+			return false;
+		}
+		std::copy(values.ptr(), values.ptr() + values.size(), output_ptr + begin);
+		return true;
+	};
+
+	const size_t threads = std::min<int64_t>(map.chunks, OS::get_singleton()->get_processor_count());
+	const std::vector<Sandbox *> &forks = this->worker_forks(threads);
+	map.workers.assign(forks.begin(), forks.begin() + std::min(threads, forks.size()));
+	if (map.workers.empty()) {
+		ERR_PRINT("Sandbox: parallel_map requires a program that can be forked from a program template.");
+		return Variant();
+	}
+	current_parallel_map = &map;
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	const int64_t group = pool->add_group_task(callable_mp_static(&Sandbox::parallel_map_task), map.workers.size(), -1, true, "Sandbox parallel map");
+	pool->wait_for_group_task_completion(group);
+	current_parallel_map = nullptr;
+
+	if (map.failed) {
+		return Variant();
+	}
+	return output;
+}
+
+Variant Sandbox::parallel_map(const StringName &function, const Variant &data, int64_t chunk_size) {
+	if (chunk_size <= 0) {
+		ERR_PRINT("Sandbox: parallel_map chunk size must be positive.");
+		return Variant();
+	}
+	if (current_parallel_map != nullptr) {
+		ERR_PRINT("Sandbox: parallel_map cannot be used during another parallel map.");
+		return Variant();
+	}
+	const gaddr_t address = cached_address_of(function);
+	if (address == 0x0) {
+		ERR_PRINT("Function not found in the guest: " + String(function));
+		return Variant();
+	}
+
+	switch (data.get_type()) {
+		case Variant::PACKED_BYTE_ARRAY:
+			return parallel_map_packed(address, PackedByteArray(data), chunk_size);
+		case Variant::PACKED_FLOAT32_ARRAY:
+			return parallel_map_packed(address, PackedFloat32Array(data), chunk_size);
+		case Variant::PACKED_VECTOR3_ARRAY:
+			return parallel_map_packed(address, PackedVector3Array(data), chunk_size);
+		default:
+			ERR_PRINT("Sandbox: parallel_map expects a PackedByteArray, PackedFloat32Array or PackedVector3Array.");
+			return Variant();
+	}
+}
+
+const std::vector<Sandbox *> &Sandbox::worker_forks(size_t count) {
+	// Forks of an older program are replaced
+	if (!m_worker_forks.empty() && m_worker_forks.front()->m_program_template != this->worker_fork_template()) {
+		this->free_worker_forks();
+	}
+	while (m_worker_forks.size() < count) {
+		Sandbox *worker = this->create_worker_fork();
+		if (worker == nullptr) {
+			break;
+		}
+		m_worker_forks.push_back(worker);
+	}
+	for (Sandbox *worker : m_worker_forks) {
+		worker->set_instructions_max(get_instructions_max());
+	}
+	return m_worker_forks;
+}
+
+void Sandbox::free_worker_forks() {
+	for (Sandbox *worker : m_worker_forks) {
+		memdelete(worker);
+	}
+	m_worker_forks.clear();
+}
@@ -0,0 +1,159 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+// Per-function profiling of calls made into the guest. Each function gets its own
+// counters and a latency histogram with one bucket per power of two nanoseconds,
+// which bounds the error of the reported percentiles to a factor of two.
+enum ProfileField {
+	PROFILE_CALLS,
+	PROFILE_INSTRUCTIONS,
+	PROFILE_EXCEPTIONS,
+	PROFILE_P50,
+	PROFILE_P95,
+	PROFILE_P99,
+};
+
+uint64_t Sandbox::profile_ticks() {
+	// Guest calls are often shorter than a microsecond, so Time::get_ticks_usec() is too coarse
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double Sandbox::FunctionProfile::percentile(double p) const {
+	const uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(p * calls)));
+	uint64_t seen = 0;
+	for (unsigned i = 0; i < BUCKETS; i++) {
+		seen += histogram[i];
+		if (seen >= rank) {
+			// The upper bound of the bucket, in seconds
+			return double(uint64_t(1) << i) / 1e9;
+		}
+	}
+	return 0.0;
+}
+
+static String function_name(const machine_t &machine, gaddr_t address) {
+	const auto callsite = machine.memory.lookup(address);
+	if (callsite.name.empty()) {
+		return "0x" + String::num_uint64(address, 16);
+	}
+	return String::utf8(callsite.name.c_str(), callsite.name.size());
+}
+
+void Sandbox::set_profiling(bool profiling) {
+	if (!profiling) {
+		this->clear_profile();
+	}
+	this->m_profiling = profiling;
+}
+
+void Sandbox::record_profile(gaddr_t address, uint64_t t0, bool nested, bool exception) {
+	const uint64_t elapsed = profile_ticks() - t0;
+	FunctionProfile *profile = m_profile.getptr(address);
+	if (profile == nullptr) {
+		profile = &m_profile.insert(address, FunctionProfile{})->value;
+		// Performance is not thread-safe. Parallel calls add their monitors on the main thread when
+		// they have finished, and worker forks are short-lived, so their functions have none.
+		if (m_in_parallel_call) {
+			m_pending_profile_monitors.push_back(address);
+		} else if (!m_worker_fork) {
+			this->add_profile_monitors(address);
+		}
+	}
+	profile->calls++;
+	// The instruction counter is saved and restored around nested calls,
+	// so their instructions are only counted towards the outermost call.
+	// Translated code does not count instructions.
+	if (!nested) {
+		profile->instructions += machine().instruction_counter();
+	}
+	profile->time += elapsed;
+	profile->exceptions += exception;
+	profile->histogram[std::min<unsigned>(std::bit_width(elapsed), FunctionProfile::BUCKETS - 1)]++;
+}
+
+void Sandbox::add_profile_monitors(gaddr_t address) {
+	Performance *performance = Performance::get_singleton();
+	if (performance == nullptr) {
+		return;
+	}
+	static const std::pair<ProfileField, const char *> monitors[] = {
+		{ PROFILE_CALLS, "calls" },
+		{ PROFILE_INSTRUCTIONS, "instructions" },
+		{ PROFILE_EXCEPTIONS, "exceptions" },
+		{ PROFILE_P50, "p50 (us)" },
+		{ PROFILE_P95, "p95 (us)" },
+		{ PROFILE_P99, "p99 (us)" },
+	};
+	// Shown in the debugger as one category per sandbox, eg. "Sandbox 26843545 Player/_process p95 (us)"
+	// Names are not unique, and may change, so each sandbox is told apart by its instance ID
+	const String prefix = "Sandbox " + String::num_uint64(get_instance_id()) + " " + String(get_name()) + "/" + function_name(machine(), address) + " ";
+	for (const auto &[field, suffix] : monitors) {
+		const StringName id = prefix + suffix;
+		if (performance->has_custom_monitor(id)) {
+			continue;
+		}
+		Array arguments;
+		arguments.push_back(int64_t(address));
+		arguments.push_back(int(field));
+		performance->add_custom_monitor(id, callable_mp(this, &Sandbox::get_profile_monitor), arguments);
+		m_profile_monitors.push_back(id);
+	}
+}
+
+double Sandbox::get_profile_monitor(int64_t address, int field) const {
+	const FunctionProfile *profile = m_profile.getptr(address);
+	if (profile == nullptr) {
+		return 0.0;
+	}
+	switch (ProfileField(field)) {
+		case PROFILE_CALLS:
+			return profile->calls;
+		case PROFILE_INSTRUCTIONS:
+			return profile->instructions;
+		case PROFILE_EXCEPTIONS:
+			return profile->exceptions;
+		case PROFILE_P50:
+			return profile->percentile(0.50) * 1e6;
+		case PROFILE_P95:
+			return profile->percentile(0.95) * 1e6;
+		case PROFILE_P99:
+			return profile->percentile(0.99) * 1e6;
+	}
+	return 0.0;
+}
+
+Dictionary Sandbox::get_profile() const {
+	Dictionary result;
+	for (const KeyValue<gaddr_t, FunctionProfile> &entry : m_profile) {
+		const FunctionProfile &profile = entry.value;
+		Dictionary function;
+		function["calls"] = int64_t(profile.calls);
+		function["instructions"] = int64_t(profile.instructions);
+		function["exceptions"] = int64_t(profile.exceptions);
+		function["time"] = profile.time / 1e9;
+		function["p50"] = profile.percentile(0.50);
+		function["p95"] = profile.percentile(0.95);
+		function["p99"] = profile.percentile(0.99);
+		result[function_name(machine(), entry.key)] = function;
+	}
+	return result;
+}
+
+void Sandbox::clear_profile() {
+	if (!m_profile_monitors.empty()) {
+		Performance *performance = Performance::get_singleton();
+		for (const StringName &id : m_profile_monitors) {
+			if (performance != nullptr && performance->has_custom_monitor(id)) {
+				performance->remove_custom_monitor(id);
+			}
+		}
+		m_profile_monitors.clear();
+	}
+	m_pending_profile_monitors.clear();
+	m_profile.clear();
+}
@@ -9,6 +9,22 @@ static constexpr char DOCKER_PATH[] = "editor/script/docker";
 static constexpr char DOCKER_PATH_HINT[] = "Path to the Docker executable";
 static constexpr char NATIVE_TYPES[] = "editor/script/unboxed_types_for_sandbox_arguments";
 static constexpr char NATIVE_TYPES_HINT[] = "Use native types and classes instead of Variants when calling VM functions where possible";
+static constexpr char PROGRAM_TEMPLATES[] = "editor/script/fork_sandboxes_from_program_templates";
+static constexpr char PROGRAM_TEMPLATES_HINT[] = "Fork new Sandbox instances copy-on-write from a pre-initialized template of their program, instead of loading the program from scratch";
+static constexpr char BINARY_TRANSLATION[] = "editor/script/binary_translation";
+static constexpr char BINARY_TRANSLATION_HINT[] = "Translate ELF programs into native code when they are imported, and run the translated code when it is available. Requires a system C compiler in the editor";
+static constexpr char PROGRAM_SNAPSHOTS[] = "editor/script/warm_start_program_templates_from_snapshots";
+static constexpr char PROGRAM_SNAPSHOTS_HINT[] = "Save program templates as snapshots in user://, and warm-start them from the snapshots on later runs";
+
+static constexpr char JIT_COMPILATION[] = "editor/script/jit_compile_hot_functions";
+static constexpr char JIT_COMPILATION_HINT[] = "Compile frequently called guest functions into native code in the background using libtcc, when the extension is built with it";
+static constexpr char JIT_CALL_THRESHOLD[] = "editor/script/jit_call_threshold";
+static constexpr char JIT_CALL_THRESHOLD_HINT[] = "Number of calls to a single guest function before the program is JIT-compiled";
+static constexpr char SYSCALL_COST_TABLE[] = "editor/script/syscall_cost_table";
+static constexpr char SYSCALL_COST_TABLE_HINT[] = "Path to a JSON table of system call costs saved with Sandbox.save_syscall_costs(), which replaces the default instruction costs of Godot API system calls";
+
+static constexpr char FRAME_INSTRUCTION_BUDGET[] = "editor/script/frame_instruction_budget";
+static constexpr char FRAME_INSTRUCTION_BUDGET_HINT[] = "Millions of instructions that all sandboxes together may execute each frame, shared by weight. 0 disables the budget";
 
 static void register_setting(
 		const String &p_name,
@@ -56,6 +72,13 @@ void SandboxProjectSettings::register_settings() {
 	register_setting_plain(DOCKER_PATH, "docker", DOCKER_PATH_HINT, true);
 #endif
 	register_setting_plain(NATIVE_TYPES, true, NATIVE_TYPES_HINT, false);
+	register_setting_plain(PROGRAM_TEMPLATES, true, PROGRAM_TEMPLATES_HINT, false);
+	register_setting_plain(PROGRAM_SNAPSHOTS, false, PROGRAM_SNAPSHOTS_HINT, false);
+	register_setting_plain(BINARY_TRANSLATION, false, BINARY_TRANSLATION_HINT, false);
+	register_setting_plain(JIT_COMPILATION, false, JIT_COMPILATION_HINT, false);
+	register_setting_plain(JIT_CALL_THRESHOLD, 1000, JIT_CALL_THRESHOLD_HINT, false);
+	register_setting_plain(SYSCALL_COST_TABLE, "", SYSCALL_COST_TABLE_HINT, true);
+	register_setting_plain(FRAME_INSTRUCTION_BUDGET, 0, FRAME_INSTRUCTION_BUDGET_HINT, false);
 }
 
 template <typename TType>
@@ -77,3 +100,31 @@ String SandboxProjectSettings::get_docker_path() {
 bool SandboxProjectSettings::use_native_types() {
 	return get_setting<bool>(NATIVE_TYPES);
 }
+
+bool SandboxProjectSettings::use_program_templates() {
+	return get_setting<bool>(PROGRAM_TEMPLATES);
+}
+
+bool SandboxProjectSettings::use_program_snapshots() {
+	return get_setting<bool>(PROGRAM_SNAPSHOTS);
+}
+
+bool SandboxProjectSettings::use_binary_translation() {
+	return get_setting<bool>(BINARY_TRANSLATION);
+}
+
+bool SandboxProjectSettings::use_jit_compilation() {
+	return get_setting<bool>(JIT_COMPILATION);
+}
+
+int64_t SandboxProjectSettings::get_jit_call_threshold() {
+	return get_setting<int64_t>(JIT_CALL_THRESHOLD);
+}
+
+String SandboxProjectSettings::get_syscall_cost_table() {
+	return get_setting<String>(SYSCALL_COST_TABLE);
+}
+
+int64_t SandboxProjectSettings::get_frame_instruction_budget() {
+	return get_setting<int64_t>(FRAME_INSTRUCTION_BUDGET);
+}
@@ -11,4 +11,18 @@ public:
 	static String get_docker_path();
 
 	static bool use_native_types();
+
+	static bool use_program_templates();
+
+	static bool use_program_snapshots();
+
+	static bool use_binary_translation();
+
+	static bool use_jit_compilation();
+
+	static int64_t get_jit_call_threshold();
+
+	static String get_syscall_cost_table();
+
+	static int64_t get_frame_instruction_budget();
 };
@@ -0,0 +1,198 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/json.hpp>
+
+// Sampling profiler: Guest calls are simulated in slices of a fixed number of
+// instructions, and the call stack is recorded between slices. The instruction
+// counter drives the sampling, so the samples are reproducible from run to run.
+static constexpr unsigned MAX_SAMPLE_DEPTH = 64;
+
+void Sandbox::start_sampling(int64_t interval) {
+	if (interval <= 0) {
+		ERR_PRINT("Sandbox: The sampling interval must be at least one instruction.");
+		return;
+	}
+	this->m_sampling = std::make_unique<SamplingProfile>();
+	this->m_sampling->interval = interval;
+	this->m_sampling->countdown = interval;
+	this->m_sampling_active = true;
+}
+
+void Sandbox::stop_sampling() {
+	this->m_sampling_active = false;
+}
+
+int64_t Sandbox::get_sample_count() const {
+	return m_sampling ? m_sampling->samples.size() : 0;
+}
+
+void Sandbox::simulate_sampled(gaddr_t address, uint64_t max_instructions) {
+	SamplingProfile &profile = *this->m_sampling;
+	m_machine->cpu.jump(address);
+	uint64_t counter = 0;
+	while (true) {
+		// The countdown carries over between calls, so that short calls are sampled too
+		const uint64_t slice_end = std::min(counter + profile.countdown, max_instructions);
+		const bool stopped = m_machine->simulate<false>(slice_end, counter);
+		const uint64_t executed = m_machine->instruction_counter() - counter;
+		counter = m_machine->instruction_counter();
+		profile.instructions += executed;
+		if (stopped) {
+			profile.countdown -= std::min(executed, profile.countdown);
+			if (profile.countdown == 0) {
+				profile.countdown = profile.interval;
+			}
+			return;
+		}
+		if (counter >= max_instructions) {
+			throw riscv::MachineTimeoutException(riscv::MAX_INSTRUCTIONS_REACHED, "Instruction count limit reached", max_instructions);
+		}
+		this->record_sample();
+		profile.countdown = profile.interval;
+	}
+}
+
+void Sandbox::record_sample() {
+	SamplingProfile &profile = *this->m_sampling;
+	riscv::CPU<RISCV_ARCH> &cpu = m_machine->cpu;
+	const size_t offset = profile.frames.size();
+	profile.frames.push_back(cpu.pc());
+	// The return address register is only meaningful in leaf functions, which
+	// is sorted out when the samples are resolved into function names.
+	profile.frames.push_back(cpu.reg(riscv::REG_RA));
+
+	// Walk the frame pointer chain, where the return address of each frame
+	// is stored at fp-8, and the frame pointer of the caller at fp-16.
+	const gaddr_t stack_top = m_machine->memory.stack_initial();
+	const gaddr_t exit_address = m_machine->memory.exit_address();
+	gaddr_t fp = cpu.reg(riscv::REG_FP);
+	try {
+		for (unsigned depth = 0; depth < MAX_SAMPLE_DEPTH; depth++) {
+			if (fp <= cpu.reg(riscv::REG_SP) || fp > stack_top || fp % sizeof(gaddr_t) != 0) {
+				break;
+			}
+			const gaddr_t ra = m_machine->memory.read<gaddr_t>(fp - 8);
+			const gaddr_t next_fp = m_machine->memory.read<gaddr_t>(fp - 16);
+			if (ra == exit_address || !cpu.current_execute_segment().is_within(ra)) {
+				break;
+			}
+			profile.frames.push_back(ra);
+			if (next_fp <= fp) {
+				break;
+			}
+			fp = next_fp;
+		}
+	} catch (const riscv::MachineException &) {
+		// Programs built without frame pointers use FP as a regular register
+	}
+	profile.samples.push_back({ profile.instructions, uint32_t(offset), uint32_t(profile.frames.size() - offset) });
+}
+
+// Resolve a sample into function names, outermost first
+static void resolve_sample(const machine_t &machine, HashMap<gaddr_t, String> &names, const gaddr_t *frames, uint32_t count, std::vector<String> &stack) {
+	auto name_of = [&](gaddr_t address) -> const String & {
+		const String *name = names.getptr(address);
+		if (name == nullptr) {
+			const auto callsite = machine.memory.lookup(address);
+			name = &names.insert(address, callsite.name.empty() ? "0x" + String::num_uint64(address, 16) : String::utf8(callsite.name.c_str(), callsite.name.size()))->value;
+		}
+		return *name;
+	};
+	stack.clear();
+	for (uint32_t i = count; i > 2; i--) {
+		stack.push_back(name_of(frames[i - 1]));
+	}
+	// The return address register is only used when it points into a function other
+	// than the current one and its caller, as is the case in leaf functions.
+	const String ra = name_of(frames[1]);
+	const String pc = name_of(frames[0]);
+	if (ra != pc && (stack.empty() || stack.back() != ra)) {
+		stack.push_back(ra);
+	}
+	stack.push_back(pc);
+}
+
+bool Sandbox::save_samples(const String &path) const {
+	if (!m_sampling || m_sampling->samples.empty()) {
+		ERR_PRINT("Sandbox: No samples to save, use start_sampling() first.");
+		return false;
+	}
+	const SamplingProfile &profile = *this->m_sampling;
+	HashMap<gaddr_t, String> names;
+	std::vector<String> stack;
+
+	String output;
+	if (path.ends_with(".json")) {
+		// Chrome trace format, with one stack frame node per unique call path. The
+		// timestamps are in guest instructions, which the trace viewer shows as microseconds.
+		Dictionary stack_frames;
+		HashMap<String, int64_t> frame_ids; // "<parent id>;<name>" to frame id
+		Array samples;
+		for (const SamplingProfile::Sample &sample : profile.samples) {
+			resolve_sample(machine(), names, &profile.frames[sample.offset], sample.count, stack);
+			int64_t parent = -1;
+			for (const String &name : stack) {
+				const String key = String::num_int64(parent) + ";" + name;
+				const int64_t *id = frame_ids.getptr(key);
+				if (id == nullptr) {
+					const int64_t new_id = frame_ids.size();
+					id = &frame_ids.insert(key, new_id)->value;
+					Dictionary frame;
+					frame["name"] = name;
+					frame["category"] = "sandbox";
+					if (parent >= 0) {
+						frame["parent"] = String::num_int64(parent);
+					}
+					stack_frames[String::num_int64(new_id)] = frame;
+				}
+				parent = *id;
+			}
+			Dictionary entry;
+			entry["cat"] = "sandbox";
+			entry["name"] = String(get_name());
+			entry["pid"] = 1;
+			entry["tid"] = 1;
+			entry["ts"] = int64_t(sample.time);
+			entry["sf"] = String::num_int64(parent);
+			entry["weight"] = 1;
+			samples.push_back(entry);
+		}
+		Dictionary trace;
+		trace["traceEvents"] = Array();
+		trace["stackFrames"] = stack_frames;
+		trace["samples"] = samples;
+		output = JSON::stringify(trace);
+	} else {
+		// Folded stacks: "outer;inner;leaf <count>"
+		HashMap<String, int64_t> folded;
+		for (const SamplingProfile::Sample &sample : profile.samples) {
+			resolve_sample(machine(), names, &profile.frames[sample.offset], sample.count, stack);
+			String line;
+			for (size_t i = 0; i < stack.size(); i++) {
+				if (i > 0) {
+					line += ";";
+				}
+				line += stack[i];
+			}
+			if (int64_t *count = folded.getptr(line)) {
+				*count += 1;
+			} else {
+				folded.insert(line, 1);
+			}
+		}
+		for (const KeyValue<String, int64_t> &entry : folded) {
+			output += entry.key + " " + String::num_int64(entry.value) + "\n";
+		}
+	}
+
+	DirAccess::make_dir_recursive_absolute(path.get_base_dir());
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	if (file.is_null()) {
+		ERR_PRINT("Sandbox: Unable to open samples for writing: " + path);
+		return false;
+	}
+	file->store_string(output);
+	return true;
+}
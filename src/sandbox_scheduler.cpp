@@ -0,0 +1,59 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/engine.hpp>
+
+// Frame budget: when a global per-frame instruction budget is set, every sandbox may execute
+// a share of it each frame, in proportion to its weight among all sandboxes. Calls on a
+// sandbox that has used up its share are skipped until the next frame, and calls that reach
+// the end of the share are stopped, so that all sandboxes together stay within the budget.
+
+void Sandbox::set_frame_instruction_budget(int64_t budget) {
+	m_frame_instruction_budget = uint64_t(std::max<int64_t>(0, budget)) << 20;
+}
+
+int64_t Sandbox::get_frame_instruction_budget() {
+	return int64_t(m_frame_instruction_budget >> 20);
+}
+
+void Sandbox::set_frame_budget_weight(double weight) {
+	weight = std::max(0.0, weight);
+	m_global_frame_budget_weight += weight - m_frame_budget_weight;
+	m_frame_budget_weight = weight;
+}
+
+int64_t Sandbox::get_frame_instruction_share() const {
+	if (m_frame_instruction_budget == 0) {
+		return 0;
+	}
+	const double total_weight = std::max(m_global_frame_budget_weight, m_frame_budget_weight);
+	if (total_weight <= 0.0) {
+		return 0;
+	}
+	return int64_t(double(m_frame_instruction_budget) * m_frame_budget_weight / total_weight);
+}
+
+uint64_t Sandbox::frame_instructions_remaining() {
+	const uint64_t frame = Engine::get_singleton()->get_process_frames();
+	if (frame != this->m_frame) {
+		this->m_frame = frame;
+		this->m_frame_instructions = 0;
+	}
+	const uint64_t share = uint64_t(get_frame_instruction_share());
+	return share > this->m_frame_instructions ? share - this->m_frame_instructions : 0;
+}
+
+bool Sandbox::charge_frame_instructions(uint64_t share_limit) {
+	const uint64_t instructions = m_machine->instruction_counter();
+	this->m_frame_instructions += instructions;
+	if (share_limit != 0 && instructions >= share_limit) {
+		// The call was stopped at the end of the share, rather than by its own execution timeout
+		this->record_frame_budget_overrun();
+		return true;
+	}
+	return false;
+}
+
+void Sandbox::record_frame_budget_overrun() {
+	this->m_frame_budget_overruns++;
+	Sandbox::m_global_frame_budget_overruns++;
+}
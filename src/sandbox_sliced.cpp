@@ -0,0 +1,150 @@
+#include "sandbox.h"
+
+#include "guest_datatypes.h"
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+
+// A sliced call runs a guest function for a limited number of instructions per frame,
+// and suspends it in between. The call keeps the first call level and its state until it
+// finishes, so that calls made while it is suspended run on top of it, just like calls
+// made from inside the guest, and leave its registers and stack untouched.
+
+static SceneTree *get_scene_tree() {
+	return Object::cast_to<SceneTree>(Engine::get_singleton()->get_main_loop());
+}
+
+Variant Sandbox::vmcall_sliced(const Variant **args, GDExtensionInt arg_count, GDExtensionCallError &error) {
+	if (arg_count < 2) {
+		error.error = GDEXTENSION_CALL_ERROR_TOO_FEW_ARGUMENTS;
+		error.argument = 2;
+		return false;
+	}
+	error.error = GDEXTENSION_CALL_OK;
+
+	const StringName function = args[0]->operator StringName();
+	const int64_t budget = args[1]->operator int64_t();
+	if (budget <= 0) {
+		ERR_PRINT("Sandbox: vmcall_sliced budget must be a positive number of instructions.");
+		return false;
+	}
+	if (this->m_level != 1) {
+		ERR_PRINT("Sandbox: vmcall_sliced cannot be used during a Sandbox call, or while another sliced call is running.");
+		return false;
+	}
+	const gaddr_t address = cached_address_of(function);
+	if (address == 0x0) {
+		ERR_PRINT("Function not found in the guest: " + String(function));
+		return false;
+	}
+	SceneTree *tree = get_scene_tree();
+	if (tree == nullptr) {
+		ERR_PRINT("Sandbox: vmcall_sliced needs a SceneTree to resume the call on the next frame.");
+		return false;
+	}
+
+	CurrentState &state = this->m_states[m_level];
+	this->release_scoped_objects(state);
+	state.reset(this->m_level);
+	m_level++;
+	CurrentState *old_state = this->m_current_state;
+	this->m_current_state = &state;
+	// Call statistics
+	this->m_calls_made++;
+	Sandbox::m_global_calls_made++;
+
+	try {
+		riscv::CPU<RISCV_ARCH> &cpu = m_machine->cpu;
+		cpu.reg(riscv::REG_RA) = m_machine->memory.exit_address();
+		gaddr_t &sp = cpu.reg(riscv::REG_SP);
+		sp = m_machine->memory.stack_initial();
+		this->setup_arguments(sp, args + 2, arg_count - 2);
+		// The return value is the first Variant of the argument array, at the top of the stack
+		this->m_sliced_call = SlicedCall{ address, sp, uint64_t(budget), 0, true };
+		cpu.jump(address);
+	} catch (const std::exception &e) {
+		this->m_level--;
+		this->m_current_state = old_state;
+		this->handle_exception(address);
+		return false;
+	}
+	this->m_current_state = old_state;
+
+	tree->connect("process_frame", callable_mp(this, &Sandbox::resume_sliced_call));
+	// The first slice runs right away
+	this->resume_sliced_call();
+	return true;
+}
+
+void Sandbox::resume_sliced_call() {
+	if (!this->m_sliced_call.active) {
+		return;
+	}
+	const bool is_scheduled = m_frame_instruction_budget != 0;
+	uint64_t budget = m_sliced_call.budget;
+	if (is_scheduled) [[unlikely]] {
+		// Slices also count towards the frame budget, and wait for the next frame when it's used up
+		budget = std::min(budget, this->frame_instructions_remaining());
+		if (budget == 0) {
+			return;
+		}
+	}
+	CurrentState *old_state = this->m_current_state;
+	this->m_current_state = &this->m_states[1];
+
+	Variant result;
+	try {
+		// Each slice starts from the suspended PC with a fresh instruction counter
+		m_sliced_call.running = true;
+		m_machine->simulate<false>(budget, 0u);
+		m_sliced_call.running = false;
+		m_sliced_call.instructions += m_machine->instruction_counter();
+		if (is_scheduled) [[unlikely]] {
+			this->charge_frame_instructions();
+		}
+		if (m_machine->instruction_limit_reached()) {
+			// Out of budget for this frame, suspend until the next one
+			this->m_current_state = old_state;
+			return;
+		}
+		this->unmap_arrays(m_level);
+		const GuestVariant *retvar = m_machine->memory.memarray<GuestVariant>(m_sliced_call.retvar, 1);
+		result = retvar->toVariant(*this);
+	} catch (const std::exception &e) {
+		m_sliced_call.running = false;
+		if (is_scheduled) [[unlikely]] {
+			this->charge_frame_instructions();
+		}
+		if (Engine::get_singleton()->is_editor_hint()) {
+			// Throttle exceptions in the sandbox when calling from the editor
+			this->m_throttled += EDITOR_THROTTLE;
+		}
+		this->handle_exception(m_sliced_call.address);
+	}
+	this->m_current_state = old_state;
+	this->end_sliced_call();
+	// Deferred, so that the signal can be awaited right after vmcall_sliced(),
+	// even when the call finishes within its first slice
+	call_deferred("emit_signal", "sliced_call_finished", result);
+}
+
+void Sandbox::end_sliced_call() {
+	this->m_sliced_call.active = false;
+	this->unmap_arrays(m_level);
+	this->m_level--;
+	SceneTree *tree = get_scene_tree();
+	const Callable resume = callable_mp(this, &Sandbox::resume_sliced_call);
+	if (tree != nullptr && tree->is_connected("process_frame", resume)) {
+		tree->disconnect("process_frame", resume);
+	}
+}
+
+void Sandbox::cancel_sliced_call() {
+	if (!this->m_sliced_call.active) {
+		return;
+	}
+	if (this->m_level != 2) {
+		ERR_PRINT("Sandbox: A sliced call cannot be cancelled during another Sandbox call.");
+		return;
+	}
+	this->end_sliced_call();
+}
@@ -0,0 +1,273 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <libriscv/util/crc32.hpp>
+
+// Snapshot file layout:
+//   [ SnapshotHeader ] [ machine state ] [ native heap arena ] [ level-0 Variants ]
+// Each section starts on a page boundary, so that the file can be memory-mapped.
+static constexpr char SNAPSHOT_MAGIC[8] = { 'S', 'B', 'X', 'S', 'N', 'A', 'P', '\0' };
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+static constexpr uint64_t SNAPSHOT_ALIGNMENT = 4096;
+
+struct SnapshotSection {
+	uint64_t offset;
+	uint64_t size;
+};
+struct SnapshotHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t program_hash; // CRC32-C of the ELF program
+	uint64_t program_size;
+	uint32_t memory_max; // in MiB
+	uint32_t reserved;
+	SnapshotSection machine;
+	SnapshotSection arena;
+	SnapshotSection state;
+};
+
+static inline uint64_t snapshot_align(uint64_t offset) {
+	return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+}
+
+static uint32_t program_hash(const PackedByteArray &binary) {
+	return riscv::crc32c(binary.ptr(), binary.size());
+}
+
+static void store_section(const Ref<FileAccess> &file, const SnapshotSection &section, const uint8_t *data) {
+	// Pad the file up to the start of the section
+	const uint64_t padding = section.offset - file->get_position();
+	if (padding > 0) {
+		PackedByteArray zeroes;
+		zeroes.resize(padding);
+		zeroes.fill(0);
+		file->store_buffer(zeroes);
+	}
+	PackedByteArray buffer;
+	buffer.resize(section.size);
+	std::memcpy(buffer.ptrw(), data, section.size);
+	file->store_buffer(buffer);
+}
+
+static std::vector<uint8_t> load_section(const Ref<FileAccess> &file, const SnapshotSection &section) {
+	file->seek(section.offset);
+	const PackedByteArray buffer = file->get_buffer(section.size);
+	if (uint64_t(buffer.size()) != section.size) {
+		throw std::runtime_error("Truncated snapshot section");
+	}
+	return std::vector<uint8_t>(buffer.ptr(), buffer.ptr() + buffer.size());
+}
+
+bool Sandbox::save_snapshot(const String &path) const {
+	if (!this->has_program_loaded()) {
+		ERR_PRINT("Sandbox: No program loaded, cannot save a snapshot.");
+		return false;
+	}
+	if (this->m_level != 1) {
+		ERR_PRINT("Sandbox: Cannot save a snapshot during a Sandbox call.");
+		return false;
+	}
+	// Host objects and host-owned Variants cannot be persisted
+	const CurrentState &initial = this->m_states[0];
+	if (!initial.scoped_objects.empty() || this->m_pinned_objects > 0) {
+		ERR_PRINT("Sandbox: Cannot save a snapshot of a program that holds on to objects.");
+		return false;
+	}
+	Array variants;
+	for (const Variant &var : initial.variants) {
+		if (var.get_type() == Variant::OBJECT) {
+			ERR_PRINT("Sandbox: Cannot save a snapshot of a program that holds on to objects.");
+			return false;
+		}
+		variants.push_back(var);
+	}
+	PackedInt32Array scoped_variants;
+	for (const Variant *var : initial.scoped_variants) {
+		const ptrdiff_t index = var - initial.variants.data();
+		if (index < 0 || size_t(index) >= initial.variants.size()) {
+			ERR_PRINT("Sandbox: Cannot save a snapshot of a program that refers to host Variants.");
+			return false;
+		}
+		scoped_variants.push_back(int32_t(index));
+	}
+	Array state;
+	state.push_back(variants);
+	state.push_back(scoped_variants);
+	// Method handles are kept by the guest, so they must keep their numbers
+	Array method_handles;
+	for (const MethodHandle &handle : this->m_method_handles->handles) {
+		Array entry;
+		entry.push_back(handle.type);
+		entry.push_back(handle.class_name);
+		entry.push_back(handle.method);
+		method_handles.push_back(entry);
+	}
+	state.push_back(method_handles);
+	Array interned_names;
+	for (const StringName &name : this->m_guest_names->interned) {
+		interned_names.push_back(name);
+	}
+	state.push_back(interned_names);
+	const PackedByteArray state_data = UtilityFunctions::var_to_bytes(state);
+
+	std::vector<uint8_t> machine_data;
+	std::vector<uint8_t> arena_data;
+	try {
+		machine().serialize_to(machine_data);
+		if (machine().has_arena()) {
+			machine().arena().serialize_to(arena_data);
+		}
+	} catch (const std::exception &e) {
+		ERR_PRINT(("Sandbox: Snapshot exception: " + std::string(e.what())).c_str());
+		return false;
+	}
+
+	SnapshotHeader header{};
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.program_hash = program_hash(*this->m_binary);
+	header.program_size = this->m_binary->size();
+	header.memory_max = this->get_memory_max();
+	header.machine = { snapshot_align(sizeof(SnapshotHeader)), machine_data.size() };
+	header.arena = { snapshot_align(header.machine.offset + header.machine.size), arena_data.size() };
+	header.state = { snapshot_align(header.arena.offset + header.arena.size), uint64_t(state_data.size()) };
+
+	DirAccess::make_dir_recursive_absolute(path.get_base_dir());
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	if (file.is_null()) {
+		ERR_PRINT("Sandbox: Unable to open snapshot for writing: " + path);
+		return false;
+	}
+	store_section(file, { 0, sizeof(header) }, (const uint8_t *)&header);
+	store_section(file, header.machine, machine_data.data());
+	store_section(file, header.arena, arena_data.data());
+	store_section(file, header.state, state_data.ptr());
+	return true;
+}
+
+bool Sandbox::load_snapshot(const String &path) {
+	if (m_program_data.is_null()) {
+		ERR_PRINT("Sandbox: Assign a program before loading a snapshot of it.");
+		return false;
+	}
+	return this->load_snapshot_internal(&m_program_data->get_content(), path);
+}
+
+bool Sandbox::load_snapshot_internal(const PackedByteArray *buffer, const String &path) {
+	if (this->m_level != 1) {
+		ERR_PRINT("Sandbox: Cannot load a snapshot during a Sandbox call.");
+		return false;
+	}
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::READ);
+	if (file.is_null()) {
+		return false;
+	}
+	SnapshotHeader header{};
+	const PackedByteArray header_data = file->get_buffer(sizeof(header));
+	if (header_data.size() != sizeof(header)) {
+		ERR_PRINT("Sandbox: Invalid snapshot: " + path);
+		return false;
+	}
+	std::memcpy(&header, header_data.ptr(), sizeof(header));
+	if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION) {
+		ERR_PRINT("Sandbox: Incompatible snapshot: " + path);
+		return false;
+	}
+	// A snapshot of any other program, or an older build of this one, is stale
+	if (header.program_size != uint64_t(buffer->size()) || header.program_hash != program_hash(*buffer)) {
+		WARN_PRINT("Sandbox: Snapshot is stale, the program has changed: " + path);
+		return false;
+	}
+	if (header.memory_max != this->get_memory_max()) {
+		WARN_PRINT("Sandbox: Snapshot was made with a different memory_max: " + path);
+		return false;
+	}
+
+	// Get t0 for the startup time
+	const uint64_t startup_t0 = Time::get_singleton()->get_ticks_usec();
+
+	const std::string_view binary_view = std::string_view{ (const char *)buffer->ptr(), static_cast<size_t>(buffer->size()) };
+	try {
+		const std::vector<uint8_t> machine_data = load_section(file, header.machine);
+		const std::vector<uint8_t> arena_data = load_section(file, header.arena);
+		const std::vector<uint8_t> state_data = load_section(file, header.state);
+
+		this->finish_jit_compilation();
+		delete this->m_machine;
+		this->m_machine = nullptr;
+		this->m_program_template = nullptr;
+		this->m_binary = buffer;
+		this->m_machine = new machine_t{ binary_view, this->machine_options() };
+		// The heap is set up exactly like a cold load, before the machine state is overwritten
+		this->setup_machine();
+
+		if (machine().deserialize_from(machine_data) != 0) {
+			throw std::runtime_error("Unable to restore the machine state");
+		}
+		if (machine().has_arena() && !arena_data.empty()) {
+			if (machine().arena().deserialize_from(arena_data, 0) < 0) {
+				throw std::runtime_error("Unable to restore the native heap");
+			}
+		}
+
+		// Restore the permanent (initial) state
+		PackedByteArray state_bytes;
+		state_bytes.resize(state_data.size());
+		std::memcpy(state_bytes.ptrw(), state_data.data(), state_data.size());
+		const Array state = UtilityFunctions::bytes_to_var(state_bytes);
+		if (state.size() < 2 || state.size() > 4) {
+			throw std::runtime_error("Invalid snapshot state");
+		}
+		const Array variants = state[0];
+		const PackedInt32Array scoped_variants = state[1];
+		CurrentState &initial = this->m_states[0];
+		initial.reset(0);
+		if (uint32_t(variants.size()) > initial.variants.capacity()) {
+			throw std::runtime_error("Snapshot holds more Variants than max_references allows");
+		}
+		for (int i = 0; i < variants.size(); i++) {
+			initial.variants.push_back(variants[i]);
+		}
+		for (int i = 0; i < scoped_variants.size(); i++) {
+			if (scoped_variants[i] < 0 || scoped_variants[i] >= variants.size()) {
+				throw std::runtime_error("Invalid snapshot state");
+			}
+			initial.scoped_variants.push_back(&initial.variants[scoped_variants[i]]);
+		}
+		// Snapshots from before method handles and interned names have none
+		const Array method_handles = state.size() > 2 ? Array(state[2]) : Array();
+		for (int i = 0; i < method_handles.size(); i++) {
+			const Array handle = method_handles[i];
+			if (handle.size() != 3 || this->resolve_method_handle(Variant::Type(int(handle[0])), handle[1], handle[2]) != unsigned(i)) {
+				throw std::runtime_error("Invalid snapshot state");
+			}
+		}
+		const Array interned_names = state.size() > 3 ? Array(state[3]) : Array();
+		for (int i = 0; i < interned_names.size(); i++) {
+			if (this->intern_name(interned_names[i]) != unsigned(i)) {
+				throw std::runtime_error("Invalid snapshot state");
+			}
+		}
+	} catch (const std::exception &e) {
+		ERR_PRINT(("Sandbox: Snapshot exception: " + std::string(e.what())).c_str());
+		this->finish_jit_compilation();
+		delete this->m_machine;
+		this->m_machine = new machine_t{};
+		this->m_binary = nullptr;
+		return false;
+	}
+
+	// Read the program's custom properties, if any
+	this->read_program_properties(true);
+
+	// Pre-cache some functions
+	this->precache_functions();
+
+	// Accumulate startup time
+	const uint64_t startup_t1 = Time::get_singleton()->get_ticks_usec();
+	m_accumulated_startup_time += (startup_t1 - startup_t0) / 1e6;
+	return true;
+}
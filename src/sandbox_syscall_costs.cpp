@@ -0,0 +1,151 @@
+#include "sandbox.h"
+
+#include "syscalls.h"
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/json.hpp>
+
+// System call costs: Godot API system calls are charged to the instruction counter of
+// the guest, so that execution timeouts account for time spent in the host. Each cost is
+// a base cost plus a cost per byte copied between the guest and the host, and the table
+// can be measured on the target platform with calibrate_syscall_costs().
+static std::array<Sandbox::SyscallCost, Sandbox::TRACED_SYSCALLS> default_syscall_costs() {
+	std::array<Sandbox::SyscallCost, Sandbox::TRACED_SYSCALLS> costs{};
+	auto set_cost = [&](int ecall, uint32_t base, float per_byte = 0.0f) {
+		costs[ecall - GAME_API_BASE] = { base, per_byte };
+	};
+	set_cost(ECALL_VCREATE, 10'000, 0.0625f);
+	set_cost(ECALL_VFETCH, 10'000, 0.0625f);
+	set_cost(ECALL_VSTORE, 10'000, 0.0625f);
+	set_cost(ECALL_VSTORE_RANGE, 10'000, 0.0625f);
+	set_cost(ECALL_VBYTES, 10'000, 0.0625f);
+	set_cost(ECALL_VCLONE, 10'000);
+	set_cost(ECALL_VFREE, 10'000);
+	set_cost(ECALL_STRING_CREATE, 10'000);
+	set_cost(ECALL_GET_OBJ, 150'000);
+	set_cost(ECALL_GET_NODE, 150'000);
+	set_cost(ECALL_NODE_CREATE, 150'000);
+	set_cost(ECALL_OBJ, 250'000);
+	set_cost(ECALL_OBJ_CALLP, 250'000);
+	set_cost(ECALL_METHOD_HANDLE, 150'000);
+	set_cost(ECALL_INTERN_NAME, 10'000);
+	set_cost(ECALL_OBJ_METHOD_CALL, 100'000);
+	set_cost(ECALL_NODE, 250'000);
+	set_cost(ECALL_NODE2D, 100'000);
+	set_cost(ECALL_NODE3D, 100'000);
+	set_cost(ECALL_TIMER_PERIODIC, 100'000);
+	return costs;
+}
+std::array<Sandbox::SyscallCost, Sandbox::TRACED_SYSCALLS> Sandbox::m_syscall_costs = default_syscall_costs();
+
+// Only the system calls that charge a cost in their handler have an entry in the table
+static bool is_charged_syscall(unsigned index) {
+	static const auto defaults = default_syscall_costs();
+	return defaults[index].base != 0 || defaults[index].per_byte != 0.0f;
+}
+
+Dictionary Sandbox::calibrate_syscall_costs(double instructions_per_second) {
+	if (instructions_per_second <= 0.0) {
+		ERR_PRINT("Sandbox: The guest speed must be a positive number of instructions per second.");
+		return Dictionary();
+	}
+	if (!this->m_syscall_trace || this->m_syscall_trace->spans.empty()) {
+		ERR_PRINT("Sandbox: No system calls have been traced, enable syscall_tracing first.");
+		return Dictionary();
+	}
+	const std::vector<SyscallTrace::Span> &spans = this->m_syscall_trace->spans;
+
+	// Least-squares fit of duration = base + per_byte * bytes, for each system call
+	struct Fit {
+		double n = 0, mean_bytes = 0, mean_duration = 0;
+		double covariance = 0, variance = 0;
+	};
+	std::array<Fit, TRACED_SYSCALLS> fits{};
+	for (const SyscallTrace::Span &span : spans) {
+		Fit &fit = fits[span.index];
+		fit.n += 1;
+		fit.mean_bytes += double(span.bytes);
+		fit.mean_duration += double(span.duration);
+	}
+	for (Fit &fit : fits) {
+		if (fit.n > 0) {
+			fit.mean_bytes /= fit.n;
+			fit.mean_duration /= fit.n;
+		}
+	}
+	for (const SyscallTrace::Span &span : spans) {
+		Fit &fit = fits[span.index];
+		const double dx = double(span.bytes) - fit.mean_bytes;
+		fit.covariance += dx * (double(span.duration) - fit.mean_duration);
+		fit.variance += dx * dx;
+	}
+
+	const double instructions_per_ns = instructions_per_second / 1e9;
+	for (unsigned i = 0; i < TRACED_SYSCALLS; i++) {
+		const Fit &fit = fits[i];
+		if (fit.n == 0 || !is_charged_syscall(i)) {
+			continue;
+		}
+		// System calls that always copy the same number of bytes only have a base cost
+		const double per_byte = fit.variance > 0.0 ? std::max(0.0, fit.covariance / fit.variance) : 0.0;
+		const double base = std::max(0.0, fit.mean_duration - per_byte * fit.mean_bytes);
+		m_syscall_costs[i].base = uint32_t(std::min(base * instructions_per_ns, double(UINT32_MAX)));
+		m_syscall_costs[i].per_byte = float(per_byte * instructions_per_ns);
+	}
+	return get_syscall_costs();
+}
+
+Dictionary Sandbox::get_syscall_costs() {
+	Dictionary result;
+	for (unsigned i = 0; i < TRACED_SYSCALLS; i++) {
+		if (!is_charged_syscall(i)) {
+			continue;
+		}
+		Dictionary entry;
+		entry["base"] = int64_t(m_syscall_costs[i].base);
+		entry["per_byte"] = m_syscall_costs[i].per_byte;
+		result[syscall_name(i)] = entry;
+	}
+	return result;
+}
+
+void Sandbox::set_syscall_costs(const Dictionary &costs) {
+	for (unsigned i = 0; i < TRACED_SYSCALLS; i++) {
+		const String name = syscall_name(i);
+		if (!costs.has(name)) {
+			continue;
+		}
+		if (!is_charged_syscall(i) || costs[name].get_type() != Variant::DICTIONARY) {
+			ERR_PRINT("Sandbox: Invalid system call cost: " + name);
+			continue;
+		}
+		const Dictionary entry = costs[name];
+		m_syscall_costs[i].base = uint32_t(std::clamp<int64_t>(entry.get("base", 0), 0, UINT32_MAX));
+		m_syscall_costs[i].per_byte = std::max(0.0, double(entry.get("per_byte", 0.0)));
+	}
+}
+
+bool Sandbox::save_syscall_costs(const String &path) {
+	DirAccess::make_dir_recursive_absolute(path.get_base_dir());
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	if (file.is_null()) {
+		ERR_PRINT("Sandbox: Unable to open system call costs for writing: " + path);
+		return false;
+	}
+	file->store_string(JSON::stringify(get_syscall_costs(), "\t"));
+	return true;
+}
+
+bool Sandbox::load_syscall_costs(const String &path) {
+	if (!FileAccess::file_exists(path)) {
+		ERR_PRINT("Sandbox: System call costs not found: " + path);
+		return false;
+	}
+	const Variant costs = JSON::parse_string(FileAccess::get_file_as_string(path));
+	if (costs.get_type() != Variant::DICTIONARY) {
+		ERR_PRINT("Sandbox: Invalid system call costs: " + path);
+		return false;
+	}
+	set_syscall_costs(costs);
+	return true;
+}
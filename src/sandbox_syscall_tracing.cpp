@@ -0,0 +1,229 @@
+#include "sandbox.h"
+
+#include "syscalls.h"
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <utility>
+
+// System call tracing: While any sandbox is being traced, each Godot API system call
+// handler is replaced by a wrapper that measures it before calling the original handler.
+// The handlers are shared by all machines, so untraced sandboxes take a single branch
+// in the wrapper, and when no sandbox is traced the original handlers are restored.
+static constexpr size_t MAX_SYSCALL_SPANS = 1'000'000;
+
+using syscall_fn = void (*)(machine_t &);
+static syscall_fn untraced_syscall_handlers[Sandbox::TRACED_SYSCALLS];
+
+String Sandbox::syscall_name(unsigned index) {
+	switch (GAME_API_BASE + index) {
+		case ECALL_PRINT: return "print";
+		case ECALL_VCALL: return "vcall";
+		case ECALL_VEVAL: return "veval";
+		case ECALL_VFREE: return "vfree";
+		case ECALL_GET_OBJ: return "get_obj";
+		case ECALL_OBJ: return "obj";
+		case ECALL_OBJ_CALLP: return "obj_callp";
+		case ECALL_GET_NODE: return "get_node";
+		case ECALL_NODE: return "node";
+		case ECALL_NODE2D: return "node2d";
+		case ECALL_NODE3D: return "node3d";
+		case ECALL_THROW: return "throw";
+		case ECALL_IS_EDITOR: return "is_editor";
+		case ECALL_SINCOS: return "sincos";
+		case ECALL_VEC2_LENGTH: return "vec2_length";
+		case ECALL_VEC2_NORMALIZED: return "vec2_normalized";
+		case ECALL_VEC2_ROTATED: return "vec2_rotated";
+		case ECALL_VCREATE: return "vcreate";
+		case ECALL_VCLONE: return "vclone";
+		case ECALL_VFETCH: return "vfetch";
+		case ECALL_VSTORE: return "vstore";
+		case ECALL_ARRAY_OPS: return "array_ops";
+		case ECALL_ARRAY_AT: return "array_at";
+		case ECALL_ARRAY_SIZE: return "array_size";
+		case ECALL_DICTIONARY_OPS: return "dictionary_ops";
+		case ECALL_STRING_CREATE: return "string_create";
+		case ECALL_STRING_OPS: return "string_ops";
+		case ECALL_STRING_AT: return "string_at";
+		case ECALL_STRING_SIZE: return "string_size";
+		case ECALL_STRING_APPEND: return "string_append";
+		case ECALL_TIMER_PERIODIC: return "timer_periodic";
+		case ECALL_TIMER_STOP: return "timer_stop";
+		case ECALL_NODE_CREATE: return "node_create";
+		case ECALL_MATH_OP32: return "math_op32";
+		case ECALL_MATH_OP64: return "math_op64";
+		case ECALL_LERP_OP32: return "lerp_op32";
+		case ECALL_LERP_OP64: return "lerp_op64";
+		case ECALL_VEC3_OPS: return "vec3_ops";
+		case ECALL_VSTORE_RANGE: return "vstore_range";
+		case ECALL_VBYTES: return "vbytes";
+		case ECALL_METHOD_HANDLE: return "method_handle";
+		case ECALL_VMETHOD_CALL: return "vmethod_call";
+		case ECALL_OBJ_METHOD_CALL: return "obj_method_call";
+		case ECALL_INTERN_NAME: return "intern_name";
+		default: return "ecall_" + String::num_uint64(GAME_API_BASE + index);
+	}
+}
+
+template <size_t N>
+void Sandbox::traced_syscall(machine_t &machine) {
+	Sandbox &emu = *machine.get_userdata<Sandbox>();
+	if (!emu.m_syscall_tracing) {
+		untraced_syscall_handlers[N](machine);
+		return;
+	}
+	const uint64_t bytes_before = emu.m_syscall_bytes;
+	const uint64_t t0 = profile_ticks();
+	try {
+		untraced_syscall_handlers[N](machine);
+	} catch (...) {
+		emu.record_syscall(N, t0, bytes_before);
+		throw;
+	}
+	emu.record_syscall(N, t0, bytes_before);
+}
+
+void Sandbox::install_syscall_tracing(bool enable) {
+	static const auto traced_handlers = []<size_t... N>(std::index_sequence<N...>) {
+		return std::array<syscall_fn, sizeof...(N)>{ &Sandbox::traced_syscall<N>... };
+	}(std::make_index_sequence<TRACED_SYSCALLS>{});
+
+	for (unsigned i = 0; i < TRACED_SYSCALLS; i++) {
+		const size_t number = GAME_API_BASE + i;
+		const syscall_fn current = machine_t::syscall_handlers[number];
+		if (enable) {
+			// Handlers that aren't installed yet are wrapped when they are
+			if (current == nullptr || current == traced_handlers[i]) {
+				continue;
+			}
+			untraced_syscall_handlers[i] = current;
+			machine_t::install_syscall_handler(number, traced_handlers[i]);
+		} else if (current == traced_handlers[i]) {
+			machine_t::install_syscall_handler(number, untraced_syscall_handlers[i]);
+		}
+	}
+}
+
+void Sandbox::set_syscall_tracing(bool syscall_tracing) {
+	if (syscall_tracing == this->m_syscall_tracing) {
+		return;
+	}
+	this->m_syscall_tracing = syscall_tracing;
+	if (syscall_tracing) {
+		if (!this->m_syscall_trace) {
+			this->m_syscall_trace = std::make_unique<SyscallTrace>();
+			this->m_syscall_trace->clock_offset = int64_t(Time::get_singleton()->get_ticks_usec() * 1000) - int64_t(profile_ticks());
+		}
+		if (m_syscall_tracing_instances++ == 0) {
+			install_syscall_tracing(true);
+		}
+	} else if (--m_syscall_tracing_instances == 0) {
+		install_syscall_tracing(false);
+	}
+}
+
+void Sandbox::record_syscall(unsigned index, uint64_t t0, uint64_t bytes_before) {
+	const uint64_t elapsed = profile_ticks() - t0;
+	const uint64_t bytes = this->m_syscall_bytes - bytes_before;
+	auto update = [&](SyscallStats &stats) {
+		stats.calls++;
+		stats.time += elapsed;
+		stats.bytes += bytes;
+	};
+	update(m_syscall_trace->stats[index]);
+	// The global statistics are not shared with worker threads, so parallel calls are only traced per sandbox
+	if (!m_in_parallel_call) {
+		update(m_global_syscall_stats[index]);
+	}
+	std::vector<SyscallTrace::Span> &spans = m_syscall_trace->spans;
+	if (spans.size() < MAX_SYSCALL_SPANS) {
+		spans.push_back({ t0, Engine::get_singleton()->get_process_frames(), uint32_t(std::min<uint64_t>(elapsed, UINT32_MAX)), index, bytes });
+	}
+}
+
+template <typename StatsArray>
+static Dictionary syscall_stats_to_dictionary(const StatsArray &all_stats) {
+	Dictionary result;
+	for (unsigned i = 0; i < all_stats.size(); i++) {
+		const auto &stats = all_stats[i];
+		if (stats.calls == 0) {
+			continue;
+		}
+		Dictionary entry;
+		entry["calls"] = int64_t(stats.calls);
+		entry["time"] = stats.time / 1e9;
+		entry["bytes"] = int64_t(stats.bytes);
+		result[Sandbox::syscall_name(i)] = entry;
+	}
+	return result;
+}
+
+Dictionary Sandbox::get_syscall_trace() const {
+	if (!this->m_syscall_trace) {
+		return Dictionary();
+	}
+	return syscall_stats_to_dictionary(this->m_syscall_trace->stats);
+}
+
+Dictionary Sandbox::get_global_syscall_trace() {
+	return syscall_stats_to_dictionary(m_global_syscall_stats);
+}
+
+void Sandbox::clear_syscall_trace() {
+	if (this->m_syscall_trace) {
+		this->m_syscall_trace->stats = {};
+		this->m_syscall_trace->spans.clear();
+	}
+}
+
+bool Sandbox::save_syscall_trace(const String &path) const {
+	if (!this->m_syscall_trace || this->m_syscall_trace->spans.empty()) {
+		ERR_PRINT("Sandbox: No system calls have been traced, enable syscall_tracing first.");
+		return false;
+	}
+	const SyscallTrace &trace = *this->m_syscall_trace;
+	Array events;
+	uint64_t frame = UINT64_MAX;
+	for (const SyscallTrace::Span &span : trace.spans) {
+		// Chrome traces are in microseconds
+		const double ts = (int64_t(span.start) + trace.clock_offset) / 1e3;
+		if (span.frame != frame) {
+			// Mark the first traced system call of each engine frame
+			frame = span.frame;
+			Dictionary marker;
+			marker["name"] = "Frame " + String::num_uint64(frame);
+			marker["ph"] = "i";
+			marker["s"] = "g";
+			marker["ts"] = ts;
+			marker["pid"] = 1;
+			marker["tid"] = 1;
+			events.push_back(marker);
+		}
+		Dictionary event;
+		event["name"] = syscall_name(span.index);
+		event["cat"] = "syscall";
+		event["ph"] = "X";
+		event["ts"] = ts;
+		event["dur"] = span.duration / 1e3;
+		event["pid"] = 1;
+		event["tid"] = 1;
+		Dictionary args;
+		args["frame"] = int64_t(span.frame);
+		event["args"] = args;
+		events.push_back(event);
+	}
+	Dictionary output;
+	output["traceEvents"] = events;
+	output["displayTimeUnit"] = "ns";
+
+	DirAccess::make_dir_recursive_absolute(path.get_base_dir());
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::ModeFlags::WRITE);
+	if (file.is_null()) {
+		ERR_PRINT("Sandbox: Unable to open system call trace for writing: " + path);
+		return false;
+	}
+	file->store_string(JSON::stringify(output));
+	return true;
+}
@@ -23,23 +23,26 @@ inline Sandbox &emu(machine_t &m) {
 	return *m.get_userdata<Sandbox>();
 }
 
+// Guests refer to objects by the handles given out by Sandbox::add_scoped_object
 inline godot::Object *get_object_from_address(Sandbox &emu, uint64_t addr) {
-	godot::Object *obj = (godot::Object *)uintptr_t(addr);
-	if (obj == nullptr) {
+	if (addr == 0) {
 		ERR_PRINT("Object is Null");
 		throw std::runtime_error("Object is Null");
-	} else if (!emu.is_scoped_object(obj)) {
+	}
+	godot::Object *obj = emu.get_scoped_object(addr);
+	if (obj == nullptr) {
 		ERR_PRINT("Object is not scoped");
 		throw std::runtime_error("Object is not scoped");
 	}
 	return obj;
 }
 inline godot::Node *get_node_from_address(Sandbox &emu, uint64_t addr) {
-	godot::Node *node = (godot::Node *)uintptr_t(addr);
-	if (node == nullptr) {
+	if (addr == 0) {
 		ERR_PRINT("Node object is Null");
 		throw std::runtime_error("Node object is Null");
-	} else if (!emu.is_scoped_object(node)) {
+	}
+	godot::Node *node = godot::Object::cast_to<godot::Node>(emu.get_scoped_object(addr));
+	if (node == nullptr) {
 		ERR_PRINT("Node object is not scoped");
 		throw std::runtime_error("Node object is not scoped");
 	}
@@ -69,6 +72,15 @@ static inline Variant object_call(Sandbox &emu, godot::Object *obj, const Varian
 	return object_callp(obj, vargs.data(), argc + 1);
 }
 
+// In parallel calls, system calls that change the scene record a method call instead,
+// which is made on the main thread once the parallel call has finished.
+template <typename... Args>
+static inline void defer_command(Sandbox &emu, godot::Object *obj, const StringName &method, Args &&...args) {
+	Array arguments;
+	(arguments.push_back(std::forward<Args>(args)), ...);
+	emu.defer_command(obj, method, std::move(arguments));
+}
+
 #define APICALL(func) static void func(machine_t &machine [[maybe_unused]])
 
 APICALL(api_print) {
@@ -93,7 +105,6 @@ APICALL(api_print) {
 
 APICALL(api_vcall) {
 	auto [vp, method, mlen, args_ptr, args_size, vret] = machine.sysargs<GuestVariant *, gaddr_t, unsigned, gaddr_t, gaddr_t, GuestVariant *>();
-	(void)mlen;
 
 	Sandbox &emu = riscv::emu(machine);
 
@@ -103,20 +114,27 @@ APICALL(api_vcall) {
 	}
 
 	const GuestVariant *args = machine.memory.memarray<GuestVariant>(args_ptr, args_size);
-	Variant vmethod;
-	std::string_view method_sv = machine.memory.rvview(method, mlen + 1); // Include null terminator.
-	if (method_sv.back() == '\0') {
-		vmethod = Variant(StringName(method_sv.data()));
-	} else {
-		vmethod = Variant(String::utf8(method_sv.data(), mlen));
-	}
+	const Variant vmethod = emu.guest_name(method, mlen);
 
 	Variant ret;
 
 	if (vp->type == Variant::OBJECT) {
+		if (emu.is_worker_fork()) [[unlikely]] {
+			ERR_PRINT("Variant::call(): Objects cannot be accessed on worker threads");
+			throw std::runtime_error("Variant::call(): Objects cannot be accessed on worker threads");
+		}
 		godot::Object *obj = get_object_from_address(emu, vp->v.i);
 
-		ret = object_call(emu, obj, vmethod, args, args_size);
+		if (emu.is_in_parallel_call()) [[unlikely]] {
+			// The call is made later on the main thread, so its return value is not available
+			Array deferred_args;
+			for (unsigned i = 0; i < args_size; i++) {
+				deferred_args.push_back(args[i].toVariant(emu));
+			}
+			emu.defer_command(obj, vmethod, std::move(deferred_args));
+		} else {
+			ret = object_call(emu, obj, vmethod, args, args_size);
+		}
 	} else {
 		std::array<Variant, 8> vargs;
 		std::array<const Variant *, 8> argptrs;
@@ -178,7 +196,7 @@ APICALL(api_veval) {
 APICALL(api_vcreate) {
 	auto [vp, type, method, gdata] = machine.sysargs<GuestVariant *, Variant::Type, int, gaddr_t>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(10'000);
+	emu.penalize_syscall(ECALL_VCREATE);
 
 	switch (type) {
 		case Variant::STRING:
@@ -188,9 +206,11 @@ APICALL(api_vcreate) {
 			if (method == 0) {
 				GuestStdString *str = machine.memory.memarray<GuestStdString>(gdata, 1);
 				godot_str = str->to_godot_string(machine);
+				emu.add_syscall_bytes(ECALL_VCREATE, str->size);
 			} else if (method == 2) { // From std::u32string
 				GuestStdU32String *str = machine.memory.memarray<GuestStdU32String>(gdata, 1);
 				godot_str = str->to_godot_string(machine);
+				emu.add_syscall_bytes(ECALL_VCREATE, str->size * sizeof(char32_t));
 			} else {
 				ERR_PRINT("vcreate: Unsupported method for Variant::STRING");
 				throw std::runtime_error("vcreate: Unsupported method for Variant::STRING: " + std::to_string(method));
@@ -207,6 +227,7 @@ APICALL(api_vcreate) {
 				// Copy std::vector<Variant> from guest memory.
 				GuestStdVector *gvec = machine.memory.memarray<GuestStdVector>(gdata, 1);
 				std::vector<GuestVariant> vec = gvec->to_vector<GuestVariant>(machine);
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(GuestVariant));
 				for (const GuestVariant &v : vec) {
 					a.push_back(std::move(v.toVariant(emu)));
 				}
@@ -230,6 +251,7 @@ APICALL(api_vcreate) {
 				std::vector<uint8_t> vec = gvec->to_vector<uint8_t>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size());
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size());
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -243,6 +265,7 @@ APICALL(api_vcreate) {
 				std::vector<float> vec = gvec->to_vector<float>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(float));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(float));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -256,6 +279,7 @@ APICALL(api_vcreate) {
 				std::vector<double> vec = gvec->to_vector<double>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(double));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(double));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -269,6 +293,7 @@ APICALL(api_vcreate) {
 				std::vector<int32_t> vec = gvec->to_vector<int32_t>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(int32_t));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(int32_t));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -282,6 +307,7 @@ APICALL(api_vcreate) {
 				std::vector<int64_t> vec = gvec->to_vector<int64_t>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(int64_t));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(int64_t));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -295,6 +321,7 @@ APICALL(api_vcreate) {
 				std::vector<Vector2> vec = gvec->to_vector<Vector2>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(Vector2));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(Vector2));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -308,6 +335,7 @@ APICALL(api_vcreate) {
 				std::vector<Vector3> vec = gvec->to_vector<Vector3>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(Vector3));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(Vector3));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -321,6 +349,7 @@ APICALL(api_vcreate) {
 				std::vector<Color> vec = gvec->to_vector<Color>(machine);
 				a.resize(vec.size());
 				std::memcpy(a.ptrw(), vec.data(), vec.size() * sizeof(Color));
+				emu.add_syscall_bytes(ECALL_VCREATE, vec.size() * sizeof(Color));
 			}
 			unsigned idx = emu.create_scoped_variant(Variant(std::move(a)));
 			vp->type = type;
@@ -332,13 +361,95 @@ APICALL(api_vcreate) {
 	}
 }
 
+// Call fn with a std::type_identity of the packed array type of a Variant
+template <typename Fn>
+static void visit_packed_array(Variant::Type type, Fn &&fn) {
+	switch (type) {
+		case Variant::PACKED_BYTE_ARRAY:
+			fn(std::type_identity<PackedByteArray>{});
+			break;
+		case Variant::PACKED_INT32_ARRAY:
+			fn(std::type_identity<PackedInt32Array>{});
+			break;
+		case Variant::PACKED_INT64_ARRAY:
+			fn(std::type_identity<PackedInt64Array>{});
+			break;
+		case Variant::PACKED_FLOAT32_ARRAY:
+			fn(std::type_identity<PackedFloat32Array>{});
+			break;
+		case Variant::PACKED_FLOAT64_ARRAY:
+			fn(std::type_identity<PackedFloat64Array>{});
+			break;
+		case Variant::PACKED_VECTOR2_ARRAY:
+			fn(std::type_identity<PackedVector2Array>{});
+			break;
+		case Variant::PACKED_VECTOR3_ARRAY:
+			fn(std::type_identity<PackedVector3Array>{});
+			break;
+		case Variant::PACKED_COLOR_ARRAY:
+			fn(std::type_identity<PackedColorArray>{});
+			break;
+		default:
+			ERR_PRINT("Ranged access requires a packed array");
+			throw std::runtime_error("Ranged access requires a packed array");
+	}
+}
+
+// The number of elements in a strided range, clamped to the end of an array
+static uint64_t range_elements(uint64_t size, uint64_t offset, uint64_t count, uint64_t stride) {
+	if (stride == 0) {
+		throw std::runtime_error("Ranged access requires a stride of at least 1");
+	}
+	const uint64_t available = offset < size ? (size - offset - 1) / stride + 1 : 0;
+	return std::min(count, available);
+}
+
 APICALL(api_vfetch) {
 	auto [index, gdata, method] = machine.sysargs<unsigned, gaddr_t, int>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(10'000);
+	emu.penalize_syscall(ECALL_VFETCH);
 
 	// Find scoped Variant and copy data into gdata.
 	std::optional<const Variant *> opt = emu.get_scoped_variant(index);
+	if (opt.has_value() && method == 5) {
+		// Copy a strided range of a packed array, which ends early at the end of the array
+		const uint64_t offset = machine.sysarg<uint64_t>(3);
+		const uint64_t count = machine.sysarg<uint64_t>(4);
+		const uint64_t stride = machine.sysarg<uint64_t>(5);
+		const Variant &var = *opt.value();
+		visit_packed_array(var.get_type(), [&](auto packed_type) {
+			using PackedT = typename decltype(packed_type)::type;
+			const PackedT arr = var;
+			using T = std::remove_const_t<std::remove_pointer_t<decltype(arr.ptr())>>;
+			const uint64_t elements = range_elements(arr.size(), offset, count, stride);
+			auto *gvec = machine.memory.memarray<GuestStdVector>(gdata, 1);
+			auto [sptr, saddr] = gvec->alloc<T>(machine, elements);
+			if (elements == 0) {
+				return;
+			}
+			const T *src = arr.ptr() + offset;
+			if (stride == 1) {
+				std::memcpy(sptr, src, elements * sizeof(T));
+			} else {
+				for (uint64_t i = 0; i < elements; i++) {
+					sptr[i] = src[i * stride];
+				}
+			}
+			emu.add_syscall_bytes(ECALL_VFETCH, elements * sizeof(T));
+		});
+		return;
+	}
+	if (opt.has_value() && (method == 3 || method == 4)) {
+		// Map the packed array into the guest instead, read-only (3) or read-write (4)
+		auto *gmap = machine.memory.memarray<GuestMappedArray>(gdata, 1);
+		const Variant &var = *opt.value();
+		unsigned new_index = index;
+		size_t bytes = 0;
+		const gaddr_t address = emu.map_packed_array(var, method == 4, new_index, bytes);
+		gmap->view.assign_shared<uint8_t>(machine, address, bytes);
+		gmap->index = new_index;
+		return;
+	}
 	if (opt.has_value()) {
 		const godot::Variant &var = *opt.value();
 		switch (var.get_type()) {
@@ -349,10 +460,12 @@ APICALL(api_vfetch) {
 					auto u8str = var.operator String().utf8();
 					auto *gstr = machine.memory.memarray<GuestStdString>(gdata, 1);
 					gstr->set_string(machine, gdata, u8str.ptr(), u8str.length());
+					emu.add_syscall_bytes(ECALL_VFETCH, u8str.length());
 				} else if (method == 2) { // std::u32string
 					auto u32str = var.operator String();
 					auto *gstr = machine.memory.memarray<GuestStdU32String>(gdata, 1);
 					gstr->set_string(machine, gdata, u32str.ptr(), u32str.length());
+					emu.add_syscall_bytes(ECALL_VFETCH, u32str.length() * sizeof(char32_t));
 				} else {
 					ERR_PRINT("vfetch: Unsupported method for Variant::STRING");
 					throw std::runtime_error("vfetch: Unsupported method for Variant::STRING");
@@ -364,6 +477,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedByteArray();
 				auto [sptr, saddr] = gvec->alloc<uint8_t>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size());
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size());
 				break;
 			}
 			case Variant::PACKED_FLOAT32_ARRAY: {
@@ -372,6 +486,7 @@ APICALL(api_vfetch) {
 				// Allocate and copy the array into the guest memory.
 				auto [sptr, saddr] = gvec->alloc<float>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(float));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(float));
 				break;
 			}
 			case Variant::PACKED_FLOAT64_ARRAY: {
@@ -379,6 +494,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedFloat64Array();
 				auto [sptr, saddr] = gvec->alloc<double>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(double));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(double));
 				break;
 			}
 			case Variant::PACKED_INT32_ARRAY: {
@@ -386,6 +502,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedInt32Array();
 				auto [sptr, saddr] = gvec->alloc<int32_t>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(int32_t));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(int32_t));
 				break;
 			}
 			case Variant::PACKED_INT64_ARRAY: {
@@ -393,6 +510,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedInt64Array();
 				auto [sptr, saddr] = gvec->alloc<int64_t>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(int64_t));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(int64_t));
 				break;
 			}
 			case Variant::PACKED_VECTOR2_ARRAY: {
@@ -400,6 +518,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedVector2Array();
 				auto [sptr, saddr] = gvec->alloc<Vector2>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(Vector2));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(Vector2));
 				break;
 			}
 			case Variant::PACKED_VECTOR3_ARRAY: {
@@ -407,6 +526,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedVector3Array();
 				auto [sptr, saddr] = gvec->alloc<Vector3>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(Vector3));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(Vector3));
 				break;
 			}
 			case Variant::PACKED_COLOR_ARRAY: {
@@ -414,6 +534,7 @@ APICALL(api_vfetch) {
 				auto arr = var.operator PackedColorArray();
 				auto [sptr, saddr] = gvec->alloc<Color>(machine, arr.size());
 				std::memcpy(sptr, arr.ptr(), arr.size() * sizeof(Color));
+				emu.add_syscall_bytes(ECALL_VFETCH, arr.size() * sizeof(Color));
 				break;
 			}
 			default:
@@ -429,7 +550,7 @@ APICALL(api_vfetch) {
 APICALL(api_vclone) {
 	auto [vp, vret] = machine.sysargs<GuestVariant *, GuestVariant *>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(10'000);
+	emu.penalize_syscall(ECALL_VCLONE);
 
 	// Find scoped Variant and clone it.
 	std::optional<const Variant *> var = emu.get_scoped_variant(vp->v.i);
@@ -446,7 +567,7 @@ APICALL(api_vclone) {
 APICALL(api_vstore) {
 	auto [index, gdata, gsize] = machine.sysargs<unsigned, gaddr_t, gaddr_t>();
 	auto &emu = riscv::emu(machine);
-	machine.penalize(10'000);
+	emu.penalize_syscall(ECALL_VSTORE);
 
 	// Find scoped Variant and store data from guest memory.
 	std::optional<const Variant *> opt = emu.get_scoped_variant(index);
@@ -459,6 +580,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<uint8_t>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize);
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize);
 				break;
 			}
 			case Variant::PACKED_FLOAT32_ARRAY: {
@@ -467,6 +589,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<float>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(float));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(float));
 				break;
 			}
 			case Variant::PACKED_FLOAT64_ARRAY: {
@@ -475,6 +598,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<double>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(double));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(double));
 				break;
 			}
 			case Variant::PACKED_INT32_ARRAY: {
@@ -483,6 +607,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<int32_t>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(int32_t));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(int32_t));
 				break;
 			}
 			case Variant::PACKED_INT64_ARRAY: {
@@ -491,6 +616,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<int64_t>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(int64_t));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(int64_t));
 				break;
 			}
 			case Variant::PACKED_VECTOR2_ARRAY: {
@@ -499,6 +625,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<Vector2>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(Vector2));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(Vector2));
 				break;
 			}
 			case Variant::PACKED_VECTOR3_ARRAY: {
@@ -507,6 +634,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<Vector3>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(Vector3));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(Vector3));
 				break;
 			}
 			case Variant::PACKED_COLOR_ARRAY: {
@@ -515,6 +643,7 @@ APICALL(api_vstore) {
 				auto *data = machine.memory.memarray<Color>(gdata, gsize);
 				arr.resize(gsize);
 				std::memcpy(arr.ptrw(), data, gsize * sizeof(Color));
+				emu.add_syscall_bytes(ECALL_VSTORE, gsize * sizeof(Color));
 				break;
 			}
 			default:
@@ -527,10 +656,119 @@ APICALL(api_vstore) {
 	}
 }
 
+APICALL(api_vstore_range) {
+	auto [index, offset, gdata, count] = machine.sysargs<unsigned, uint64_t, gaddr_t, uint64_t>();
+	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_VSTORE_RANGE);
+
+	// Overwrite a range of a packed array in place, which is only copied if it's shared
+	Variant *var = nullptr;
+	const unsigned new_index = emu.owned_scoped_variant(index, var);
+	visit_packed_array(var->get_type(), [&](auto packed_type) {
+		using PackedT = typename decltype(packed_type)::type;
+		PackedT arr = *var;
+		using T = std::remove_const_t<std::remove_pointer_t<decltype(arr.ptr())>>;
+		if (offset > uint64_t(arr.size()) || count > uint64_t(arr.size()) - offset) {
+			ERR_PRINT("vstore: Range is out of bounds");
+			throw std::runtime_error("vstore: Range is out of bounds");
+		}
+		const T *data = machine.memory.memarray<T>(gdata, count);
+		// Drop the reference held by the Variant, so that the array isn't shared with it
+		*var = Variant();
+		std::memcpy(arr.ptrw() + offset, data, count * sizeof(T));
+		*var = Variant(arr);
+		emu.add_syscall_bytes(ECALL_VSTORE_RANGE, count * sizeof(T));
+	});
+	// The guest continues with the new index, if the array had to be copied
+	machine.set_result(new_index);
+}
+
+bool Sandbox::contains_object(const Variant &var, unsigned depth) {
+	if (depth > 512) {
+		return true; // Too deep to encode, or a container that contains itself
+	}
+	switch (var.get_type()) {
+		case Variant::OBJECT:
+		case Variant::CALLABLE:
+		case Variant::SIGNAL:
+			return true;
+		case Variant::ARRAY: {
+			const Array arr = var;
+			for (int64_t i = 0; i < arr.size(); i++) {
+				if (contains_object(arr[i], depth + 1)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case Variant::DICTIONARY: {
+			const Dictionary dict = var;
+			const Array keys = dict.keys();
+			for (int64_t i = 0; i < keys.size(); i++) {
+				if (contains_object(keys[i], depth + 1) || contains_object(dict[keys[i]], depth + 1)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		default:
+			return false;
+	}
+}
+
+APICALL(api_vbytes) {
+	auto [op, vaddr, gdata, gsize] = machine.sysargs<VBytes_Op, gaddr_t, gaddr_t, gaddr_t>();
+	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_VBYTES);
+
+	// A whole tree of Variants crosses in one system call, in the format of var_to_bytes()
+	switch (op) {
+		case VBytes_Op::ENCODE: {
+			const GuestVariant *vp = machine.memory.memarray<GuestVariant>(vaddr, 1);
+			const Variant var = vp->toVariant(emu);
+			// Objects are encoded by their instance ID, and decoded as EncodedObjectAsID,
+			// so they can't cross as bytes, not even inside of Arrays and Dictionaries.
+			if (Sandbox::contains_object(var)) {
+				ERR_PRINT("vbytes: Objects cannot be encoded");
+				throw std::runtime_error("vbytes: Objects cannot be encoded");
+			}
+			const PackedByteArray bytes = UtilityFunctions::var_to_bytes(var);
+			if (bytes.is_empty()) {
+				ERR_PRINT("vbytes: Variant cannot be encoded");
+				throw std::runtime_error("vbytes: Variant cannot be encoded");
+			}
+			auto *gvec = machine.memory.memarray<GuestStdVector>(gdata, 1);
+			auto [sptr, saddr] = gvec->alloc<uint8_t>(machine, bytes.size());
+			std::memcpy(sptr, bytes.ptr(), bytes.size());
+			emu.add_syscall_bytes(ECALL_VBYTES, bytes.size());
+			break;
+		}
+		case VBytes_Op::DECODE: {
+			// The guest range is validated before anything is allocated for it
+			const std::string_view data = machine.memory.memview(gdata, gsize);
+			PackedByteArray bytes;
+			bytes.resize(data.size());
+			std::memcpy(bytes.ptrw(), data.data(), data.size());
+			emu.add_syscall_bytes(ECALL_VBYTES, data.size());
+			Variant var = UtilityFunctions::bytes_to_var(bytes);
+			if (Sandbox::contains_object(var)) {
+				ERR_PRINT("vbytes: Objects cannot be decoded");
+				throw std::runtime_error("vbytes: Objects cannot be decoded");
+			}
+			GuestVariant *vp = machine.memory.memarray<GuestVariant>(vaddr, 1);
+			vp->create(emu, std::move(var));
+			break;
+		}
+		default:
+			ERR_PRINT("vbytes: Invalid operation");
+			throw std::runtime_error("vbytes: Invalid operation");
+	}
+}
+
 APICALL(api_vfree) {
 	auto [vp] = machine.sysargs<GuestVariant *>();
 	auto &emu = riscv::emu(machine);
-	machine.penalize(10'000);
+	emu.penalize_syscall(ECALL_VFREE);
 
 	// XXX: No longer needed, as we are abstracting the Variant object.
 }
@@ -538,7 +776,7 @@ APICALL(api_vfree) {
 APICALL(api_get_obj) {
 	auto [name] = machine.sysargs<std::string>();
 	auto &emu = riscv::emu(machine);
-	machine.penalize(150'000);
+	emu.penalize_syscall(ECALL_GET_OBJ);
 
 	// Objects retrieved by name are named globals, eg. "Engine", "Input", "Time",
 	// which are also their class names. As such, we can restrict access using
@@ -553,8 +791,7 @@ APICALL(api_get_obj) {
 	auto it = allowed_objects.find(name);
 	if (it != allowed_objects.end()) {
 		auto obj = it->second();
-		emu.add_scoped_object(reinterpret_cast<godot::Object *>(obj));
-		machine.set_result(obj);
+		machine.set_result(emu.add_scoped_object(reinterpret_cast<godot::Object *>(obj)));
 		return;
 	}
 	// Special case for SceneTree.
@@ -567,8 +804,7 @@ APICALL(api_get_obj) {
 			return;
 		}
 		SceneTree *tree = owner_node->get_tree();
-		emu.add_scoped_object(tree);
-		machine.set_result(uint64_t(uintptr_t(tree)));
+		machine.set_result(emu.add_scoped_object(tree));
 	} else {
 		ERR_PRINT(("Unknown or inaccessible object: " + name).c_str());
 		machine.set_result(0);
@@ -578,13 +814,9 @@ APICALL(api_get_obj) {
 APICALL(api_obj) {
 	auto [op, addr, gvar] = machine.sysargs<int, uint64_t, gaddr_t>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(250'000); // Costly Object operations.
+	emu.penalize_syscall(ECALL_OBJ);
 
-	godot::Object *obj = reinterpret_cast<godot::Object *>(uintptr_t(addr));
-	if (!emu.is_scoped_object(obj)) {
-		ERR_PRINT("Object is not scoped");
-		throw std::runtime_error("Object is not scoped");
-	}
+	godot::Object *obj = get_object_from_address(emu, addr);
 
 	switch (Object_Op(op)) {
 		case Object_Op::GET_METHOD_LIST: {
@@ -607,7 +839,10 @@ APICALL(api_obj) {
 		case Object_Op::SET: { // Set a property of the object.
 			GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 2);
 			String name = var[0].toVariant(emu).operator String();
-			obj->set(name, var[1].toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, obj, "set", name, var[1].toVariant(emu));
+			else
+				obj->set(name, var[1].toVariant(emu));
 		} break;
 		case Object_Op::GET_PROPERTY_LIST: {
 			GuestStdVector *vec = machine.memory.memarray<GuestStdVector>(gvar, 1);
@@ -625,13 +860,19 @@ APICALL(api_obj) {
 			GuestVariant *vars = machine.memory.memarray<GuestVariant>(gvar, 3);
 			godot::Object *target = get_object_from_address(emu, vars[0].v.i);
 			Callable callable = Callable(target, vars[2].toVariant(emu).operator String());
-			obj->connect(vars[1].toVariant(emu).operator String(), callable);
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, obj, "connect", vars[1].toVariant(emu).operator String(), callable);
+			else
+				obj->connect(vars[1].toVariant(emu).operator String(), callable);
 		} break;
 		case Object_Op::DISCONNECT: {
 			GuestVariant *vars = machine.memory.memarray<GuestVariant>(gvar, 3);
 			godot::Object *target = get_object_from_address(emu, vars[0].v.i);
 			auto callable = Callable(target, vars[2].toVariant(emu).operator String());
-			obj->disconnect(vars[1].toVariant(emu).operator String(), callable);
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, obj, "disconnect", vars[1].toVariant(emu).operator String(), callable);
+			else
+				obj->disconnect(vars[1].toVariant(emu).operator String(), callable);
 		} break;
 		case Object_Op::GET_SIGNAL_LIST: {
 			GuestStdVector *vec = machine.memory.memarray<GuestStdVector>(gvar, 1);
@@ -645,36 +886,171 @@ APICALL(api_obj) {
 				sptr[i].set_string(machine, self, name.ptr(), name.length());
 			}
 		} break;
+		case Object_Op::PIN: { // Keep the object handle valid across calls.
+			GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 1);
+			var->set(emu, emu.pin_scoped_object(addr));
+		} break;
+		case Object_Op::UNPIN: { // Release the object handle at the end of the current call.
+			GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 1);
+			var->set(emu, emu.unpin_scoped_object(addr));
+		} break;
+		case Object_Op::GET_NAMED: { // Get a property of the object, by a name that may be cached.
+			GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 1);
+			const StringName name = emu.guest_name(machine.sysarg<gaddr_t>(3), machine.sysarg<unsigned>(4));
+			var->create(emu, obj->get(name));
+		} break;
+		case Object_Op::SET_NAMED: { // Set a property of the object, by a name that may be cached.
+			const GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 1);
+			const StringName name = emu.guest_name(machine.sysarg<gaddr_t>(3), machine.sysarg<unsigned>(4));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, obj, "set", name, var->toVariant(emu));
+			else
+				obj->set(name, var->toVariant(emu));
+		} break;
 		default:
 			throw std::runtime_error("Invalid Object operation");
 	}
 }
 
-APICALL(api_obj_callp) {
-	auto [addr, g_method, g_method_len, deferred, vret_ptr, args_addr, args_size] = machine.sysargs<uint64_t, gaddr_t, unsigned, bool, gaddr_t, gaddr_t, unsigned>();
+APICALL(api_intern_name) {
+	auto [g_name, g_name_len] = machine.sysargs<gaddr_t, unsigned>();
+	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_INTERN_NAME);
+
+	const std::string_view name_view = machine.memory.memview(g_name, g_name_len);
+	machine.set_result(emu.intern_name(String::utf8(name_view.data(), name_view.size())));
+}
+
+APICALL(api_method_handle) {
+	auto [type, g_class, g_class_len, g_method, g_method_len] = machine.sysargs<int, gaddr_t, unsigned, gaddr_t, unsigned>();
+	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_METHOD_HANDLE);
+	if (type <= Variant::NIL || type >= Variant::VARIANT_MAX) {
+		ERR_PRINT("Method handle: Invalid Variant type");
+		throw std::runtime_error("Method handle: Invalid Variant type");
+	}
+
+	// Methods of builtin types have no class name
+	const StringName class_name = g_class_len > 0 ? emu.guest_name(g_class, g_class_len) : StringName();
+	const StringName method = emu.guest_name(g_method, g_method_len);
+	machine.set_result(emu.resolve_method_handle(Variant::Type(type), class_name, method));
+}
+
+// Call a method of an object by its handle. On worker threads, the call is deferred to the main thread.
+static Variant object_method_call(Sandbox &emu, const Sandbox::MethodHandle &handle, godot::Object *obj, const GuestVariant *args, unsigned argc) {
+	Variant ret;
+	if (emu.is_in_parallel_call()) [[unlikely]] {
+		// The call is made later on the main thread, so its return value is not available
+		Array deferred_args;
+		for (unsigned i = 0; i < argc; i++) {
+			deferred_args.push_back(args[i].toVariant(emu));
+		}
+		emu.defer_command(obj, handle.method, std::move(deferred_args));
+	} else if (!emu.call_fast_method(handle, obj, args, argc, ret)) {
+		// The method may call back into the guest, which may resolve new handles, so the name is copied first
+		const Variant method = handle.method;
+		ret = object_call(emu, obj, method, args, argc);
+	}
+	return ret;
+}
+
+APICALL(api_vmethod_call) {
+	auto [handle_index, vp, args_ptr, args_size, vret] = machine.sysargs<unsigned, GuestVariant *, gaddr_t, unsigned, GuestVariant *>();
+	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_VMETHOD_CALL);
+	const Sandbox::MethodHandle &handle = emu.get_method_handle(handle_index);
+	if (handle.type != vp->type) {
+		ERR_PRINT("Variant::call(): Method handle is for another type");
+		throw std::runtime_error("Variant::call(): Method handle is for another type");
+	}
+	if (args_size > 8) {
+		ERR_PRINT("Variant::call(): Too many arguments");
+		throw std::runtime_error("Variant::call(): Too many arguments");
+	}
+	const GuestVariant *args = machine.memory.memarray<GuestVariant>(args_ptr, args_size);
+
+	Variant ret;
+	if (vp->type == Variant::OBJECT) {
+		if (emu.is_worker_fork()) [[unlikely]] {
+			ERR_PRINT("Variant::call(): Objects cannot be accessed on worker threads");
+			throw std::runtime_error("Variant::call(): Objects cannot be accessed on worker threads");
+		}
+		godot::Object *obj = get_object_from_address(emu, vp->v.i);
+		ret = object_method_call(emu, handle, obj, args, args_size);
+	} else if (!emu.call_fast_method(handle, *vp, args, args_size, ret)) {
+		std::array<Variant, 8> vargs;
+		std::array<const Variant *, 8> argptrs;
+		for (size_t i = 0; i < args_size; i++) {
+			if (args[i].is_scoped_variant()) {
+				argptrs[i] = args[i].toVariantPtr(emu);
+			} else {
+				vargs[i] = args[i].toVariant(emu);
+				argptrs[i] = &vargs[i];
+			}
+		}
+
+		Variant helper;
+		Variant *vcall;
+		if (vp->is_scoped_variant()) {
+			vcall = const_cast<Variant *>(vp->toVariantPtr(emu));
+		} else {
+			helper = vp->toVariant(emu);
+			vcall = &helper;
+		}
+		GDExtensionCallError error;
+		vcall->callp(handle.method, argptrs.data(), args_size, ret, error);
+	}
+	vret->create(emu, std::move(ret));
+}
+
+APICALL(api_obj_method_call) {
+	auto [handle_index, addr, args_addr, args_size, vret_ptr] = machine.sysargs<unsigned, uint64_t, gaddr_t, unsigned, gaddr_t>();
 	auto &emu = riscv::emu(machine);
-	machine.penalize(250'000); // Costly Object call operation.
-	auto *obj = reinterpret_cast<godot::Object *>(uintptr_t(addr));
-	if (!emu.is_scoped_object(obj)) {
-		ERR_PRINT("Object is not scoped");
-		throw std::runtime_error("Object is not scoped");
+	emu.penalize_syscall(ECALL_OBJ_METHOD_CALL);
+	const Sandbox::MethodHandle &handle = emu.get_method_handle(handle_index);
+	if (handle.type != Variant::OBJECT) {
+		ERR_PRINT("Object::call(): Method handle is not for an object");
+		throw std::runtime_error("Object::call(): Method handle is not for an object");
 	}
+	godot::Object *obj = get_object_from_address(emu, addr);
 	if (args_size > 8) {
 		ERR_PRINT("Too many arguments.");
 		throw std::runtime_error("Too many arguments.");
 	}
 	const GuestVariant *g_args = machine.memory.memarray<GuestVariant>(args_addr, args_size);
 
-	Variant method;
-	std::string_view method_view = machine.memory.memview(g_method, g_method_len + 1);
-	// Check if the method is null-terminated.
-	if (method_view.back() == '\0') {
-		method = StringName(method_view.data(), false);
-	} else {
-		method = String::utf8(method_view.data(), method_view.size() - 1);
+	Variant ret = object_method_call(emu, handle, obj, g_args, args_size);
+	if (vret_ptr != 0) {
+		GuestVariant *vret = machine.memory.memarray<GuestVariant>(vret_ptr, 1);
+		vret->create(emu, std::move(ret));
 	}
+}
 
-	if (!deferred) {
+APICALL(api_obj_callp) {
+	auto [addr, g_method, g_method_len, deferred, vret_ptr, args_addr, args_size] = machine.sysargs<uint64_t, gaddr_t, unsigned, bool, gaddr_t, gaddr_t, unsigned>();
+	auto &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_OBJ_CALLP);
+	godot::Object *obj = get_object_from_address(emu, addr);
+	if (args_size > 8) {
+		ERR_PRINT("Too many arguments.");
+		throw std::runtime_error("Too many arguments.");
+	}
+	const GuestVariant *g_args = machine.memory.memarray<GuestVariant>(args_addr, args_size);
+
+	const Variant method = emu.guest_name(g_method, g_method_len);
+
+	if (emu.is_in_parallel_call()) [[unlikely]] {
+		// The call is made later on the main thread, so its return value is not available
+		Array args;
+		for (unsigned i = 0; i < args_size; i++) {
+			args.push_back(g_args[i].toVariant(emu));
+		}
+		emu.defer_command(obj, method, std::move(args));
+		if (vret_ptr != 0) {
+			GuestVariant *vret = machine.memory.memarray<GuestVariant>(vret_ptr, 1);
+			vret->set(emu, Variant());
+		}
+	} else if (!deferred) {
 		Variant ret = object_call(emu, obj, method, g_args, args_size);
 		if (vret_ptr != 0) {
 			GuestVariant *vret = machine.memory.memarray<GuestVariant>(vret_ptr, 1);
@@ -708,7 +1084,7 @@ APICALL(api_obj_callp) {
 APICALL(api_get_node) {
 	auto [addr, name] = machine.sysargs<uint64_t, std::string_view>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(150'000);
+	emu.penalize_syscall(ECALL_GET_NODE);
 	Node *node = nullptr;
 	const std::string c_name(name);
 
@@ -721,8 +1097,8 @@ APICALL(api_get_node) {
 		}
 		node = owner_node->get_node<Node>(NodePath(c_name.c_str()));
 	} else {
-		Node *base_node = reinterpret_cast<Node *>(uintptr_t(addr));
-		if (!emu.is_scoped_object(base_node)) {
+		Node *base_node = Object::cast_to<Node>(emu.get_scoped_object(addr));
+		if (base_node == nullptr) {
 			ERR_PRINT("Node object is not scoped");
 			machine.set_result(0);
 			return;
@@ -735,14 +1111,13 @@ APICALL(api_get_node) {
 		return;
 	}
 
-	emu.add_scoped_object(node);
-	machine.set_result(reinterpret_cast<uint64_t>(node));
+	machine.set_result(emu.add_scoped_object(node));
 }
 
 APICALL(api_node_create) {
 	auto [type, g_class_name, g_class_len, name] = machine.sysargs<Node_Create_Shortlist, gaddr_t, unsigned, std::string_view>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(150'000);
+	emu.penalize_syscall(ECALL_NODE_CREATE);
 	Node *node = nullptr;
 
 	switch (type) {
@@ -772,8 +1147,7 @@ APICALL(api_node_create) {
 			node = Object::cast_to<Node>(obj);
 			// If it's not a Node, just return the Object.
 			if (node == nullptr) {
-				emu.add_scoped_object(obj);
-				machine.set_result(uint64_t(uintptr_t(obj)));
+				machine.set_result(emu.add_scoped_object(obj));
 				return;
 			}
 			// It's a Node, so continue to set the name.
@@ -812,15 +1186,13 @@ APICALL(api_node_create) {
 	if (!name.empty()) {
 		node->set_name(String::utf8(name.begin(), name.size()));
 	}
-	emu.add_scoped_object(node);
-	machine.set_result(uint64_t(uintptr_t(node)));
+	machine.set_result(emu.add_scoped_object(node));
 }
 
 APICALL(api_node) {
 	auto [op, addr, gvar] = machine.sysargs<int, uint64_t, gaddr_t>();
-	machine.penalize(250'000); // Costly Node operations.
-
 	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_NODE);
 	// Get the Node object by its address.
 	godot::Node *node = get_node_from_address(emu, addr);
 
@@ -831,7 +1203,10 @@ APICALL(api_node) {
 		} break;
 		case Node_Op::SET_NAME: {
 			GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 1);
-			node->set_name(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node, "set_name", var->toVariant(emu));
+			else
+				node->set_name(var->toVariant(emu));
 		} break;
 		case Node_Op::GET_PATH: {
 			GuestVariant *var = machine.memory.memarray<GuestVariant>(gvar, 1);
@@ -853,12 +1228,14 @@ APICALL(api_node) {
 				throw std::runtime_error("Cannot queue free the sandbox");
 			}
 			//emu.rem_scoped_object(node);
-			node->queue_free();
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node, "queue_free");
+			else
+				node->queue_free();
 			break;
 		case Node_Op::DUPLICATE: {
 			auto *var = machine.memory.memarray<GuestVariant>(gvar, 1);
 			auto *new_node = node->duplicate();
-			emu.add_scoped_object(new_node);
 			var->set(emu, new_node, true); // Implicit trust, as we are returning our own object.
 		} break;
 		case Node_Op::GET_CHILD_COUNT: {
@@ -871,15 +1248,16 @@ APICALL(api_node) {
 			if (child_node == nullptr) {
 				var[0].set(emu, Variant());
 			} else {
-				emu.add_scoped_object(child_node);
-				var[0].set(emu, int64_t(uintptr_t(child_node)));
+				var[0].set(emu, int64_t(emu.add_scoped_object(child_node)));
 			}
 		} break;
 		case Node_Op::ADD_CHILD_DEFERRED:
 		case Node_Op::ADD_CHILD: {
 			GuestVariant *child = machine.memory.memarray<GuestVariant>(gvar, 1);
 			godot::Node *child_node = get_node_from_address(emu, child->v.i);
-			if (Node_Op(op) == Node_Op::ADD_CHILD_DEFERRED)
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node, "add_child", child_node);
+			else if (Node_Op(op) == Node_Op::ADD_CHILD_DEFERRED)
 				node->call_deferred("add_child", child_node);
 			else
 				node->add_child(child_node);
@@ -888,7 +1266,9 @@ APICALL(api_node) {
 		case Node_Op::ADD_SIBLING: {
 			GuestVariant *sibling = machine.memory.memarray<GuestVariant>(gvar, 1);
 			godot::Node *sibling_node = get_node_from_address(emu, sibling->v.i);
-			if (Node_Op(op) == Node_Op::ADD_SIBLING_DEFERRED)
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node, "add_sibling", sibling_node);
+			else if (Node_Op(op) == Node_Op::ADD_SIBLING_DEFERRED)
 				node->call_deferred("add_sibling", sibling_node);
 			else
 				node->add_sibling(sibling_node);
@@ -897,13 +1277,18 @@ APICALL(api_node) {
 			GuestVariant *vars = machine.memory.memarray<GuestVariant>(gvar, 2);
 			godot::Node *child_node = get_node_from_address(emu, vars[0].v.i);
 			// TODO: Check if the child is actually a child of the node? Verify index?
-			node->move_child(child_node, vars[1].v.i);
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node, "move_child", child_node, vars[1].v.i);
+			else
+				node->move_child(child_node, vars[1].v.i);
 		} break;
 		case Node_Op::REMOVE_CHILD_DEFERRED:
 		case Node_Op::REMOVE_CHILD: {
 			GuestVariant *child = machine.memory.memarray<GuestVariant>(gvar, 1);
 			godot::Node *child_node = get_node_from_address(emu, child->v.i);
-			if (Node_Op(op) == Node_Op::REMOVE_CHILD_DEFERRED)
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node, "remove_child", child_node);
+			else if (Node_Op(op) == Node_Op::REMOVE_CHILD_DEFERRED)
 				node->call_deferred("remove_child", child_node);
 			else
 				node->remove_child(child_node);
@@ -919,8 +1304,7 @@ APICALL(api_node) {
 			for (int i = 0; i < children.size(); i++) {
 				godot::Node *child = godot::Object::cast_to<godot::Node>(children[i]);
 				if (child) {
-					emu.add_scoped_object(child);
-					cptr[i] = uint64_t(uintptr_t(child));
+					cptr[i] = emu.add_scoped_object(child);
 				} else {
 					cptr[i] = 0;
 				}
@@ -935,9 +1319,8 @@ APICALL(api_node) {
 APICALL(api_node2d) {
 	// Node2D operation, Node2D address, and the variant to get/set the value.
 	auto [op, addr, gvar] = machine.sysargs<int, uint64_t, gaddr_t>();
-	machine.penalize(100'000); // Costly Node2D operations.
-
 	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_NODE2D);
 	// Get the Node2D object by its address.
 	godot::Node *node = get_node_from_address(emu, addr);
 
@@ -955,25 +1338,37 @@ APICALL(api_node2d) {
 			var->set(emu, node2d->get_position());
 			break;
 		case Node2D_Op::SET_POSITION:
-			node2d->set_deferred("position", var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node2d, "set_position", var->toVariant(emu));
+			else
+				node2d->set_deferred("position", var->toVariant(emu));
 			break;
 		case Node2D_Op::GET_ROTATION:
 			var->set(emu, node2d->get_rotation());
 			break;
 		case Node2D_Op::SET_ROTATION:
-			node2d->set_rotation(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node2d, "set_rotation", var->toVariant(emu));
+			else
+				node2d->set_rotation(var->toVariant(emu));
 			break;
 		case Node2D_Op::GET_SCALE:
 			var->set(emu, node2d->get_scale());
 			break;
 		case Node2D_Op::SET_SCALE:
-			node2d->set_scale(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node2d, "set_scale", var->toVariant(emu));
+			else
+				node2d->set_scale(var->toVariant(emu));
 			break;
 		case Node2D_Op::GET_SKEW:
 			var->set(emu, node2d->get_skew());
 			break;
 		case Node2D_Op::SET_SKEW:
-			node2d->set_skew(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node2d, "set_skew", var->toVariant(emu));
+			else
+				node2d->set_skew(var->toVariant(emu));
 			break;
 		default:
 			ERR_PRINT("Invalid Node2D operation");
@@ -984,9 +1379,8 @@ APICALL(api_node2d) {
 APICALL(api_node3d) {
 	// Node3D operation, Node3D address, and the variant to get/set the value.
 	auto [op, addr, gvar] = machine.sysargs<int, uint64_t, gaddr_t>();
-	machine.penalize(100'000); // Costly Node3D operations.
-
 	Sandbox &emu = riscv::emu(machine);
+	emu.penalize_syscall(ECALL_NODE3D);
 	// Get the Node3D object by its address
 	godot::Node *node = get_node_from_address(emu, addr);
 
@@ -1004,19 +1398,28 @@ APICALL(api_node3d) {
 			var->set(emu, node3d->get_position());
 			break;
 		case Node3D_Op::SET_POSITION:
-			node3d->set_position(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node3d, "set_position", var->toVariant(emu));
+			else
+				node3d->set_position(var->toVariant(emu));
 			break;
 		case Node3D_Op::GET_ROTATION:
 			var->set(emu, node3d->get_rotation());
 			break;
 		case Node3D_Op::SET_ROTATION:
-			node3d->set_rotation(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node3d, "set_rotation", var->toVariant(emu));
+			else
+				node3d->set_rotation(var->toVariant(emu));
 			break;
 		case Node3D_Op::GET_SCALE:
 			var->set(emu, node3d->get_scale());
 			break;
 		case Node3D_Op::SET_SCALE:
-			node3d->set_scale(var->toVariant(emu));
+			if (emu.is_in_parallel_call()) [[unlikely]]
+				defer_command(emu, node3d, "set_scale", var->toVariant(emu));
+			else
+				node3d->set_scale(var->toVariant(emu));
 			break;
 		default:
 			ERR_PRINT("Invalid Node3D operation");
@@ -1119,6 +1522,34 @@ APICALL(api_array_ops) {
 			}
 			break;
 		}
+		case Array_Op::FETCH_RANGE: {
+			// A strided range of Variants, from idx, which ends early at the end of the array
+			const uint64_t count = machine.sysarg<uint64_t>(4);
+			const uint64_t stride = machine.sysarg<uint64_t>(5);
+			if (idx < 0) {
+				throw std::runtime_error("Array range offset is negative");
+			}
+			const uint64_t elements = range_elements(array.size(), idx, count, stride);
+			auto *vec = machine.memory.memarray<GuestStdVector>(vaddr, 1);
+			auto [sptr, saddr] = vec->alloc<GuestVariant>(machine, elements);
+			for (uint64_t i = 0; i < elements; i++) {
+				sptr[i].create(emu, array[idx + i * stride].duplicate(false));
+			}
+			break;
+		}
+		case Array_Op::STORE_RANGE: {
+			// Overwrite the elements from idx with an array of Variants
+			const uint64_t count = machine.sysarg<uint64_t>(4);
+			if (idx < 0 || idx > array.size() || count > uint64_t(array.size() - idx)) {
+				ERR_PRINT("Array range is out of bounds");
+				throw std::runtime_error("Array range is out of bounds");
+			}
+			const GuestVariant *values = machine.memory.memarray<GuestVariant>(vaddr, count);
+			for (uint64_t i = 0; i < count; i++) {
+				array[idx + i] = values[i].toVariant(emu);
+			}
+			break;
+		}
 		default:
 			ERR_PRINT("Invalid Array operation");
 			throw std::runtime_error("Invalid Array operation");
@@ -1226,7 +1657,7 @@ APICALL(api_dict_ops) {
 APICALL(api_string_create) {
 	auto [strview] = machine.sysargs<std::string_view>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(10'000);
+	emu.penalize_syscall(ECALL_STRING_CREATE);
 
 	String str = String::utf8(strview.data(), strview.size());
 	const unsigned idx = emu.create_scoped_variant(Variant(std::move(str)));
@@ -1321,14 +1752,18 @@ APICALL(api_string_append) {
 APICALL(api_timer_periodic) {
 	auto [interval, oneshot, callback, capture, vret] = machine.sysargs<double, bool, gaddr_t, std::array<uint8_t, 32> *, GuestVariant *>();
 	Sandbox &emu = riscv::emu(machine);
-	machine.penalize(100'000); // Costly Timer node creation.
+	emu.penalize_syscall(ECALL_TIMER_PERIODIC);
 
 	Timer *timer = memnew(Timer);
 	timer->set_wait_time(interval);
 	timer->set_one_shot(oneshot);
 	Node *topnode = emu.get_tree_base();
 	// Add the timer to the top node, as long as the Sandbox is in a tree.
-	if (topnode != nullptr) {
+	if (topnode != nullptr && emu.is_in_parallel_call()) {
+		timer->set_autostart(true);
+		defer_command(emu, topnode, "add_child", timer);
+		defer_command(emu, timer, "set_owner", topnode);
+	} else if (topnode != nullptr) {
 		topnode->add_child(timer);
 		timer->set_owner(topnode);
 		timer->start();
@@ -1573,5 +2008,19 @@ void Sandbox::initialize_syscalls() {
 			{ ECALL_LERP_OP64, api_lerp_op<double> },
 
 			{ ECALL_VEC3_OPS, api_vec3_ops },
+
+			{ ECALL_VSTORE_RANGE, api_vstore_range },
+			{ ECALL_VBYTES, api_vbytes },
+
+			{ ECALL_METHOD_HANDLE, api_method_handle },
+			{ ECALL_VMETHOD_CALL, api_vmethod_call },
+			{ ECALL_OBJ_METHOD_CALL, api_obj_method_call },
+			{ ECALL_INTERN_NAME, api_intern_name },
 	});
+	// Worker forks may only make some of the system calls
+	install_syscall_allowlist();
+	// Sandboxes may have enabled tracing before the first program was loaded
+	if (m_syscall_tracing_instances > 0) {
+		install_syscall_tracing(true);
+	}
 }
@@ -0,0 +1,198 @@
+#include "sandbox.h"
+
+#include "sandbox_project_settings.h"
+#include "syscalls.h"
+#include <godot_cpp/classes/time.hpp>
+#include <utility>
+
+// Copy the permanent (initial) state of a template into a fork. Scoped variants that
+// point into the template's own variant storage are re-pointed at the fork's copies.
+static void copy_initial_state(Sandbox::CurrentState &dst, const Sandbox::CurrentState &src) {
+	dst.variants.clear();
+	dst.scoped_variants.clear();
+	dst.scoped_objects = src.scoped_objects;
+	dst.host_objects = src.host_objects;
+	// The capacity is the limit on scoped variants, so it must not shrink
+	dst.variants.reserve(src.variants.capacity());
+	for (const Variant &var : src.variants) {
+		dst.variants.push_back(var);
+	}
+	const Variant *src_begin = src.variants.data();
+	const Variant *src_end = src_begin + src.variants.size();
+	for (const Variant *var : src.scoped_variants) {
+		if (var >= src_begin && var < src_end) {
+			dst.scoped_variants.push_back(&dst.variants[var - src_begin]);
+		} else {
+			dst.scoped_variants.push_back(var);
+		}
+	}
+}
+
+std::shared_ptr<Sandbox> Sandbox::create_program_template(const PackedByteArray &binary, const String &snapshot_path) {
+	Sandbox *sandbox = memnew(Sandbox);
+	sandbox->set_use_program_template(false);
+	// Templates are never called, so they don't take a share of the frame budget
+	sandbox->set_frame_budget_weight(0.0);
+	sandbox->set_use_binary_translation(SandboxProjectSettings::use_binary_translation());
+	sandbox->set_use_jit_compilation(SandboxProjectSettings::use_jit_compilation());
+	// Keep a reference to the program, as the machine refers directly into it
+	sandbox->m_template_binary = binary;
+	if (snapshot_path.is_empty() || !sandbox->load_snapshot_internal(&sandbox->m_template_binary, snapshot_path)) {
+		sandbox->load(&sandbox->m_template_binary);
+		if (!snapshot_path.is_empty() && sandbox->get_exceptions() == 0) {
+			sandbox->save_snapshot(snapshot_path);
+		}
+	}
+
+	// A program that failed to initialize is not forked, so that each
+	// new instance reports the failure the same way a cold load would.
+	if (!sandbox->has_program_loaded() || sandbox->get_exceptions() > 0) {
+		memdelete(sandbox);
+		return nullptr;
+	}
+	return std::shared_ptr<Sandbox>(sandbox, [](Sandbox *sandbox) {
+		memdelete(sandbox);
+	});
+}
+
+bool Sandbox::load_from_template(const std::shared_ptr<Sandbox> &program_template) {
+	if (program_template == nullptr) {
+		return false;
+	}
+	if (program_template == this->m_program_template) {
+		// Already forked from this template, no need to reload
+		return true;
+	}
+	const Sandbox &tpl = *program_template;
+	// The arena and execute segments are inherited from the template, so the settings must match
+	if (tpl.get_memory_max() != this->get_memory_max() || tpl.get_use_binary_translation() != this->get_use_binary_translation() || tpl.get_use_jit_compilation() != this->get_use_jit_compilation()) {
+		return false;
+	}
+
+	// Get t0 for the startup time
+	const uint64_t startup_t0 = Time::get_singleton()->get_ticks_usec();
+
+	machine_t *fork = nullptr;
+	try {
+		// Fork the template copy-on-write, sharing its read-only pages and execute segments
+		fork = new machine_t{ tpl.machine(), this->machine_options() };
+	} catch (const std::exception &e) {
+		ERR_PRINT(("Sandbox fork exception: " + std::string(e.what())).c_str());
+		return false;
+	}
+
+	// The old machine may itself be a fork, so delete it before releasing its template
+	this->cancel_sliced_call();
+	this->finish_jit_compilation();
+	delete this->m_machine;
+	this->m_machine = fork;
+	this->m_program_template = program_template;
+	this->m_binary = tpl.m_binary;
+	this->m_machine->set_userdata(this);
+
+	// System calls are installed once for all machines, so only the permanent
+	// state, object handles, properties and function lookups remain to be copied.
+	this->clear_scoped_objects();
+	this->clear_profile();
+	copy_initial_state(this->m_states[0], tpl.m_states[0]);
+	this->m_scoped_objects = tpl.m_scoped_objects;
+	this->m_free_scoped_objects = tpl.m_free_scoped_objects;
+	this->m_scoped_object_ids = tpl.m_scoped_object_ids;
+	this->m_pinned_objects = tpl.m_pinned_objects;
+	this->m_current_state = &this->m_states[0];
+	this->m_properties = tpl.m_properties;
+	// Method handles and guest names are shared with the template until the fork adds to them
+	this->m_method_handles = tpl.m_method_handles;
+	this->m_guest_names = tpl.m_guest_names;
+	this->m_rodata_begin = tpl.m_rodata_begin;
+	this->m_rodata_end = tpl.m_rodata_end;
+	// Public functions are looked up in the table shared with the template
+	this->m_lookup.clear();
+	this->m_functions = tpl.m_functions;
+	// Forks share the execute segment of the template, so when the template
+	// is JIT-compiled, the compiled code becomes live in every fork at once.
+	this->m_jit_armed = tpl.m_jit_armed;
+
+	// Accumulate startup time
+	const uint64_t startup_t1 = Time::get_singleton()->get_ticks_usec();
+	m_accumulated_startup_time += (startup_t1 - startup_t0) / 1e6;
+	return true;
+}
+
+static constexpr uint64_t syscall_bit(int ecall) {
+	return uint64_t(1) << (ecall - GAME_API_BASE);
+}
+// Worker forks run on other threads than the main thread, so they may only make the system calls
+// that work on Variants and math. Any other system call, including those added later, is denied.
+static constexpr uint64_t WORKER_ALLOWED_SYSCALLS =
+		syscall_bit(ECALL_PRINT) | syscall_bit(ECALL_VCALL) | syscall_bit(ECALL_VEVAL) | syscall_bit(ECALL_VFREE) |
+		syscall_bit(ECALL_THROW) | syscall_bit(ECALL_IS_EDITOR) |
+		syscall_bit(ECALL_SINCOS) | syscall_bit(ECALL_VEC2_LENGTH) | syscall_bit(ECALL_VEC2_NORMALIZED) | syscall_bit(ECALL_VEC2_ROTATED) |
+		syscall_bit(ECALL_VCREATE) | syscall_bit(ECALL_VCLONE) | syscall_bit(ECALL_VFETCH) | syscall_bit(ECALL_VSTORE) |
+		syscall_bit(ECALL_ARRAY_OPS) | syscall_bit(ECALL_ARRAY_AT) | syscall_bit(ECALL_ARRAY_SIZE) | syscall_bit(ECALL_DICTIONARY_OPS) |
+		syscall_bit(ECALL_STRING_CREATE) | syscall_bit(ECALL_STRING_OPS) | syscall_bit(ECALL_STRING_AT) |
+		syscall_bit(ECALL_STRING_SIZE) | syscall_bit(ECALL_STRING_APPEND) |
+		syscall_bit(ECALL_MATH_OP32) | syscall_bit(ECALL_MATH_OP64) | syscall_bit(ECALL_LERP_OP32) | syscall_bit(ECALL_LERP_OP64) |
+		syscall_bit(ECALL_VEC3_OPS) | syscall_bit(ECALL_VSTORE_RANGE) | syscall_bit(ECALL_VBYTES) |
+		syscall_bit(ECALL_METHOD_HANDLE) | syscall_bit(ECALL_VMETHOD_CALL) | syscall_bit(ECALL_INTERN_NAME);
+
+// The system call handlers are shared by all machines, so each Godot API handler is wrapped
+// once by a check of the allowed system calls of the calling sandbox, which takes a single
+// branch in sandboxes that may make every system call.
+using syscall_fn = void (*)(machine_t &);
+static syscall_fn unchecked_syscall_handlers[Sandbox::TRACED_SYSCALLS];
+
+template <size_t N>
+void Sandbox::checked_syscall(machine_t &machine) {
+	Sandbox &emu = *machine.get_userdata<Sandbox>();
+	if (!(emu.m_allowed_syscalls & (uint64_t(1) << N))) [[unlikely]] {
+		throw std::runtime_error("System call denied: " + std::string(syscall_name(N).utf8().get_data()));
+	}
+	unchecked_syscall_handlers[N](machine);
+}
+
+void Sandbox::install_syscall_allowlist() {
+	static const auto checked_handlers = []<size_t... N>(std::index_sequence<N...>) {
+		return std::array<syscall_fn, sizeof...(N)>{ &Sandbox::checked_syscall<N>... };
+	}(std::make_index_sequence<TRACED_SYSCALLS>{});
+
+	for (unsigned i = 0; i < TRACED_SYSCALLS; i++) {
+		const size_t number = GAME_API_BASE + i;
+		const syscall_fn current = machine_t::syscall_handlers[number];
+		if (current == nullptr || current == checked_handlers[i]) {
+			continue;
+		}
+		unchecked_syscall_handlers[i] = current;
+		machine_t::install_syscall_handler(number, checked_handlers[i]);
+	}
+}
+
+std::shared_ptr<Sandbox> Sandbox::worker_fork_template() const {
+	if (this->m_program_template == nullptr && m_program_data.is_valid()) {
+		return m_program_data->get_program_template();
+	}
+	return this->m_program_template;
+}
+
+Sandbox *Sandbox::create_worker_fork() const {
+	const std::shared_ptr<Sandbox> program_template = this->worker_fork_template();
+	if (program_template == nullptr) {
+		return nullptr;
+	}
+	Sandbox *worker = memnew(Sandbox);
+	worker->set_name(String(get_name()) + " (worker)");
+	worker->set_frame_budget_weight(0.0);
+	worker->set_instructions_max(get_instructions_max());
+	// The fork inherits the arena and execute segments of the template
+	worker->set_memory_max(program_template->get_memory_max());
+	worker->set_use_binary_translation(program_template->get_use_binary_translation());
+	worker->set_use_jit_compilation(program_template->get_use_jit_compilation());
+	if (!worker->load_from_template(program_template)) {
+		memdelete(worker);
+		return nullptr;
+	}
+	worker->enable_restrictions();
+	worker->m_allowed_syscalls = WORKER_ALLOWED_SYSCALLS;
+	worker->m_worker_fork = true;
+	return worker;
+}
@@ -0,0 +1,107 @@
+#include "sandbox.h"
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <libriscv/util/crc32.hpp>
+#include <mutex>
+
+#ifdef RISCV_BINARY_TRANSLATION
+// Translated programs are cached next to the .import metadata of the project.
+// The file name is keyed by the CRC32-C of the ELF, and libriscv appends its own
+// checksum of the execute segment and translation options, so that a rebuilt
+// program or a different libriscv build never picks up a stale translation.
+static constexpr char TRANSLATION_CACHE_DIR[] = "res://.godot/imported/";
+static constexpr char TRANSLATION_SUFFIX[] = ".so";
+
+static String translation_file_prefix(const PackedByteArray &binary) {
+	const uint32_t hash = riscv::crc32c(binary.ptr(), binary.size());
+	return "sandbox-" + String::num_uint64(hash, 16) + "-";
+}
+
+// Programs are loaded and forked often, so the cache directory is only listed
+// once per program. generate_binary_translation_for() updates the entry.
+static std::mutex translation_lookup_mutex;
+static HashMap<String, bool> translation_lookup;
+
+static bool has_translation_in_cache(const String &file_prefix, bool refresh = false) {
+	std::lock_guard<std::mutex> lock(translation_lookup_mutex);
+	if (!refresh) {
+		const bool *found = translation_lookup.getptr(file_prefix);
+		if (found != nullptr) {
+			return *found;
+		}
+	}
+	bool found = false;
+	const PackedStringArray files = DirAccess::get_files_at(TRANSLATION_CACHE_DIR);
+	for (const String &file : files) {
+		if (file.begins_with(file_prefix) && file.ends_with(TRANSLATION_SUFFIX)) {
+			found = true;
+			break;
+		}
+	}
+	translation_lookup.insert(file_prefix, found);
+	return found;
+}
+
+bool Sandbox::apply_translation_options(const PackedByteArray &binary, riscv::MachineOptions<RISCV_ARCH> &options, bool generate) {
+	const String file_prefix = translation_file_prefix(binary);
+	if (!generate && !has_translation_in_cache(file_prefix)) {
+		return false;
+	}
+	const String prefix = ProjectSettings::get_singleton()->globalize_path(TRANSLATION_CACHE_DIR + file_prefix);
+	options.translate_enabled = true;
+	options.translate_invoke_compiler = generate;
+	options.translation_cache = true;
+	options.translation_prefix = prefix.utf8().get_data();
+	options.translation_suffix = TRANSLATION_SUFFIX;
+	// Translated code does not count instructions, which is only
+	// safe to ignore now that we know the translation is available.
+	options.translate_ignore_instruction_limit = true;
+	return true;
+}
+#endif
+
+bool Sandbox::generate_binary_translation_for(const PackedByteArray &binary) {
+#ifdef RISCV_BINARY_TRANSLATION
+	if (binary.is_empty()) {
+		return false;
+	}
+	const String file_prefix = translation_file_prefix(binary);
+	if (has_translation_in_cache(file_prefix)) {
+		return true;
+	}
+	DirAccess::make_dir_recursive_absolute(TRANSLATION_CACHE_DIR);
+	try {
+		riscv::MachineOptions<RISCV_ARCH> options{
+			.memory_max = uint64_t(MAX_VMEM) << 20, // in MiB
+		};
+		apply_translation_options(binary, options, true);
+		// The program is translated and compiled while its execute segment is being loaded
+		const std::string_view binary_view = std::string_view{ (const char *)binary.ptr(), static_cast<size_t>(binary.size()) };
+		machine_t machine{ binary_view, options };
+	} catch (const std::exception &e) {
+		ERR_PRINT(("Sandbox: Binary translation failed: " + std::string(e.what())).c_str());
+		return false;
+	}
+	return has_translation_in_cache(file_prefix, true);
+#else
+	ERR_PRINT("Sandbox: Binary translation is not enabled in this build.");
+	return false;
+#endif
+}
+
+bool Sandbox::generate_binary_translation() const {
+	if (!this->has_program_loaded()) {
+		ERR_PRINT("Sandbox: No program loaded, cannot translate it.");
+		return false;
+	}
+	return generate_binary_translation_for(*this->m_binary);
+}
+
+bool Sandbox::is_binary_translated() const {
+#ifdef RISCV_BINARY_TRANSLATION
+	return machine().cpu.current_execute_segment().is_binary_translated();
+#else
+	return false;
+#endif
+}
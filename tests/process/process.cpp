@@ -0,0 +1,32 @@
+#include "api.hpp"
+
+// A program with process callbacks, kept apart from the other tests,
+// so that nodes using their programs are not processed every frame.
+
+static int64_t process_calls = 0;
+
+extern "C" Variant _process(double delta) {
+	process_calls++;
+	return Nil;
+}
+
+extern "C" Variant get_process_calls() {
+	return process_calls;
+}
+
+static int64_t process_group_calls = 0;
+
+extern "C" Variant _process_group(PackedArray<int64_t> nodes, double delta) {
+	process_group_calls++;
+	// Count the calls of every node in its metadata
+	for (int64_t address : nodes.fetch()) {
+		Node node(address);
+		const int64_t calls = node.call("get_meta", "process_group_calls", 0);
+		node.voidcall("set_meta", "process_group_calls", calls + 1);
+	}
+	return Nil;
+}
+
+extern "C" Variant get_process_group_calls() {
+	return process_group_calls;
+}
@@ -79,6 +79,40 @@ extern "C" Variant test_object(Object arg) {
 	return arg;
 }
 
+extern "C" Variant test_method_handles(Node2D node) {
+	static MethodHandle set_position("Node2D", "set_position");
+	static MethodHandle get_position("Node2D", "get_position");
+	static MethodHandle get_child_count("Node", "get_child_count");
+	static MethodHandle dot(Variant::VECTOR2, "dot");
+	set_position.voidcall(node, Vector2(1, 2));
+	const double children = get_child_count(node);
+	return dot(get_position(node), Vector2(3, 4)).operator double() + children;
+}
+
+extern "C" Variant test_interned_names(Node2D node) {
+	static const InternedName position("position");
+	static const InternedName get_position("get_position");
+	node.set(position, Vector2(5, 6));
+	node.set("rotation", 0.5);
+	if (node.get(position) != node.get("position"))
+		return Nil;
+	return node.call(get_position);
+}
+
+static Object cached_object{ 0 };
+extern "C" Variant test_cache_object(Object arg, bool pin) {
+	cached_object = arg;
+	if (pin)
+		return cached_object.pin();
+	return Nil;
+}
+extern "C" Variant test_cached_object_name() {
+	return cached_object.get("name");
+}
+extern "C" Variant test_unpin_cached_object() {
+	return cached_object.unpin();
+}
+
 extern "C" Variant test_callable(Variant callable) {
 	return callable.call(1, 2, "3");
 }
@@ -141,6 +175,76 @@ extern "C" Variant test_create_pa_color() {
 	return arr;
 }
 
+extern "C" Variant test_pa_view_sum(PackedArray<float> arr) {
+	float sum = 0.0f;
+	for (float value : arr.view()) {
+		sum += value;
+	}
+	return sum;
+}
+extern "C" Variant test_pa_view_scale(PackedArray<float> arr) {
+	for (float &value : arr.view_mut()) {
+		value *= 2.0f;
+	}
+	return arr;
+}
+
+extern "C" Variant test_pa_fetch_range(PackedArray<float> arr, long offset, long count, long stride) {
+	return PackedArray<float>(arr.fetch(offset, count, stride));
+}
+extern "C" Variant test_pa_store_range(PackedArray<float> arr, long offset) {
+	const std::vector<float> values { -1.0f, -2.0f };
+	arr.store(offset, values);
+	return arr;
+}
+extern "C" Variant test_pa_chunks_sum(PackedArray<float> arr, long chunk_size) {
+	float sum = 0.0f;
+	for (const auto &chunk : arr.chunks(chunk_size)) {
+		for (float value : chunk.data) {
+			sum += value;
+		}
+	}
+	return sum;
+}
+extern "C" Variant test_array_range(Array arr) {
+	const std::vector<Variant> values = arr.fetch(1, 2);
+	arr.store(0, values);
+	return arr;
+}
+
+// Sum the numbers in a Dictionary of Arrays, read in place from its encoding
+extern "C" Variant test_bytes_sum(Variant dict) {
+	const std::vector<uint8_t> bytes = dict.to_bytes();
+	VariantReader reader(bytes);
+	double sum = 0.0;
+	const uint32_t pairs = reader.read_dictionary();
+	for (uint32_t i = 0; i < pairs && reader.ok(); i++) {
+		reader.skip(); // Key
+		const uint32_t count = reader.read_array();
+		for (uint32_t j = 0; j < count && reader.ok(); j++) {
+			if (reader.type() == Variant::INT)
+				sum += reader.read_int();
+			else if (reader.type() == Variant::FLOAT)
+				sum += reader.read_float();
+			else
+				reader.skip();
+		}
+	}
+	return reader.ok() ? Variant(sum) : Nil;
+}
+extern "C" Variant test_bytes_build() {
+	VariantWriter writer;
+	writer.write_dictionary(2);
+	writer.write_string("name");
+	writer.write_string("Sandbox");
+	writer.write_string("values");
+	writer.write_array(3);
+	writer.write_int(1);
+	writer.write_float(2.5);
+	writer.write_bool(true);
+	return writer.to_variant();
+}
+
 extern "C" Variant test_exception() {
 	asm("unimp");
 	__builtin_unreachable();
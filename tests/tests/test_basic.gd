@@ -120,6 +120,27 @@ func test_types():
 	assert_eq(s.vmcall("test_create_pa_vec2"), PackedVector2Array([Vector2(1, 1), Vector2(2, 2), Vector2(3, 3)]))
 	assert_eq(s.vmcall("test_create_pa_vec3"), PackedVector3Array([Vector3(1, 1, 1), Vector3(2, 2, 2), Vector3(3, 3, 3)]))
 	assert_eq(s.vmcall("test_create_pa_color"), PackedColorArray([Color(0, 0, 0, 0), Color(1, 1, 1, 1)]))
+	# Packed arrays mapped into the guest, spanning whole pages and a partial page
+	var mapped := PackedFloat32Array()
+	for i in 3000:
+		mapped.push_back(i % 4)
+	assert_eq(s.vmcall("test_pa_view_sum", mapped), 4500.0)
+	var scaled = s.vmcall("test_pa_view_scale", mapped)
+	assert_eq(scaled.size(), 3000)
+	assert_eq(scaled[2999], 6.0)
+	assert_eq(mapped[2999], 3.0, "Writable mappings are private copies")
+	assert_eq(s.vmcall("test_pa_view_sum", PackedFloat32Array()), 0.0)
+	# Ranged and strided access to packed arrays and arrays
+	var ranged := PackedFloat32Array([0, 1, 2, 3, 4, 5, 6, 7, 8, 9])
+	assert_eq(s.vmcall("test_pa_fetch_range", ranged, 2, 3, 1), PackedFloat32Array([2, 3, 4]))
+	assert_eq(s.vmcall("test_pa_fetch_range", ranged, 1, 100, 3), PackedFloat32Array([1, 4, 7]))
+	assert_eq(s.vmcall("test_pa_fetch_range", ranged, 20, 5, 1), PackedFloat32Array())
+	assert_eq(s.vmcall("test_pa_store_range", ranged, 8), PackedFloat32Array([0, 1, 2, 3, 4, 5, 6, 7, -1, -2]))
+	assert_eq(ranged[9], 9.0, "Stores into an argument go to a copy")
+	assert_eq(s.vmcall("test_pa_chunks_sum", ranged, 3), 45.0)
+	assert_eq(s.vmcall("test_array_range", [1, "two", 3.0]), ["two", 3.0, 3.0])
+	assert_eq(s.vmcall("test_bytes_sum", {"a": [1, 2.5, "skip", [4]], "b": [10, Vector3(1, 2, 3)]}), 13.5)
+	assert_eq(s.vmcall("test_bytes_build"), {"name": "Sandbox", "values": [1, 2.5, true]})
 
 	# Callables
 	var cb : Callable = Callable(callable_function)
@@ -207,6 +228,49 @@ func test_objects():
 	var n3d = Node3D.new()
 	n3d.name = "Node3D"
 	assert_same(s.vmcall("test_object", n3d), n3d)
+
+	# Methods called by handle
+	assert_eq(s.vmcall("test_method_handles", n2d), 11.0)
+	assert_eq(n2d.position, Vector2(1, 2))
+
+	# Names passed by handle, and string literals cached by address
+	assert_eq(s.vmcall("test_interned_names", n2d), Vector2(5, 6))
+	assert_eq(n2d.rotation, 0.5)
+	s.queue_free()
+
+
+func test_pinned_objects():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	var n = Node.new()
+	n.name = "Pinned"
+
+	# Objects are released when the call that acquired them ends
+	s.vmcall("test_cache_object", n, false)
+	var exceptions = s.get_exceptions()
+	assert_eq(s.vmcall("test_cached_object_name"), null)
+	assert_eq(s.get_exceptions(), exceptions + 1)
+
+	# Pinned objects can be used across calls
+	assert_true(s.vmcall("test_cache_object", n, true))
+	assert_eq(s.vmcall("test_cached_object_name"), "Pinned")
+	assert_eq(s.vmcall("test_cached_object_name"), "Pinned")
+
+	# Unpinned objects are released again when the call ends
+	assert_true(s.vmcall("test_unpin_cached_object"))
+	exceptions = s.get_exceptions()
+	assert_eq(s.vmcall("test_cached_object_name"), null)
+	assert_eq(s.get_exceptions(), exceptions + 1)
+
+	# A pinned object that has been freed is never accessed
+	var n2 = Node.new()
+	assert_true(s.vmcall("test_cache_object", n2, true))
+	n2.free()
+	exceptions = s.get_exceptions()
+	assert_eq(s.vmcall("test_cached_object_name"), null)
+	assert_eq(s.get_exceptions(), exceptions + 1)
+
+	n.free()
 	s.queue_free()
 
 
@@ -246,6 +310,16 @@ func test_exceptions():
 	assert_eq(s.get_global_exceptions(), current_exceptions + 1)
 	s.queue_free()
 
+func test_source_location():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	# Functions are found in the line table of the program
+	var location = s.get_source_location("test_ping_pong")
+	assert_true(location["file"].ends_with("test_basic.cpp"))
+	assert_eq(location["line"], 17)
+	assert_eq(s.get_source_location("no_such_function"), {})
+	s.queue_free()
+
 func test_math():
 	# Create a new sandbox
 	var s = Sandbox.new()
@@ -354,6 +428,69 @@ func test_restrictions():
 
 	s.queue_free()
 
+
+func test_snapshots():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	assert_true(s.save_snapshot("user://tests.snapshot"), "Snapshot was not saved")
+
+	# Warm-start a new sandbox from the snapshot
+	var s2 = Sandbox.new()
+	s2.use_program_template = false
+	s2.set_program(Sandbox_TestsTests)
+	assert_true(s2.load_snapshot("user://tests.snapshot"), "Snapshot was not loaded")
+	assert_eq(s2.get_functions(), s.get_functions())
+	assert_eq(s2.vmcall("test_ping_pong", 1234), 1234)
+	assert_eq(s2.get_exceptions(), 0)
+
+	# Missing snapshots are rejected
+	assert_false(s2.load_snapshot("user://missing.snapshot"))
+
+	s.queue_free()
+	s2.queue_free()
+
+func test_program_metadata():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	var functions = s.get_functions()
+	assert_true(functions.has("test_ping_pong"))
+	# System call wrappers and runtime functions are not public
+	assert_false(functions.has("sys_vcall"))
+	assert_false(functions.has("malloc"))
+
+	# A fresh load of the program agrees with the first one, whether the metadata was cached or scanned
+	var reloaded = ResourceLoader.load(Sandbox_TestsTests.resource_path, "", ResourceLoader.CACHE_MODE_IGNORE)
+	var s2 = Sandbox.new()
+	s2.set_program(reloaded)
+	assert_eq(s2.get_functions(), functions)
+	assert_eq(s2.vmcall("test_ping_pong", 5), 5)
+	s.queue_free()
+	s2.queue_free()
+
+func test_sliced_call():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	var expected = s.vmcall("benchmark_fibonacci", 25)
+
+	assert_true(s.vmcall_sliced("benchmark_fibonacci", 100000, 25))
+	assert_true(s.is_sliced_call_active(), "The call should not finish within a single slice")
+	# Other calls can be made while the sliced call is suspended
+	assert_eq(s.vmcall("test_ping_pong", 123), 123)
+	assert_false(s.vmcall_sliced("benchmark_fibonacci", 100000, 25), "Only one sliced call can run at a time")
+
+	var result = await s.sliced_call_finished
+	assert_eq(result, expected)
+	assert_false(s.is_sliced_call_active())
+	assert_eq(s.get_exceptions(), 0)
+	assert_eq(s.get_timeouts(), 0)
+
+	# A cancelled call leaves the sandbox ready for new calls
+	assert_true(s.vmcall_sliced("benchmark_fibonacci", 100000, 25))
+	s.cancel_sliced_call()
+	assert_false(s.is_sliced_call_active())
+	assert_eq(s.vmcall("test_ping_pong", 456), 456)
+	s.queue_free()
+
 func callable_function():
 	return
 
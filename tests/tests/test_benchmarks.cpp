@@ -0,0 +1,38 @@
+#include "api.hpp"
+
+static long fibonacci(long n) {
+	return (n < 2) ? n : fibonacci(n - 1) + fibonacci(n - 2);
+}
+
+extern "C" Variant benchmark_fibonacci(long n) {
+	return fibonacci(n);
+}
+
+extern "C" Variant batch_add(long a, long b) {
+	return a + b;
+}
+
+extern "C" Variant batch_scale(double x) {
+	return x * 2.0;
+}
+
+extern "C" Variant syscall_copy(PackedArray<uint8_t> arr) {
+	return PackedArray<uint8_t>(arr.fetch());
+}
+
+extern "C" Variant map_count(PackedArray<float> chunk) {
+	return int64_t(chunk.fetch().size());
+}
+
+extern "C" Variant map_double(PackedArray<float> chunk) {
+	std::vector<float> values = chunk.fetch();
+	for (float &value : values) {
+		value *= 2.0f;
+	}
+	return PackedArray<float>(values);
+}
+
+extern "C" Variant parallel_step(Node2D node, long n) {
+	node.set_position(Vector2(n, n));
+	return fibonacci(n);
+}
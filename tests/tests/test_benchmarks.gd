@@ -0,0 +1,446 @@
+extends GutTest
+
+const STARTUP_INSTANCES = 200
+const PROCESS_NODES = 1000
+
+func create_sandboxes(use_program_template: bool) -> Array:
+	var sandboxes = []
+	for i in STARTUP_INSTANCES:
+		var s = Sandbox.new()
+		s.use_program_template = use_program_template
+		s.set_program(Sandbox_TestsTests)
+		sandboxes.push_back(s)
+	return sandboxes
+
+func test_startup_benchmark():
+	# Create the program template up-front, so that it's not measured as part of the forked loads
+	var warmup = Sandbox.new()
+	warmup.set_program(Sandbox_TestsTests)
+	warmup.queue_free()
+
+	var t0 = Sandbox.get_accumulated_startup_time()
+	var cold = create_sandboxes(false)
+	var t1 = Sandbox.get_accumulated_startup_time()
+	var forked = create_sandboxes(true)
+	var t2 = Sandbox.get_accumulated_startup_time()
+
+	var cold_us = (t1 - t0) * 1e6 / STARTUP_INSTANCES
+	var forked_us = (t2 - t1) * 1e6 / STARTUP_INSTANCES
+	gut.p("Startup: cold load %.1fus, forked load %.1fus (%.1fx)" % [cold_us, forked_us, cold_us / max(forked_us, 0.001)])
+	assert_lt(forked_us, cold_us, "Forked loads should be faster than cold loads")
+
+	# Forked instances must behave exactly like cold ones
+	for i in STARTUP_INSTANCES:
+		assert_eq(forked[i].get_functions(), cold[i].get_functions())
+		assert_eq(forked[i].vmcall("test_ping_pong", i), i)
+		assert_eq(forked[i].vmcall("public_function"), "Hello from the other side")
+
+	for s in cold + forked:
+		s.queue_free()
+
+func test_shared_memory():
+	var cold = Sandbox.new()
+	cold.use_program_template = false
+	cold.set_program(Sandbox_TestsTests)
+	assert_gt(cold.get_instance_memory_usage(), 0)
+	assert_eq(cold.get_shared_memory_usage(), 0, "A sandbox that is not forked shares nothing")
+
+	# Forks share the program with their template, and only own the pages they write to
+	var forks = []
+	for i in 2:
+		var s = Sandbox.new()
+		s.use_program_template = true
+		s.set_program(Sandbox_TestsTests)
+		forks.push_back(s)
+	for s in forks:
+		assert_gt(s.get_shared_memory_usage(), 0)
+		assert_lt(s.get_instance_memory_usage(), cold.get_instance_memory_usage())
+		assert_eq(s.vmcall("test_ping_pong", 123), 123)
+	assert_eq(forks[0].get_shared_memory_usage(), forks[1].get_shared_memory_usage())
+	gut.p("Memory: cold %d bytes, forked %d bytes owned + %d bytes shared" % [cold.get_instance_memory_usage(), forks[0].get_instance_memory_usage(), forks[0].get_shared_memory_usage()])
+
+	cold.queue_free()
+	for s in forks:
+		s.queue_free()
+
+func create_benchmark_sandbox(use_binary_translation: bool) -> Sandbox:
+	var s = Sandbox.new()
+	s.use_program_template = false
+	s.use_binary_translation = use_binary_translation
+	s.set_program(Sandbox_TestsTests)
+	return s
+
+func test_binary_translation_benchmark():
+	var interpreted = create_benchmark_sandbox(false)
+	if not interpreted.generate_binary_translation():
+		interpreted.queue_free()
+		pending("Binary translation is not available in this build")
+		return
+	var translated = create_benchmark_sandbox(true)
+	assert_false(interpreted.is_binary_translated())
+	assert_true(translated.is_binary_translated(), "The translation cache was not picked up")
+
+	var t0 = Time.get_ticks_usec()
+	var interpreted_result = interpreted.vmcall("benchmark_fibonacci", 30)
+	var t1 = Time.get_ticks_usec()
+	var translated_result = translated.vmcall("benchmark_fibonacci", 30)
+	var t2 = Time.get_ticks_usec()
+
+	assert_eq(translated_result, interpreted_result)
+	assert_eq(interpreted.get_exceptions(), 0)
+	gut.p("fibonacci(30): interpreted %dus, translated %dus (%.1fx)" % [t1 - t0, t2 - t1, float(t1 - t0) / max(t2 - t1, 1)])
+
+	interpreted.queue_free()
+	translated.queue_free()
+
+func test_jit_compilation():
+	var s = Sandbox.new()
+	s.use_program_template = false
+	s.use_jit_compilation = true
+	s.set_program(Sandbox_TestsTests)
+	var expected = s.vmcall("benchmark_fibonacci", 20)
+	# Make the function hot, so that the program gets compiled in the background
+	var threshold = ProjectSettings.get_setting("editor/script/jit_call_threshold", 1000)
+	for i in threshold:
+		assert_eq(s.vmcall("benchmark_fibonacci", 20), expected)
+	var frames = 0
+	while not s.is_jit_compiled() and frames < 300:
+		await get_tree().process_frame
+		frames += 1
+	if not s.is_jit_compiled():
+		s.queue_free()
+		pending("JIT compilation is not available in this build")
+		return
+
+	assert_eq(s.vmcall("benchmark_fibonacci", 20), expected)
+	assert_gt(s.get_jit_compiled_functions(), 0)
+	assert_gt(s.get_jit_compile_time(), 0.0)
+	gut.p("JIT compiled %d functions in %.1fms" % [s.get_jit_compiled_functions(), s.get_jit_compile_time() * 1e3])
+	s.queue_free()
+
+func test_process_dispatch_benchmark():
+	# Nodes with an ELF script share one auto-created Sandbox, and every
+	# engine callback goes through ELFScriptInstance::callp
+	var nodes = []
+	for i in PROCESS_NODES:
+		var n = Node.new()
+		n.set_script(Sandbox_TestsProcessProcess)
+		nodes.push_back(n)
+	assert_true(nodes[0].has_method("_process"))
+	assert_false(nodes[0].has_method("_no_such_callback"))
+
+	var calls_before = nodes[0].call("get_process_calls")
+	var t0 = Time.get_ticks_usec()
+	for n in nodes:
+		n.call("_process", 0.016)
+	var t1 = Time.get_ticks_usec()
+	assert_eq(nodes[0].call("get_process_calls"), calls_before + PROCESS_NODES)
+	gut.p("_process on %d nodes: %dus (%.2fus per node)" % [PROCESS_NODES, t1 - t0, float(t1 - t0) / PROCESS_NODES])
+
+	for n in nodes:
+		n.free()
+
+func test_process_group():
+	# Nodes in the tree are processed by one _process_group call per frame
+	var nodes = []
+	for i in PROCESS_NODES:
+		var n = Node.new()
+		n.set_script(Sandbox_TestsProcessProcess)
+		add_child(n)
+		nodes.push_back(n)
+	assert_true(nodes[0].is_processing())
+
+	var process_calls = nodes[0].call("get_process_calls")
+	var group_calls = nodes[0].call("get_process_group_calls")
+	var t0 = Time.get_ticks_usec()
+	await get_tree().process_frame
+	var t1 = Time.get_ticks_usec()
+	await get_tree().process_frame
+
+	assert_eq(nodes[0].call("get_process_calls"), process_calls, "_process should not be called per node")
+	assert_eq(nodes[0].call("get_process_group_calls"), group_calls + 2)
+	for n in nodes:
+		assert_eq(n.get_meta("process_group_calls", 0), 2)
+	gut.p("_process_group on %d nodes: %dus per frame" % [PROCESS_NODES, t1 - t0])
+
+	for n in nodes:
+		n.free()
+
+func test_process_group_over_max_refs():
+	# The nodes of a group are handed over by the host, so they are not limited by max refs
+	var s = Sandbox.new()
+	var count = s.get_max_refs() + 1
+	s.free()
+	var nodes = []
+	for i in count:
+		var n = Node.new()
+		n.set_script(Sandbox_TestsProcessProcess)
+		add_child(n)
+		nodes.push_back(n)
+
+	await get_tree().process_frame
+	for n in nodes:
+		assert_eq(n.get_meta("process_group_calls", 0), 1)
+
+	for n in nodes:
+		n.free()
+
+const BATCH_SIZE = 10000
+
+func test_vmcall_batch():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+
+	# An Array of argument Arrays returns an Array of results
+	assert_eq(s.vmcall_batch("batch_add", [[1, 2], [3, 4], [5, 6]]), [3, 7, 11])
+	# Packed scalars are flattened tuples of the given arity
+	assert_eq(s.vmcall_batch("batch_add", PackedInt64Array([1, 2, 3, 4]), 2), PackedInt64Array([3, 7]))
+	assert_eq(s.vmcall_batch("batch_scale", PackedFloat32Array([1.0, 2.5]), 1), PackedFloat32Array([2.0, 5.0]))
+	# Mismatched arity is rejected
+	assert_eq(s.vmcall_batch("batch_add", PackedInt64Array([1, 2, 3]), 2), null)
+
+	var packed = PackedInt64Array()
+	for i in BATCH_SIZE:
+		packed.push_back(i)
+		packed.push_back(1)
+	var t0 = Time.get_ticks_usec()
+	var expected = []
+	for i in BATCH_SIZE:
+		expected.push_back(s.vmcall("batch_add", i, 1))
+	var t1 = Time.get_ticks_usec()
+	var results = s.vmcall_batch("batch_add", packed, 2)
+	var t2 = Time.get_ticks_usec()
+	assert_eq(Array(results), expected)
+	gut.p("%d calls: vmcall %dus, vmcall_batch %dus (%.1fx)" % [BATCH_SIZE, t1 - t0, t2 - t1, float(t1 - t0) / max(t2 - t1, 1)])
+
+	# The instruction limit applies to each element of the batch
+	var timeouts = s.get_timeouts()
+	s.set_instructions_max(1)
+	assert_eq(s.vmcall_batch("benchmark_fibonacci", PackedInt64Array([10, 40]), 1), null)
+	assert_eq(s.get_timeouts(), timeouts + 1)
+	s.queue_free()
+
+func test_profiler():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	# Nothing is collected until profiling is enabled
+	s.vmcall("benchmark_fibonacci", 10)
+	assert_eq(s.get_profile(), {})
+
+	s.profiling = true
+	for i in 100:
+		s.vmcall("benchmark_fibonacci", 15)
+	s.vmcall("batch_add", 1, 2)
+	var profile = s.get_profile()
+	assert_true(profile.has("benchmark_fibonacci"))
+	assert_true(profile.has("batch_add"))
+	var fib = profile["benchmark_fibonacci"]
+	assert_eq(fib["calls"], 100)
+	assert_eq(fib["exceptions"], 0)
+	assert_gt(fib["time"], 0.0)
+	assert_true(fib["p50"] <= fib["p95"] and fib["p95"] <= fib["p99"])
+	if not s.is_binary_translated() and not s.is_jit_compiled():
+		assert_gt(fib["instructions"], 100 * profile["batch_add"]["instructions"])
+	gut.p("benchmark_fibonacci(15): p50 %.1fus, p95 %.1fus, p99 %.1fus" % [fib["p50"] * 1e6, fib["p95"] * 1e6, fib["p99"] * 1e6])
+
+	# Disabling the profiler discards the profile
+	s.profiling = false
+	assert_eq(s.get_profile(), {})
+	s.queue_free()
+
+func test_sampling_profiler():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	if s.is_binary_translated():
+		s.queue_free()
+		pending("Translated code does not count instructions")
+		return
+	s.start_sampling(1000)
+	var expected = s.vmcall("benchmark_fibonacci", 20)
+	s.stop_sampling()
+	# Sampling must not change the result of the call
+	assert_eq(expected, 6765)
+	assert_gt(s.get_sample_count(), 0)
+	# Samples are taken by instruction count, so they are the same each run
+	var samples = s.get_sample_count()
+	s.start_sampling(1000)
+	s.vmcall("benchmark_fibonacci", 20)
+	assert_eq(s.get_sample_count(), samples)
+
+	assert_true(s.save_samples("user://test_samples.folded"))
+	var folded = FileAccess.get_file_as_string("user://test_samples.folded")
+	assert_true(folded.contains("benchmark_fibonacci"))
+	assert_true(s.save_samples("user://test_samples.json"))
+	var trace = JSON.parse_string(FileAccess.get_file_as_string("user://test_samples.json"))
+	assert_eq(trace["samples"].size(), samples)
+	s.queue_free()
+
+func test_syscall_tracing():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	s.vmcall("test_create_pa_f32")
+	assert_eq(s.get_syscall_trace(), {})
+
+	s.syscall_tracing = true
+	for i in 10:
+		assert_eq(s.vmcall("test_create_pa_f32"), PackedFloat32Array([1, 2, 3, 4]))
+	var trace = s.get_syscall_trace()
+	assert_true(trace.has("vcreate"))
+	assert_eq(trace["vcreate"]["calls"], 10)
+	assert_eq(trace["vcreate"]["bytes"], 10 * 4 * 4)
+	assert_gt(trace["vcreate"]["time"], 0.0)
+	assert_true(Sandbox.get_global_syscall_trace().has("vcreate"))
+
+	assert_true(s.save_syscall_trace("user://test_syscalls.json"))
+	var events = JSON.parse_string(FileAccess.get_file_as_string("user://test_syscalls.json"))["traceEvents"]
+	assert_gt(events.size(), 10)
+
+	# Disabling tracing keeps the trace, but stops adding to it
+	s.syscall_tracing = false
+	s.vmcall("test_create_pa_f32")
+	assert_eq(s.get_syscall_trace()["vcreate"]["calls"], 10)
+	s.queue_free()
+
+func test_syscall_costs():
+	var defaults = Sandbox.get_syscall_costs()
+	assert_true(defaults.has("vcreate"))
+	assert_true(defaults.has("obj"))
+	# Only system calls that are charged have a cost
+	assert_false(defaults.has("print"))
+
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+	if s.is_binary_translated():
+		s.queue_free()
+		pending("Translated code does not count instructions")
+		return
+	# Measure the speed of the guest, then the host time of each system call
+	s.profiling = true
+	s.vmcall("benchmark_fibonacci", 20)
+	var fib = s.get_profile()["benchmark_fibonacci"]
+	var instructions_per_second = fib["instructions"] / fib["time"]
+	s.syscall_tracing = true
+	for i in 200:
+		var data = PackedByteArray()
+		data.resize((i % 20) * 4096)
+		assert_eq(s.vmcall("syscall_copy", data).size(), data.size())
+	var costs = s.calibrate_syscall_costs(instructions_per_second)
+	assert_true(costs.has("vfetch"))
+	assert_gt(costs["vcreate"]["base"] + costs["vcreate"]["per_byte"], 0.0)
+	# Untraced system calls keep their cost
+	assert_eq(costs["obj"], defaults["obj"])
+	gut.p("vcreate: %d instructions + %.3f per byte" % [costs["vcreate"]["base"], costs["vcreate"]["per_byte"]])
+
+	assert_true(Sandbox.save_syscall_costs("user://test_syscall_costs.json"))
+	Sandbox.set_syscall_costs(defaults)
+	assert_eq(Sandbox.get_syscall_costs(), defaults)
+	assert_true(Sandbox.load_syscall_costs("user://test_syscall_costs.json"))
+	assert_eq(Sandbox.get_syscall_costs()["vfetch"]["base"], costs["vfetch"]["base"])
+	Sandbox.set_syscall_costs(defaults)
+	s.queue_free()
+
+func test_frame_budget():
+	var a = Sandbox.new()
+	a.set_program(Sandbox_TestsTests)
+	var b = Sandbox.new()
+	b.set_program(Sandbox_TestsTests)
+	b.frame_budget_weight = 3.0
+	assert_eq(a.get_frame_instruction_share(), 0, "No budget by default")
+
+	Sandbox.set_frame_instruction_budget(10)
+	assert_gt(a.get_frame_instruction_share(), 0)
+	assert_almost_eq(float(b.get_frame_instruction_share()) / a.get_frame_instruction_share(), 3.0, 0.01)
+
+	# A call that runs past the share of its sandbox is stopped, and later calls wait for the next frame
+	await get_tree().process_frame
+	var overruns = Sandbox.get_global_frame_budget_overruns()
+	assert_null(a.vmcall("benchmark_fibonacci", 35))
+	assert_eq(a.get_frame_budget_overruns(), 1)
+	assert_null(a.vmcall("test_ping_pong", 1))
+	assert_eq(a.get_frame_budget_overruns(), 2)
+	# Other sandboxes have their own share
+	assert_eq(b.vmcall("test_ping_pong", 2), 2)
+	assert_eq(Sandbox.get_global_frame_budget_overruns(), overruns + 2)
+
+	await get_tree().process_frame
+	assert_eq(a.vmcall("test_ping_pong", 3), 3)
+
+	Sandbox.set_frame_instruction_budget(0)
+	a.queue_free()
+	b.queue_free()
+
+func test_call_parallel():
+	var sandboxes = []
+	for i in 8:
+		var s = Sandbox.new()
+		s.set_program(Sandbox_TestsTests)
+		sandboxes.push_back(s)
+	var n2d = Node2D.new()
+	var expected = sandboxes[0].vmcall("benchmark_fibonacci", 20)
+
+	var results = Sandbox.call_parallel(sandboxes, "parallel_step", [n2d, 20])
+	assert_eq(results.size(), sandboxes.size())
+	for result in results:
+		assert_eq(result, expected)
+	# Scene changes are applied on the main thread after the calls
+	assert_eq(n2d.position, Vector2(20, 20))
+	for s in sandboxes:
+		assert_false(s.is_in_parallel_call())
+		assert_eq(s.get_exceptions(), 0)
+
+	# Sandboxes that can't be called get a null result
+	results = Sandbox.call_parallel([sandboxes[0], sandboxes[0], null], "parallel_step", [n2d, 10])
+	assert_eq(results, [55, null, null])
+
+	n2d.free()
+	for s in sandboxes:
+		s.queue_free()
+
+func test_parallel_map():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+
+	var data = PackedFloat32Array()
+	var expected = PackedFloat32Array()
+	for i in 1000:
+		data.push_back(i)
+		expected.push_back(i * 2)
+	# The last chunk is smaller than the others
+	var result = s.parallel_map("map_double", data, 64)
+	assert_eq(result, expected)
+	# The input is unchanged, and the forks are reused
+	assert_eq(data[999], 999.0)
+	assert_eq(s.parallel_map("map_double", data, 1000), expected)
+	assert_eq(s.parallel_map("map_double", PackedFloat32Array(), 64), PackedFloat32Array())
+
+	# Functions that don't return a packed array of the same type fail the map
+	assert_eq(s.parallel_map("map_count", data, 64), null)
+
+	s.queue_free()
+
+func test_vmcall_async():
+	var s = Sandbox.new()
+	s.set_program(Sandbox_TestsTests)
+
+	var handle = s.vmcall_async("benchmark_fibonacci", 20)
+	assert_gte(handle, 0)
+	assert_eq(s.get_async_calls_pending(), 1)
+	var finished = await s.async_call_finished
+	assert_eq(finished, [handle, 6765])
+	assert_eq(s.get_async_calls_pending(), 0)
+
+	# System calls that reach the scene are denied, and the call returns null
+	handle = s.vmcall_async("creates_a_node")
+	assert_gte(handle, 0)
+	finished = await s.async_call_finished
+	assert_eq(finished, [handle, null])
+
+	# Objects cannot be passed to async calls
+	var n2d = Node2D.new()
+	assert_eq(s.vmcall_async("parallel_step", n2d, 20), -1)
+	# Not even inside of containers, as a copy still refers to the same objects
+	assert_eq(s.vmcall_async("parallel_step", [n2d], 20), -1)
+	assert_eq(s.vmcall_async("parallel_step", {"node": n2d}, 20), -1)
+
+	n2d.free()
+	s.queue_free()